@@ -427,6 +427,8 @@ ALLEGRO_EVENT_SOURCE * create_menu(ALLEGRO_DISPLAY *display)
 //display message in middle of the screen when doing something that locks UI
 void display_only_status_message(string msg, VISSTATE *clientState)
 {
+	//headless (eg: save inspection from command line)
+	if (!clientState->maindisplay) return;
 	al_clear_to_color(al_col_black);
 	int textw = al_get_text_width(clientState->standardFont, msg.c_str());
 	int middlex = clientState->displaySize.width / 2 - textw / 2;
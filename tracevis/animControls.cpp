@@ -67,8 +67,8 @@ void AnimControls::setAnimState(int newAnimState)
 	if (newAnimState == ANIM_INACTIVE)
 	{
 		backJumpBtn->setVisibility(true);
-		backJumpBtn->setToolTipText("Unimplemented");
-		//backStepBtn->setVisibility(true); //disabled while unimplemented
+		backJumpBtn->setToolTipText("Jump animation back by specified steps");
+		backStepBtn->setVisibility(true);
 		forwardStepBtn->setVisibility(true);
 		forwardStepBtn->setToolTipText("Step animation forward by one");
 		forwardJumpBtn->setVisibility(true);
@@ -146,12 +146,6 @@ void AnimControls::update(thread_graph_data *graph)
 	if (graph->active)
 		displayBacklog(graph);
 		
-	if (graph->vertResizeIndex)
-	{
-		statusLabel->setText("(Rescaling graph...)");
-		return;
-	}
-
 	if (graph->basic) 
 	{ 
 		controlsLayout->setVisibility(false);
@@ -167,7 +161,7 @@ void AnimControls::update(thread_graph_data *graph)
 
 	stringstream stepInfo;
 
-	stepInfo << graph->animInstructionIndex << "/";
+	stepInfo << graph->replay.animInstructionIndex << "/";
 	if (graph->totalInstructions < 10000)
 		stepInfo << graph->totalInstructions - 1 << " instructions. ";
 	else if (graph->totalInstructions < 1000000)
@@ -177,17 +171,17 @@ void AnimControls::update(thread_graph_data *graph)
 
 	if (graph->loopCounter)//loops exist
 	{
-		if (graph->animLoopStartIdx) //in loop
+		if (graph->replay.looping) //in loop
 		{
 			if (!graph->active)
 				skipBtn->setVisibility(true);
-			stepInfo << "Iteration " << graph->loopIteration << "/" << graph->targetIterations << " of ";
+			stepInfo << "Iteration " << graph->replay.loopIteration << "/" << graph->replay.targetIterations << " of ";
 		}
 		else
 			skipBtn->setVisibility(false);
 
 		if (!graph->active)
-			stepInfo << graph->loopsPlayed << "/";
+			stepInfo << graph->replay.loopsPlayed << "/";
 		stepInfo << graph->loopCounter << " loops";
 	}
 
@@ -23,6 +23,9 @@ misrepresented as being the original source code.
 
 Ren Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+Altered for rgat: decoding uses a lookup table instead of searching the
+alphabet for each character and both directions write into a presized
+buffer. Output is unchanged.
 */
 
 #include "stdafx.h"
@@ -33,90 +36,93 @@ static const std::string base64_chars =
 "abcdefghijklmnopqrstuvwxyz"
 "0123456789+/";
 
-static inline bool is_base64(unsigned char c) {
-	return (isalnum(c) || (c == '+') || (c == '/'));
-}
+#define B64_INVALID 0xff
 
-std::string base64_decode(std::string const& encoded_string) {
-	int in_len = encoded_string.size();
-	int i = 0;
-	int j = 0;
-	int in_ = 0;
-	unsigned char char_array_4[4], char_array_3[3];
-	std::string ret;
+//maps each byte to its 6 bit value, B64_INVALID for padding and non alphabet chars
+struct B64_DECODE_TABLE {
+	unsigned char values[256];
+	B64_DECODE_TABLE() {
+		memset(values, B64_INVALID, sizeof(values));
+		for (unsigned char i = 0; i < 64; i++)
+			values[(unsigned char)base64_chars[i]] = i;
+	}
+};
+static const B64_DECODE_TABLE decodeTable;
 
-	while (in_len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-		char_array_4[i++] = encoded_string[in_]; in_++;
-		if (i == 4) {
-			for (i = 0; i <4; i++)
-				char_array_4[i] = base64_chars.find(char_array_4[i]);
+std::string base64_decode(std::string const& encoded_string) {
+	const unsigned char *in = reinterpret_cast<const unsigned char *>(encoded_string.data());
+	const unsigned char *table = decodeTable.values;
 
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+	//as before, decoding stops at the first '=' or non base64 character
+	size_t in_len = 0;
+	while (in_len < encoded_string.size() && table[in[in_len]] != B64_INVALID)
+		in_len++;
 
-			for (i = 0; (i < 3); i++)
-				ret += char_array_3[i];
-			i = 0;
-		}
+	std::string ret;
+	ret.resize((in_len / 4) * 3 + 3);
+	char *out = &ret[0];
+	size_t in_ = 0;
+	size_t out_ = 0;
+
+	for (; in_ + 4 <= in_len; in_ += 4) {
+		unsigned int group = (table[in[in_]] << 18) | (table[in[in_ + 1]] << 12) |
+			(table[in[in_ + 2]] << 6) | table[in[in_ + 3]];
+		out[out_++] = (char)(group >> 16);
+		out[out_++] = (char)(group >> 8);
+		out[out_++] = (char)group;
 	}
 
+	//trailing 2 or 3 characters give 1 or 2 bytes, a lone character gives none
+	size_t i = in_len - in_;
 	if (i) {
-		for (j = i; j <4; j++)
-			char_array_4[j] = 0;
-
-		for (j = 0; j <4; j++)
-			char_array_4[j] = base64_chars.find(char_array_4[j]);
+		unsigned int group = 0;
+		for (size_t j = 0; j < 4; j++)
+			group = (group << 6) | ((j < i) ? table[in[in_ + j]] : 0);
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-		char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-		for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+		for (size_t j = 0; j < i - 1; j++)
+			out[out_++] = (char)(group >> (16 - 8 * j));
 	}
 
+	ret.resize(out_);
 	return ret;
 }
 
 std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
 	std::string ret;
-	int i = 0;
-	int j = 0;
-	unsigned char char_array_3[3];
-	unsigned char char_array_4[4];
-
-	while (in_len--) {
-		char_array_3[i++] = *(bytes_to_encode++);
-		if (i == 3) {
-			char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-			char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-			char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-			char_array_4[3] = char_array_3[2] & 0x3f;
-
-			for (i = 0; (i <4); i++)
-				ret += base64_chars[char_array_4[i]];
-			i = 0;
-		}
+	ret.resize(((in_len + 2) / 3) * 4);
+	if (!in_len) return ret;
+
+	const char *chars = base64_chars.c_str();
+	char *out = &ret[0];
+	unsigned int i = 0;
+
+	for (; i + 3 <= in_len; i += 3) {
+		unsigned int group = (bytes_to_encode[i] << 16) | (bytes_to_encode[i + 1] << 8) | bytes_to_encode[i + 2];
+		*out++ = chars[(group >> 18) & 0x3f];
+		*out++ = chars[(group >> 12) & 0x3f];
+		*out++ = chars[(group >> 6) & 0x3f];
+		*out++ = chars[group & 0x3f];
 	}
 
-	if (i)
+	unsigned int remaining = in_len - i;
+	if (remaining)
 	{
-		for (j = i; j < 3; j++)
-			char_array_3[j] = '\0';
-
-		char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-		char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-		char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-		char_array_4[3] = char_array_3[2] & 0x3f;
-
-		for (j = 0; (j < i + 1); j++)
-			ret += base64_chars[char_array_4[j]];
-
-		while ((i++ < 3))
-			ret += '=';
-
+		unsigned int group = bytes_to_encode[i] << 16;
+		if (remaining == 2)
+			group |= bytes_to_encode[i + 1] << 8;
+
+		*out++ = chars[(group >> 18) & 0x3f];
+		*out++ = chars[(group >> 12) & 0x3f];
+		*out++ = (remaining == 2) ? chars[(group >> 6) & 0x3f] : '=';
+		*out++ = '=';
 	}
 
 	return ret;
+}
 
+bool base64_is_clean(std::string const& s, size_t start) {
+	for (size_t i = start; i < s.size(); i++)
+		if (decodeTable.values[(unsigned char)s[i]] == B64_INVALID && s[i] != '=')
+			return false;
+	return true;
 }
@@ -129,7 +129,6 @@ bool clientConfig::loadPreview()
 	int errorCount = 0;
 	argtoi(al_get_config_value(alConfig, "Preview", "EDGES_PER_FRAME"), &preview.edgesPerRender, &errorCount);
 	argtoi(al_get_config_value(alConfig, "Preview", "MS_BETWEEN_UPDATES"), &preview.processDelay, &errorCount);
-	argtoi(al_get_config_value(alConfig, "Preview", "MS_BETWEEN_GRAPHS"), &preview.threadDelay, &errorCount);
 	argtof(al_get_config_value(alConfig, "Preview", "SPIN_PER_FRAME"), &preview.spinPerFrame, &errorCount);
 	argtoi(al_get_config_value(alConfig, "Preview", "FPS"), &preview.FPS, &errorCount);
 	charstr_to_col(al_get_config_value(alConfig, "Preview", "HIGHLIGHT_ACTIVE_RGBA"), &preview.activeHighlight, &errorCount);
@@ -221,6 +220,9 @@ bool clientConfig::loadFromFile()
 	argtouni(al_get_config_value(alConfig, "Misc", "MAINGRAPH_UPDATE_FREQUENCY_MS"), &renderFrequency, &errorCount);
 	argtounl(al_get_config_value(alConfig, "Misc", "TRACE_BUFFER_MAX"), &traceBufMax, &errorCount);
 	argtouni(al_get_config_value(alConfig, "Misc", "DEFAULT_MAX_ARG_STORAGE"), &maxArgStorage, &errorCount);
+	int saveBuffersFlag = 0;
+	argtoi(al_get_config_value(alConfig, "Misc", "SAVE_RENDERED_BUFFERS"), &saveBuffersFlag, &errorCount);
+	saveRenderedBuffers = (saveBuffersFlag != 0);
 
 	if (!loadColours()) return false;
 	if (!loadPaths()) return false;
@@ -245,7 +247,6 @@ void clientConfig::savePreview()
 	al_add_config_section(alConfig, "Preview");
 	al_set_config_value(alConfig, "Preview", "EDGES_PER_FRAME", to_string(preview.edgesPerRender).c_str());
 	al_set_config_value(alConfig, "Preview", "MS_BETWEEN_UPDATES", to_string(preview.processDelay).c_str());
-	al_set_config_value(alConfig, "Preview", "MS_BETWEEN_GRAPHS", to_string(preview.threadDelay).c_str());
 	al_set_config_value(alConfig, "Preview", "SPIN_PER_FRAME", to_string(preview.spinPerFrame).c_str());
 	al_set_config_value(alConfig, "Preview", "FPS", to_string(preview.FPS).c_str());
 	al_set_config_value(alConfig, "Preview", "HIGHLIGHT_ACTIVE_RGBA", col_to_charstr(preview.activeHighlight));
@@ -257,7 +258,6 @@ void clientConfig::loadPreviewDefaults()
 {
 	preview.edgesPerRender = PREVIEW_EDGES_PER_RENDER;
 	preview.processDelay = PREVIEW_UPDATE_DELAY_MS;
-	preview.threadDelay = PREVIEW_DELAY_PER_GRAPH;
 	preview.spinPerFrame = PREVIEW_SPIN_PER_FRAME;
 	preview.FPS = PREVIEW_RENDER_FPS;
 	preview.activeHighlight = PREVIEW_ACTIVE_HIGHLIGHT;
@@ -380,6 +380,7 @@ void clientConfig::saveToFile()
 	al_set_config_value(alConfig, "Misc", "MAINGRAPH_UPDATE_FREQUENCY_MS", to_string(renderFrequency).c_str());
 	al_set_config_value(alConfig, "Misc", "TRACE_BUFFER_MAX", to_string(traceBufMax).c_str());
 	al_set_config_value(alConfig, "Misc", "DEFAULT_MAX_ARG_STORAGE", to_string(maxArgStorage).c_str());
+	al_set_config_value(alConfig, "Misc", "SAVE_RENDERED_BUFFERS", to_string((int)saveRenderedBuffers).c_str());
 
 	al_set_config_value(alConfig, "Paths", "SAVE_PATH", saveDir.c_str());
 	al_set_config_value(alConfig, "Paths", "DYNAMORIO_PATH", DRDir.c_str());
@@ -454,6 +455,7 @@ void clientConfig::loadDefaults()
 	renderFrequency = MAINGRAPH_DEFAULT_RENDER_FREQUENCY;
 	traceBufMax = DEFAULT_MAX_TRACE_BUFSIZE;
 	maxArgStorage = DEFAULT_MAX_ARG_STORAGE;
+	saveRenderedBuffers = DEFAULT_SAVE_RENDERED_BUFFERS;
 
 	loadDefaultColours();
 
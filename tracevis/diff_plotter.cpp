@@ -42,7 +42,7 @@ void diff_plotter::display_diff_summary(int x, int y, ALLEGRO_FONT *font, VISSTA
 {
 	stringstream infotxt1, infotxt2, infotxt3;
 
-	unsigned long maxBBs = max(graph1->bbsequence.size(), graph2->bbsequence.size());
+	unsigned long maxBBs = max(graph1->blockSequence->size(), graph2->blockSequence->size());
 	infotxt1 << "Green (PID: " << graph2->pid << " TID: " << graph2->tid <<
 		") Path: " << graph2->modPath << " (" << animIndex << " common block executions)";
 	infotxt2 << "Red+Green (PID:" << graph1->pid << " TID:" << graph1->tid <<
@@ -56,15 +56,15 @@ void diff_plotter::display_diff_summary(int x, int y, ALLEGRO_FONT *font, VISSTA
 bool diff_plotter::get_sequence_node(node_data **n1, node_data **n2)
 {
 	bool ignore = false;
-	pair<MEM_ADDRESS, int> targBlock_Size1 = graph1->bbsequence.at(animIndex);
-	BLOCK_IDENTIFIER blockID1 = graph1->mutationSequence.at(animIndex);
-	MEM_ADDRESS blockAddr1 = targBlock_Size1.first;
-	int numInstructions1 = targBlock_Size1.second;
+	const SEQUENCE_BLOCK *seqBlock1 = &graph1->blockSequence->block(animIndex);
+	BLOCK_IDENTIFIER blockID1 = seqBlock1->blockID;
+	MEM_ADDRESS blockAddr1 = seqBlock1->address;
+	int numInstructions1 = seqBlock1->insCount;
 
-	pair<MEM_ADDRESS, int> targBlock_Size2 = graph1->bbsequence.at(animIndex);
-	BLOCK_IDENTIFIER blockID2 = graph2->mutationSequence.at(animIndex);
-	MEM_ADDRESS blockAddr2 = targBlock_Size2.first;
-	int numInstructions2 = targBlock_Size2.second;
+	const SEQUENCE_BLOCK *seqBlock2 = &graph2->blockSequence->block(animIndex);
+	BLOCK_IDENTIFIER blockID2 = seqBlock2->blockID;
+	MEM_ADDRESS blockAddr2 = seqBlock2->address;
+	int numInstructions2 = seqBlock2->insCount;
 
 	if (numInstructions1 != numInstructions2)
 	{
@@ -76,19 +76,19 @@ bool diff_plotter::get_sequence_node(node_data **n1, node_data **n2)
 	{
 		blockIdx = 0;
 		++animIndex;
-		if (animIndex == graph1->bbsequence.size() || animIndex == graph2->bbsequence.size())
+		if (animIndex == graph1->blockSequence->size() || animIndex == graph2->blockSequence->size())
 		{
-			if (animIndex == graph1->bbsequence.size() && animIndex == graph2->bbsequence.size())
+			if (animIndex == graph1->blockSequence->size() && animIndex == graph2->blockSequence->size())
 				doneFlag = true;
 
 			return false;
 		}
-		targBlock_Size1 = graph1->bbsequence.at(animIndex);
-		blockID1 = graph1->mutationSequence.at(animIndex);
-		blockAddr1 = targBlock_Size1.first;
-		targBlock_Size2 = graph2->bbsequence.at(animIndex);
-		blockID2 = graph2->mutationSequence.at(animIndex);
-		blockAddr2 = targBlock_Size2.first;
+		seqBlock1 = &graph1->blockSequence->block(animIndex);
+		blockID1 = seqBlock1->blockID;
+		blockAddr1 = seqBlock1->address;
+		seqBlock2 = &graph2->blockSequence->block(animIndex);
+		blockID2 = seqBlock2->blockID;
+		blockAddr2 = seqBlock2->address;
 	}
 
 	INSLIST *block1 = getDisassemblyBlock(blockAddr1, blockID1, g1ProcessData, &ignore);
@@ -122,7 +122,7 @@ unsigned long diff_plotter::first_divering_edge()
 	bool ignore = false;
 	unsigned long animPosition = 0;
 	unsigned int prevVertIdx = 0;
-	while ((animPosition < graph1->bbsequence.size()) && (animPosition < graph2->bbsequence.size()))
+	while ((animPosition < graph1->blockSequence->size()) && (animPosition < graph2->blockSequence->size()))
 	{
 
 		if (!get_sequence_node(&g1Node, &g2Node)) break;
@@ -0,0 +1,121 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Byte ranges of vertex data changed since each opengl buffer was filled
+*/
+#include "stdafx.h"
+#include "dirty_ranges.h"
+#include <algorithm>
+#include <climits>
+
+static bool ends_before(const BYTE_RANGE &range, unsigned long position)
+{
+	return range.second < position;
+}
+
+//appends are the usual case and land at the end
+void dirty_ranges::mark(unsigned long start, unsigned long end)
+{
+	if (start >= end) return;
+
+	//first range that reaches start, then everything it now touches
+	vector<BYTE_RANGE>::iterator firstIt = std::lower_bound(ranges.begin(), ranges.end(), start, ends_before);
+	vector<BYTE_RANGE>::iterator lastIt = firstIt;
+	for (; lastIt != ranges.end() && lastIt->first <= end; ++lastIt)
+	{
+		start = min(start, lastIt->first);
+		end = max(end, lastIt->second);
+	}
+
+	firstIt = ranges.erase(firstIt, lastIt);
+	ranges.insert(firstIt, make_pair(start, end));
+
+	if (ranges.size() > DIRTY_MAX_RANGES)
+		merge_closest();
+}
+
+//uploads a few clean bytes to keep the range count down
+void dirty_ranges::merge_closest()
+{
+	size_t closest = 0;
+	unsigned long closestGap = ULONG_MAX;
+	for (size_t rangeIdx = 0; rangeIdx + 1 < ranges.size(); ++rangeIdx)
+	{
+		unsigned long gap = ranges[rangeIdx + 1].first - ranges[rangeIdx].second;
+		if (gap < closestGap)
+		{
+			closestGap = gap;
+			closest = rangeIdx;
+		}
+	}
+	ranges[closest].second = ranges[closest + 1].second;
+	ranges.erase(ranges.begin() + closest + 1);
+}
+
+void dirty_ranges::take(unsigned long limit, vector<BYTE_RANGE> *out)
+{
+	out->clear();
+	vector<BYTE_RANGE>::iterator rangeIt = ranges.begin();
+	for (; rangeIt != ranges.end() && rangeIt->first < limit; ++rangeIt)
+		out->push_back(make_pair(rangeIt->first, min(rangeIt->second, limit)));
+	discard(limit);
+}
+
+void dirty_ranges::discard(unsigned long limit)
+{
+	vector<BYTE_RANGE>::iterator rangeIt = ranges.begin();
+	for (; rangeIt != ranges.end() && rangeIt->second <= limit; ++rangeIt);
+	rangeIt = ranges.erase(ranges.begin(), rangeIt);
+	if (rangeIt != ranges.end() && rangeIt->first < limit)
+		rangeIt->first = limit;
+}
+
+void upload_tracker::mark(unsigned long start, unsigned long end)
+{
+	map<unsigned int, UPLOAD_TARGET>::iterator targetIt = targets.begin();
+	for (; targetIt != targets.end(); ++targetIt)
+		targetIt->second.dirty.mark(start, end);
+}
+
+//buffers grow to twice their size so appending doesn't resize them every upload
+bool upload_tracker::take(unsigned int buffer, unsigned long endByte, vector<BYTE_RANGE> *ranges,
+	unsigned long *newBufferBytes)
+{
+	UPLOAD_TARGET *target = &targets[buffer];
+	if (endByte <= target->bufferBytes)
+	{
+		target->dirty.take(endByte, ranges);
+		return false;
+	}
+
+	target->bufferBytes = max(endByte, target->bufferBytes * 2);
+	*newBufferBytes = target->bufferBytes;
+	target->dirty.discard(endByte);
+	ranges->assign(1, make_pair(0UL, endByte));
+	return true;
+}
+
+//buffers with no size are refilled from scratch on their next upload
+void upload_tracker::mark_all()
+{
+	map<unsigned int, UPLOAD_TARGET>::iterator targetIt = targets.begin();
+	for (; targetIt != targets.end(); ++targetIt)
+	{
+		targetIt->second.dirty.discard(ULONG_MAX);
+		targetIt->second.bufferBytes = 0;
+	}
+}
@@ -113,6 +113,15 @@ exeWindow::exeWindow(agui::Gui *widgets, VISSTATE *state, agui::Font *font)
 	pauseCB->setToolTipText("Pauses execution at program start with a message box to allow debugger attaching");
 	pauseCB->addCheckBoxListener(boxlistener);
 	exeFrame->add(pauseCB);
+
+	blockNodesCB = new agui::CheckBox;
+	blockNodesCB->setText("Block nodes");
+	blockNodesCB->setCheckBoxSize(CBSize);
+	blockNodesCB->resizeToContents();
+	blockNodesCB->setLocation(OPTS_X + 15, 165);
+	blockNodesCB->setToolTipText("Draw each basic block as one node instead of one node per instruction.\nMuch smaller graphs for large targets.");
+	blockNodesCB->addCheckBoxListener(boxlistener);
+	exeFrame->add(blockNodesCB);
 	
 	/*
 	debugCB = new agui::CheckBox;
@@ -0,0 +1,74 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Packed record of the blocks a thread executed, for animation and replay
+*/
+#include "stdafx.h"
+#include "execution_sequence.h"
+#include "OSspecific.h"
+
+BLOCK_HANDLE block_table::get_handle(MEM_ADDRESS address, BLOCK_IDENTIFIER blockID, unsigned int insCount)
+{
+	SEQUENCE_BLOCK_KEY key = make_pair(make_pair(address, blockID), insCount);
+
+	obtainMutex(tableMutex, 1059);
+	map<SEQUENCE_BLOCK_KEY, BLOCK_HANDLE>::iterator handleIt = handles.find(key);
+	if (handleIt != handles.end())
+	{
+		BLOCK_HANDLE handle = handleIt->second;
+		dropMutex(tableMutex);
+		return handle;
+	}
+
+	SEQUENCE_BLOCK block;
+	block.address = address;
+	block.blockID = blockID;
+	block.insCount = insCount;
+
+	BLOCK_HANDLE handle = blocks.size();
+	blocks.push_back(block);
+	handles.emplace(key, handle);
+	dropMutex(tableMutex);
+	return handle;
+}
+
+//published before its blocks, so any looped entry a reader sees has its record
+void execution_sequence::start_loop(unsigned long iterations)
+{
+	LOOP_RECORD loop;
+	loop.firstEntry = entries.size();
+	loop.iterations = iterations;
+	loops.push_back(loop);
+}
+
+pair<unsigned int, unsigned long> execution_sequence::loop_state(unsigned long seqIdx) const
+{
+	if (!(entries.at(seqIdx) & SEQUENCE_LOOPED))
+		return make_pair(0, NO_LOOP_ITERATIONS);
+
+	//last loop starting at or before the entry
+	unsigned long low = 0, high = loops.size();
+	while (high - low > 1)
+	{
+		unsigned long mid = low + (high - low) / 2;
+		if (loops.at(mid).firstEntry <= seqIdx)
+			low = mid;
+		else
+			high = mid;
+	}
+	return make_pair(low + 1, loops.at(low).iterations);
+}
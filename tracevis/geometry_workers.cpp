@@ -0,0 +1,104 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Pool of threads that build slices of vertex data
+*/
+#include "stdafx.h"
+#include "geometry_workers.h"
+
+struct GEOMETRY_WORKER {
+	HANDLE startEvent;
+	HANDLE doneEvent;
+	SLICE_WORK work;
+	void *context;
+	unsigned long first;
+	unsigned long last;
+};
+
+//started the first time a batch is big enough to need them, never exit
+static GEOMETRY_WORKER workers[MAXIMUM_WAIT_OBJECTS];
+static HANDLE doneEvents[MAXIMUM_WAIT_OBJECTS];
+static unsigned int workerCount = 0;
+static bool workersStarted = false;
+//held by the thread handing out slices
+static SRWLOCK workersLock = SRWLOCK_INIT;
+
+static DWORD __stdcall geometry_worker_loop(void *param)
+{
+	GEOMETRY_WORKER *worker = (GEOMETRY_WORKER *)param;
+	while (true)
+	{
+		WaitForSingleObject(worker->startEvent, INFINITE);
+		worker->work(worker->context, worker->first, worker->last);
+		SetEvent(worker->doneEvent);
+	}
+	return 0;
+}
+
+//one worker for every core but the caller's
+static void start_workers()
+{
+	workersStarted = true;
+
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	unsigned int wanted = min((unsigned int)sysInfo.dwNumberOfProcessors, (unsigned int)MAXIMUM_WAIT_OBJECTS + 1);
+	for (unsigned int workerIdx = 0; workerIdx + 1 < wanted; ++workerIdx)
+	{
+		GEOMETRY_WORKER *worker = &workers[workerCount];
+		worker->startEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		worker->doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		HANDLE hWorker = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)geometry_worker_loop,
+			(LPVOID)worker, 0, NULL);
+		if (!worker->startEvent || !worker->doneEvent || !hWorker)
+		{
+			cerr << "[rgat]WARNING: Only started " << workerCount << " geometry worker threads" << endl;
+			return;
+		}
+		CloseHandle(hWorker);
+		doneEvents[workerCount++] = worker->doneEvent;
+	}
+}
+
+void run_geometry_slices(unsigned long items, SLICE_WORK work, void *context, unsigned long minSlice)
+{
+	if (items < minSlice * 2 || !TryAcquireSRWLockExclusive(&workersLock))
+	{
+		work(context, 0, items);
+		return;
+	}
+
+	if (!workersStarted)
+		start_workers();
+
+	//caller takes the last slice
+	unsigned long slices = min((unsigned long)workerCount + 1, items / minSlice);
+	for (unsigned long sliceIdx = 0; sliceIdx + 1 < slices; ++sliceIdx)
+	{
+		GEOMETRY_WORKER *worker = &workers[sliceIdx];
+		worker->work = work;
+		worker->context = context;
+		worker->first = items * sliceIdx / slices;
+		worker->last = items * (sliceIdx + 1) / slices;
+		SetEvent(worker->startEvent);
+	}
+	work(context, items * (slices - 1) / slices, items);
+
+	if (slices > 1)
+		WaitForMultipleObjects(slices - 1, doneEvents, TRUE, INFINITE);
+	ReleaseSRWLockExclusive(&workersLock);
+}
@@ -27,7 +27,11 @@ GRAPH_DISPLAY_DATA::GRAPH_DISPLAY_DATA(bool prev)
 	if (prev) preview = true;
 	posmutex = CreateMutex(NULL, FALSE, NULL);
 	colmutex = CreateMutex(NULL, FALSE, NULL);
-	numVerts = 0;
+	for (unsigned int chunkIdx = 0; chunkIdx < DISPLAY_MAX_CHUNKS; ++chunkIdx)
+	{
+		posChunks[chunkIdx].store(0);
+		colChunks[chunkIdx].store(0);
+	}
 	edgesRendered = 0;
 }
 
@@ -35,33 +39,35 @@ GRAPH_DISPLAY_DATA::~GRAPH_DISPLAY_DATA()
 {
 	obtainMutex(colmutex, 9004);
 	obtainMutex(posmutex, 9005);
+	for (unsigned int chunkIdx = 0; chunkIdx < DISPLAY_MAX_CHUNKS; ++chunkIdx)
+	{
+		delete[] posChunks[chunkIdx].load();
+		delete[] colChunks[chunkIdx].load();
+	}
 }
 
 bool GRAPH_DISPLAY_DATA::get_coord(unsigned int index, FCOORD* result)
 {
-	const unsigned int listIndex = index*POSELEMS;
-	if (listIndex >= vposarray.size()) return false;
+	if (index >= get_numVerts()) return false;
+	GLfloat *pos = pos_at(index);
+	if (!pos) return false;
 
-	obtainMutex(posmutex, 1006);
-	result->x = vposarray.at(listIndex);
-	result->y = vposarray.at(listIndex + 1);
-	result->z = vposarray.at(listIndex + 2);
-	dropMutex(posmutex);
+	result->x = pos[0];
+	result->y = pos[1];
+	result->z = pos[2];
 	return true;
 }
 
-vector<float> *GRAPH_DISPLAY_DATA::acquire_pos(int holder)
+bool GRAPH_DISPLAY_DATA::acquire_pos(int holder)
 {
 	bool result = obtainMutex(posmutex, 1007);
 	//printf("holder %d got 1007 --- ", holder);
-	if (!result) return 0;
-	return &vposarray;
+	return result;
 }
 
-vector<float> *GRAPH_DISPLAY_DATA::acquire_col()
+void GRAPH_DISPLAY_DATA::acquire_col()
 {
 	obtainMutex(colmutex, 2000);
-	return &vcolarray;
 }
 
 void GRAPH_DISPLAY_DATA::release_pos()
@@ -74,17 +80,139 @@ void GRAPH_DISPLAY_DATA::release_col()
 	dropMutex(colmutex);
 }
 
-//TODO: this is awful. need to add to vector ert by vert
-//when number of verts increases also checks buffer sizes
+GLfloat *GRAPH_DISPLAY_DATA::run_at(CHUNKDIR &chunks, unsigned int elems, unsigned long vertIdx, unsigned long *runVerts)
+{
+	unsigned long offset;
+	unsigned int chunkIdx = display_chunk(vertIdx, &offset);
+	GLfloat *chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+	if (!chunk) return 0;
+	*runVerts = display_chunk_verts(chunkIdx) - offset;
+	return chunk + offset * elems;
+}
+
+//allocates chunks as needed, existing ones are reused after a reset
+unsigned long GRAPH_DISPLAY_DATA::append(CHUNKDIR &chunks, unsigned int elems, unsigned long written, 
+	const GLfloat *data, unsigned long verts)
+{
+	while (verts)
+	{
+		unsigned long offset;
+		unsigned int chunkIdx = display_chunk(written, &offset);
+		GLfloat *chunk = chunks[chunkIdx].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new GLfloat[display_chunk_verts(chunkIdx) * elems];
+			chunks[chunkIdx].store(chunk, std::memory_order_release);
+		}
+
+		unsigned long runVerts = min(verts, display_chunk_verts(chunkIdx) - offset);
+		std::copy(data, data + runVerts * elems, chunk + offset * elems);
+		data += runVerts * elems;
+		verts -= runVerts;
+		written += runVerts;
+	}
+	return written;
+}
+
+void GRAPH_DISPLAY_DATA::append_pos(const GLfloat *pos, unsigned long verts)
+{
+	mark_pos(posWritten, verts);
+	posWritten = append(posChunks, POSELEMS, posWritten, pos, verts);
+}
+
+void GRAPH_DISPLAY_DATA::append_col(const GLfloat *col, unsigned long verts)
+{
+	mark_col(colWritten, verts);
+	colWritten = append(colChunks, COLELEMS, colWritten, col, verts);
+}
+
+void GRAPH_DISPLAY_DATA::mark_pos(unsigned long firstVert, unsigned long verts)
+{
+	const unsigned long vertBytes = POSELEMS * sizeof(GLfloat);
+	posUploads.mark(firstVert * vertBytes, (firstVert + verts) * vertBytes);
+}
+
+void GRAPH_DISPLAY_DATA::mark_col(unsigned long firstVert, unsigned long verts)
+{
+	const unsigned long vertBytes = COLELEMS * sizeof(GLfloat);
+	colUploads.mark(firstVert * vertBytes, (firstVert + verts) * vertBytes);
+}
+
+bool GRAPH_DISPLAY_DATA::take_dirty(bool colours, unsigned int buffer, unsigned long verts,
+	vector<BYTE_RANGE> *ranges, unsigned long *newBufferBytes)
+{
+	bool resize;
+	if (colours)
+	{
+		acquire_col();
+		resize = colUploads.take(buffer, verts * COLELEMS * sizeof(GLfloat), ranges, newBufferBytes);
+		release_col();
+	}
+	else
+	{
+		acquire_pos();
+		resize = posUploads.take(buffer, verts * POSELEMS * sizeof(GLfloat), ranges, newBufferBytes);
+		release_pos();
+	}
+	return resize;
+}
+
+void GRAPH_DISPLAY_DATA::copy_out(CHUNKDIR &chunks, unsigned int elems, unsigned long written, vector<GLfloat> *out)
+{
+	out->resize(written * elems);
+	unsigned long vertIdx = 0, runVerts;
+	while (vertIdx < written)
+	{
+		GLfloat *run = run_at(chunks, elems, vertIdx, &runVerts);
+		runVerts = min(runVerts, written - vertIdx);
+		std::copy(run, run + runVerts * elems, out->begin() + vertIdx * elems);
+		vertIdx += runVerts;
+	}
+}
+
+void GRAPH_DISPLAY_DATA::copy_pos(vector<GLfloat> *out)
+{
+	acquire_pos();
+	copy_out(posChunks, POSELEMS, posWritten, out);
+	release_pos();
+}
+
+void GRAPH_DISPLAY_DATA::copy_col(vector<GLfloat> *out)
+{
+	acquire_col();
+	copy_out(colChunks, COLELEMS, colWritten, out);
+	release_col();
+}
+
+unsigned int GRAPH_DISPLAY_DATA::append_verts(const GLfloat *pos, const GLfloat *col, unsigned int verts)
+{
+	acquire_pos();
+	acquire_col();
+	unsigned int colIndex = colWritten * COLELEMS;
+	append_pos(pos, verts);
+	append_col(col, verts);
+	set_numVerts(get_numVerts() + verts);
+	release_col();
+	release_pos();
+	return colIndex;
+}
+
+void GRAPH_DISPLAY_DATA::mark_all()
+{
+	acquire_pos();
+	acquire_col();
+	mark_pos(0, posWritten);
+	mark_col(0, colWritten);
+	release_col();
+	release_pos();
+}
+
+//publishes vertices the caller has finished writing
 //mutexes are bit dodgy, expect them to be held by caller
 void GRAPH_DISPLAY_DATA::set_numVerts(unsigned int num)
 { 
 	assert(num >= numVerts);
-	numVerts = num;
-
-	posSize = numVerts * POSELEMS * sizeof(float);
-	colSize = numVerts * COLELEMS * sizeof(float);
-	vcolarraySize = vcolarray.size();
+	numVerts.store(num, std::memory_order_release);
 }
 
 //delete me if unused
@@ -97,15 +225,260 @@ void GRAPH_DISPLAY_DATA::clear()
 	release_pos();
 }
 
+//true if nothing was thrown away since gen was taken, call after reading
+bool GRAPH_DISPLAY_DATA::same_generation(unsigned int gen)
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return generation.load(std::memory_order_relaxed) == gen;
+}
+
+//chunks are about to be written over, readers from before this see a new generation
+//caller holds both locks
+void GRAPH_DISPLAY_DATA::discard_written()
+{
+	numVerts.store(0, std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_release);
+	posWritten = 0;
+	colWritten = 0;
+	edgesRendered = 0;
+}
+
 void GRAPH_DISPLAY_DATA::reset()
 {
 	acquire_pos(); 
 	acquire_col();
-	//needed? try without
-	vposarray.clear();
-	vcolarray.clear();
-	numVerts = 0;
-	edgesRendered = 0;
+	discard_written();
 	release_col();
 	release_pos();
-}
\ No newline at end of file
+}
+
+void GRAPH_DISPLAY_DATA::load_buffers(vector<GLfloat> *pos, vector<GLfloat> *col, unsigned int verts, unsigned int edges)
+{
+	acquire_pos();
+	acquire_col();
+	discard_written();
+	if (!pos->empty())
+		append_pos(&pos->at(0), pos->size() / POSELEMS);
+	if (!col->empty())
+		append_col(&col->at(0), col->size() / COLELEMS);
+	set_numVerts(verts);
+	edgesRendered = edges;
+	release_col();
+	release_pos();
+}
+
+PALETTE_LAYER::PALETTE_LAYER()
+{
+	colmutex = CreateMutex(NULL, FALSE, NULL);
+	for (unsigned int chunkIdx = 0; chunkIdx < DISPLAY_MAX_CHUNKS; ++chunkIdx)
+		chunks[chunkIdx].store(0);
+	memset(palette, 0, sizeof(palette));
+}
+
+PALETTE_LAYER::~PALETTE_LAYER()
+{
+	obtainMutex(colmutex, 9006);
+	for (unsigned int chunkIdx = 0; chunkIdx < DISPLAY_MAX_CHUNKS; ++chunkIdx)
+		delete[] chunks[chunkIdx].load();
+}
+
+void PALETTE_LAYER::acquire_col()
+{
+	obtainMutex(colmutex, 1066);
+}
+
+void PALETTE_LAYER::release_col()
+{
+	dropMutex(colmutex);
+}
+
+//every vertex using the colour changes, so buffers are refilled if it is different
+void PALETTE_LAYER::set_colour(unsigned char index, const GLfloat *rgba)
+{
+	unsigned char colour[COLELEMS];
+	for (unsigned int i = 0; i < COLELEMS; ++i)
+	{
+		float channel = min(max(rgba[i], 0.0f), 1.0f);
+		colour[i] = (unsigned char)(channel * 255 + 0.5);
+	}
+	if (memcmp(colour, palette[index], COLELEMS) == 0) return;
+
+	memcpy(palette[index], colour, COLELEMS);
+	uploads.mark_all();
+}
+
+unsigned char *PALETTE_LAYER::index_at(unsigned long vertIdx)
+{
+	unsigned long offset;
+	unsigned int chunkIdx = display_chunk(vertIdx, &offset);
+	unsigned char *chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+	return chunk ? chunk + offset : 0;
+}
+
+unsigned char *PALETTE_LAYER::index_run(unsigned long vertIdx, unsigned long *runVerts)
+{
+	unsigned long offset;
+	unsigned int chunkIdx = display_chunk(vertIdx, &offset);
+	unsigned char *chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+	if (!chunk) return 0;
+	*runVerts = display_chunk_verts(chunkIdx) - offset;
+	return chunk + offset;
+}
+
+void PALETTE_LAYER::append(unsigned char index, unsigned long verts)
+{
+	uploads.mark(written * PALETTE_VERT_BYTES, (written + verts) * PALETTE_VERT_BYTES);
+	while (verts)
+	{
+		unsigned long offset;
+		unsigned int chunkIdx = display_chunk(written, &offset);
+		unsigned char *chunk = chunks[chunkIdx].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new unsigned char[display_chunk_verts(chunkIdx)];
+			chunks[chunkIdx].store(chunk, std::memory_order_release);
+		}
+
+		unsigned long runVerts = min(verts, display_chunk_verts(chunkIdx) - offset);
+		memset(chunk + offset, index, runVerts);
+		verts -= runVerts;
+		written += runVerts;
+	}
+}
+
+void PALETTE_LAYER::fill(unsigned long firstVert, unsigned long verts, unsigned char index)
+{
+	unsigned long endVert = min(firstVert + verts, written);
+	if (firstVert < endVert)
+		uploads.mark(firstVert * PALETTE_VERT_BYTES, endVert * PALETTE_VERT_BYTES);
+	unsigned long runVerts;
+	while (firstVert < endVert)
+	{
+		unsigned char *run = index_run(firstVert, &runVerts);
+		runVerts = min(runVerts, endVert - firstVert);
+		memset(run, index, runVerts);
+		firstVert += runVerts;
+	}
+}
+
+void PALETTE_LAYER::replace(vector<unsigned char> *indices, unsigned int edges)
+{
+	discard_written();
+	unsigned long verts = indices->size();
+	uploads.mark(0, verts * PALETTE_VERT_BYTES);
+	unsigned long vertIdx = 0;
+	while (vertIdx < verts)
+	{
+		unsigned long offset;
+		unsigned int chunkIdx = display_chunk(vertIdx, &offset);
+		unsigned char *chunk = chunks[chunkIdx].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new unsigned char[display_chunk_verts(chunkIdx)];
+			chunks[chunkIdx].store(chunk, std::memory_order_release);
+		}
+
+		unsigned long runVerts = min(verts - vertIdx, display_chunk_verts(chunkIdx) - offset);
+		memcpy(chunk + offset, &indices->at(vertIdx), runVerts);
+		vertIdx += runVerts;
+	}
+	written = verts;
+	set_numVerts(verts);
+	edgesRendered = edges;
+}
+
+void PALETTE_LAYER::mark_all()
+{
+	acquire_col();
+	uploads.mark(0, written * PALETTE_VERT_BYTES);
+	release_col();
+}
+
+bool PALETTE_LAYER::take_dirty(unsigned int buffer, unsigned long verts,
+	vector<BYTE_RANGE> *ranges, unsigned long *newBufferBytes)
+{
+	acquire_col();
+	bool resize = uploads.take(buffer, verts * PALETTE_VERT_BYTES, ranges, newBufferBytes);
+	release_col();
+	return resize;
+}
+
+void PALETTE_LAYER::expand(const unsigned char *indices, unsigned long verts, unsigned char *out)
+{
+	const unsigned char *indicesEnd = indices + verts;
+	for (; indices != indicesEnd; ++indices, out += COLELEMS)
+		memcpy(out, palette[*indices], COLELEMS);
+}
+
+void PALETTE_LAYER::copy_col(vector<GLfloat> *out)
+{
+	acquire_col();
+	out->resize(written * COLELEMS);
+	vector<GLfloat>::iterator outIt = out->begin();
+	unsigned long vertIdx = 0, runVerts;
+	while (vertIdx < written)
+	{
+		unsigned char *run = index_run(vertIdx, &runVerts);
+		runVerts = min(runVerts, written - vertIdx);
+		for (unsigned long i = 0; i < runVerts; ++i)
+			for (unsigned int elem = 0; elem < COLELEMS; ++elem)
+				*outIt++ = (GLfloat)palette[run[i]][elem] / 255;
+		vertIdx += runVerts;
+	}
+	release_col();
+}
+
+bool PALETTE_LAYER::load_colours(vector<GLfloat> *col, unsigned int verts, unsigned int edges)
+{
+	acquire_col();
+	discard_written();
+
+	//give each distinct colour a palette entry as it turns up
+	map<vector<GLfloat>, unsigned int> colourIndexes;
+	for (unsigned long colIdx = 0; colIdx + COLELEMS <= col->size(); colIdx += COLELEMS)
+	{
+		vector<GLfloat> colour(col->begin() + colIdx, col->begin() + colIdx + COLELEMS);
+		map<vector<GLfloat>, unsigned int>::iterator colourIt = colourIndexes.find(colour);
+		if (colourIt == colourIndexes.end())
+		{
+			if (colourIndexes.size() == PALETTE_MAX_COLOURS)
+			{
+				written = 0;
+				release_col();
+				return false;
+			}
+			set_colour(colourIndexes.size(), &colour.at(0));
+			colourIt = colourIndexes.emplace(colour, colourIndexes.size()).first;
+		}
+		append(colourIt->second, 1);
+	}
+
+	set_numVerts(min((unsigned long)verts, written));
+	edgesRendered = edges;
+	release_col();
+	return true;
+}
+
+bool PALETTE_LAYER::same_generation(unsigned int gen)
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return generation.load(std::memory_order_relaxed) == gen;
+}
+
+//caller holds the lock
+void PALETTE_LAYER::discard_written()
+{
+	numVerts.store(0, std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_release);
+	written = 0;
+	edgesRendered = 0;
+}
+
+void PALETTE_LAYER::reset()
+{
+	acquire_col();
+	discard_written();
+	release_col();
+}
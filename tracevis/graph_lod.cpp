@@ -0,0 +1,247 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Coarser versions of a graph for drawing when zoomed out
+*/
+#include "stdafx.h"
+#include "graph_lod.h"
+#include "GUIConstants.h"
+#include "traceConstants.h"
+
+//node not reached by any edge added yet
+#define LOD_UNASSIGNED 0xffffffff
+
+graph_lod::graph_lod()
+{
+	lodnodes = new GRAPH_DISPLAY_DATA();
+	lodlines = new GRAPH_DISPLAY_DATA();
+}
+
+graph_lod::~graph_lod()
+{
+	delete lodnodes;
+	delete lodlines;
+}
+
+int graph_lod::level_for_zoom(float zmul, unsigned int numNodes)
+{
+	if (numNodes < LOD_MIN_NODES) return LOD_NONE;
+	if (zmul >= LOD_MODULE_ZOOMFACTOR) return LOD_MODULE;
+	if (zmul >= LOD_FUNCTION_ZOOMFACTOR) return LOD_FUNCTION;
+	if (zmul >= LOD_BLOCK_ZOOMFACTOR) return LOD_BLOCK;
+	return LOD_NONE;
+}
+
+bool graph_lod::is_assigned(LOD_LEVEL *level, unsigned int nodeIdx)
+{
+	return nodeIdx < level->nodeGroups.size() && level->nodeGroups[nodeIdx] != LOD_UNASSIGNED;
+}
+
+void graph_lod::join_group(LOD_LEVEL *level, unsigned int nodeIdx, unsigned int groupIdx)
+{
+	if (nodeIdx >= level->nodeGroups.size())
+		level->nodeGroups.resize(nodeIdx + 1, LOD_UNASSIGNED);
+	level->nodeGroups[nodeIdx] = groupIdx;
+}
+
+void graph_lod::add_node_group(LOD_LEVEL *level, unsigned int nodeIdx)
+{
+	LOD_GROUP group;
+	group.representative = nodeIdx;
+	level->groups.push_back(group);
+	join_group(level, nodeIdx, level->groups.size() - 1);
+	level->geometryDirty = true;
+}
+
+void graph_lod::group_module(node_data *n)
+{
+	LOD_LEVEL *modules = &levels[LOD_MODULE];
+	map<int, unsigned int>::iterator moduleIt = moduleGroups.find(n->nodeMod);
+	if (moduleIt != moduleGroups.end())
+		join_group(modules, n->index, moduleIt->second);
+	else
+	{
+		moduleGroups.emplace(n->nodeMod, modules->groups.size());
+		add_node_group(modules, n->index);
+	}
+}
+
+//nodes are grouped by the first edge that reaches them
+void graph_lod::group_target(edge_data *e, node_data *source, node_data *target)
+{
+	INS_DATA *sourceIns = source->external ? 0 : source->ins;
+	INS_DATA *targetIns = target->external ? 0 : target->ins;
+
+	//whatever arrives at the instruction after a call is back in the caller
+	LOD_LEVEL *functions = &levels[LOD_FUNCTION];
+	if (sourceIns && sourceIns->itype == OPCALL)
+		returnGroups[sourceIns->address + sourceIns->numbytes] = functions->nodeGroups.at(source->index);
+
+	//levels are assigned together
+	if (is_assigned(&levels[LOD_BLOCK], target->index)) return;
+
+	LOD_LEVEL *blocks = &levels[LOD_BLOCK];
+	if (sourceIns && targetIns && sourceIns->itype == OPUNDEF &&
+		(e->edgeClass == INEW || e->edgeClass == IOLD) &&
+		targetIns->address == sourceIns->address + sourceIns->numbytes)
+		join_group(blocks, target->index, blocks->nodeGroups.at(source->index));
+	else
+		add_node_group(blocks, target->index);
+
+	if (target->external || e->edgeClass == ICALL || e->edgeClass == IEXCEPT)
+		add_node_group(functions, target->index);
+	else if (e->edgeClass == IRET || source->external)
+	{
+		map<MEM_ADDRESS, unsigned int>::iterator returnIt = targetIns ?
+			returnGroups.find(targetIns->address) : returnGroups.end();
+		if (returnIt != returnGroups.end())
+			join_group(functions, target->index, returnIt->second);
+		else
+			add_node_group(functions, target->index);
+	}
+	else
+		join_group(functions, target->index, functions->nodeGroups.at(source->index));
+
+	group_module(target);
+}
+
+void graph_lod::add_lod_edge(LOD_LEVEL *level, edge_data *e, unsigned int sourceIdx, unsigned int targetIdx)
+{
+	NODEPAIR groupPair = make_pair(level->nodeGroups.at(sourceIdx), level->nodeGroups.at(targetIdx));
+	if (groupPair.first == groupPair.second)
+	{
+		level->memberEdges.push_back(LOD_INTERNAL_EDGE);
+		return;
+	}
+
+	map<NODEPAIR, unsigned int>::iterator edgeIt = level->edgeIndexes.find(groupPair);
+	if (edgeIt == level->edgeIndexes.end())
+	{
+		LOD_EDGE lodEdge;
+		lodEdge.source = groupPair.first;
+		lodEdge.target = groupPair.second;
+		lodEdge.edgeClass = e->edgeClass;
+		lodEdge.weight = 0;
+		edgeIt = level->edgeIndexes.emplace(groupPair, level->edges.size()).first;
+		level->edges.push_back(lodEdge);
+		level->geometryDirty = true;
+	}
+	level->memberEdges.push_back(edgeIt->second);
+}
+
+void graph_lod::add_edge(edge_data *e, node_data *source, node_data *target)
+{
+	//the first node of a trace has nothing leading to it
+	if (!is_assigned(&levels[LOD_BLOCK], source->index))
+	{
+		add_node_group(&levels[LOD_BLOCK], source->index);
+		add_node_group(&levels[LOD_FUNCTION], source->index);
+		group_module(source);
+	}
+
+	group_target(e, source, target);
+
+	graphEdges.push_back(e);
+	for (int levelIdx = 0; levelIdx < LOD_LEVELS; ++levelIdx)
+		add_lod_edge(&levels[levelIdx], e, source->index, target->index);
+}
+
+void graph_lod::positions_changed()
+{
+	for (int levelIdx = 0; levelIdx < LOD_LEVELS; ++levelIdx)
+		levels[levelIdx].geometryDirty = true;
+}
+
+void graph_lod::counts_changed(unsigned long countUpdates)
+{
+	if (countUpdates == seenCountUpdates) return;
+	DWORD64 now = GetTickCount64();
+	if (now < lastCountRefresh + LOD_COUNT_REFRESH_MS) return;
+
+	lastCountRefresh = now;
+	seenCountUpdates = countUpdates;
+	for (int levelIdx = 0; levelIdx < LOD_LEVELS; ++levelIdx)
+		levels[levelIdx].geometryDirty = true;
+}
+
+//one point per group, one line per pair of connected groups. busier edges are more opaque
+bool graph_lod::build_geometry(int level, GRAPH_DISPLAY_DATA *mainnodes, map<int, ALLEGRO_COLOR> *lineColours)
+{
+	if (level == LOD_NONE) return false;
+	LOD_LEVEL *lod = &levels[level];
+	unsigned int nodesGeneration = mainnodes->get_generation();
+	if (level == builtLevel && !lod->geometryDirty && nodesGeneration == builtNodesGeneration) return false;
+
+	//executions keep changing after an edge is added, so sum them again for each build
+	vector<LOD_EDGE>::iterator lodEdgeIt = lod->edges.begin();
+	for (; lodEdgeIt != lod->edges.end(); ++lodEdgeIt)
+		lodEdgeIt->weight = 0;
+	for (unsigned long edgeIdx = 0; edgeIdx < graphEdges.size(); ++edgeIdx)
+	{
+		unsigned int lodEdgeIdx = lod->memberEdges[edgeIdx];
+		if (lodEdgeIdx != LOD_INTERNAL_EDGE)
+			lod->edges[lodEdgeIdx].weight += graphEdges[edgeIdx]->executionCount;
+	}
+	unsigned long maxWeight = 0;
+	for (lodEdgeIt = lod->edges.begin(); lodEdgeIt != lod->edges.end(); ++lodEdgeIt)
+		maxWeight = max(maxWeight, lodEdgeIt->weight);
+
+	unsigned int drawnNodes = mainnodes->get_numVerts();
+	vector<GLfloat> nodePos, nodeCol;
+	nodePos.reserve(lod->groups.size() * POSELEMS);
+	nodeCol.reserve(lod->groups.size() * COLELEMS);
+	vector<LOD_GROUP>::iterator groupIt = lod->groups.begin();
+	for (; groupIt != lod->groups.end(); ++groupIt)
+	{
+		if (groupIt->representative >= drawnNodes) continue;
+		GLfloat *pos = mainnodes->pos_at(groupIt->representative);
+		GLfloat *col = mainnodes->col_at(groupIt->representative);
+		nodePos.insert(nodePos.end(), pos, pos + POSELEMS);
+		nodeCol.insert(nodeCol.end(), col, col + COLELEMS);
+	}
+
+	vector<GLfloat> linePos, lineCol;
+	linePos.reserve(lod->edges.size() * 2 * POSELEMS);
+	lineCol.reserve(lod->edges.size() * 2 * COLELEMS);
+	float logMaxWeight = log((float)maxWeight + 1);
+	for (lodEdgeIt = lod->edges.begin(); lodEdgeIt != lod->edges.end(); ++lodEdgeIt)
+	{
+		unsigned int sourceNode = lod->groups[lodEdgeIt->source].representative;
+		unsigned int targetNode = lod->groups[lodEdgeIt->target].representative;
+		if (sourceNode >= drawnNodes || targetNode >= drawnNodes) continue;
+
+		GLfloat *sourcePos = mainnodes->pos_at(sourceNode);
+		GLfloat *targetPos = mainnodes->pos_at(targetNode);
+		linePos.insert(linePos.end(), sourcePos, sourcePos + POSELEMS);
+		linePos.insert(linePos.end(), targetPos, targetPos + POSELEMS);
+
+		ALLEGRO_COLOR *edgeColour = &lineColours->at(lodEdgeIt->edgeClass);
+		float alpha = 1;
+		if (logMaxWeight > 0)
+			alpha = 0.2 + 0.8 * (log((float)lodEdgeIt->weight + 1) / logMaxWeight);
+		GLfloat edgeColArr[COLELEMS] = { edgeColour->r, edgeColour->g, edgeColour->b, alpha };
+		lineCol.insert(lineCol.end(), edgeColArr, edgeColArr + COLELEMS);
+		lineCol.insert(lineCol.end(), edgeColArr, edgeColArr + COLELEMS);
+	}
+
+	lodnodes->load_buffers(&nodePos, &nodeCol, nodePos.size() / POSELEMS, 0);
+	lodlines->load_buffers(&linePos, &lineCol, linePos.size() / POSELEMS, linePos.size() / (2 * POSELEMS));
+	lod->geometryDirty = false;
+	builtLevel = level;
+	builtNodesGeneration = nodesGeneration;
+	return true;
+}
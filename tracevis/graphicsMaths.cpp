@@ -22,6 +22,7 @@ Sphere coordinate processing functions
 #include "GUIConstants.h"
 #include "graphicsMaths.h"
 #include "traceStructs.h"
+#include "geometry_workers.h"
 
 //returns a small number indicating rough zoom
 float zoomFactor(long cameraZoom, long sphereSize)
@@ -63,6 +64,111 @@ void sphereCoord(int ia, float b, FCOORD *c, MULTIPLIERS *dimensions, float diam
 	c->z = r * sinb * sin((a*M_PI) / 180);
 }
 
+static void build_axis_trig(int low, int high, float degreesPerStep, float offset, AXIS_TRIG *table)
+{
+	table->low = low;
+	table->sinv.resize(high - low + 1);
+	table->cosv.resize(high - low + 1);
+	for (int step = low; step <= high; ++step)
+	{
+		float radians = ((step * degreesPerStep + offset) * M_PI) / 180;
+		table->sinv[step - low] = sin(radians);
+		table->cosv[step - low] = cos(radians);
+	}
+}
+
+/*
+coords are small integers that repeat a lot, so rather than trig for every coord
+look up the a, b and bMod angles in tables built for this batch
+the b angle is b + bMod, put back together with the angle sum identities
+*/
+void plan_sphere_coords(const VCOORD *coords, unsigned long count, MULTIPLIERS *dimensions,
+	float diamModifier, SPHERE_BATCH *batch)
+{
+	batch->dimensions = dimensions;
+	batch->diamModifier = diamModifier;
+	batch->sparse = true;
+	if (!count) return;
+
+	int lowA = coords[0].a, highA = coords[0].a;
+	int lowB = coords[0].b, highB = coords[0].b;
+	int lowM = coords[0].bMod, highM = coords[0].bMod;
+	for (unsigned long i = 1; i < count; ++i)
+	{
+		lowA = min(lowA, coords[i].a); highA = max(highA, coords[i].a);
+		lowB = min(lowB, coords[i].b); highB = max(highB, coords[i].b);
+		lowM = min(lowM, coords[i].bMod); highM = max(highM, coords[i].bMod);
+	}
+
+	//sparse coords, tables would cost more than they save
+	unsigned long tableSize = (unsigned long)(highA - lowA) + (highB - lowB) + (highM - lowM) + 3;
+	if (tableSize > count * 3) return;
+
+	batch->sparse = false;
+	build_axis_trig(lowA, highA, dimensions->HEDGESEP, 0, &batch->aTrig);
+	build_axis_trig(lowB, highB, dimensions->VEDGESEP, BAdj, &batch->bTrig);
+	build_axis_trig(lowM, highM, float(BMODMAG * dimensions->VEDGESEP), 0, &batch->mTrig);
+}
+
+void project_sphere_coords(SPHERE_BATCH *batch, const VCOORD *coords, unsigned long count, GLfloat *positions)
+{
+	if (batch->sparse)
+	{
+		FCOORD result;
+		for (unsigned long i = 0; i < count; ++i, positions += POSELEMS)
+		{
+			float adjB = coords[i].b + float(coords[i].bMod * BMODMAG);
+			sphereCoord(coords[i].a, adjB, &result, batch->dimensions, batch->diamModifier);
+			positions[XOFF] = result.x;
+			positions[YOFF] = result.y;
+			positions[ZOFF] = result.z;
+		}
+		return;
+	}
+
+	AXIS_TRIG *aTrig = &batch->aTrig, *bTrig = &batch->bTrig, *mTrig = &batch->mTrig;
+	float r = (batch->dimensions->radius + batch->diamModifier);
+	for (unsigned long i = 0; i < count; ++i, positions += POSELEMS)
+	{
+		const VCOORD *coord = &coords[i];
+		unsigned int aIdx = coord->a - aTrig->low;
+		unsigned int bIdx = coord->b - bTrig->low;
+		unsigned int mIdx = coord->bMod - mTrig->low;
+
+		float sinb = bTrig->sinv[bIdx] * mTrig->cosv[mIdx] + bTrig->cosv[bIdx] * mTrig->sinv[mIdx];
+		float cosb = bTrig->cosv[bIdx] * mTrig->cosv[mIdx] - bTrig->sinv[bIdx] * mTrig->sinv[mIdx];
+		positions[XOFF] = r * sinb * aTrig->cosv[aIdx];
+		positions[YOFF] = r * cosb;
+		positions[ZOFF] = r * sinb * aTrig->sinv[aIdx];
+	}
+}
+
+struct SPHERE_SLICES {
+	SPHERE_BATCH *batch;
+	const VCOORD *coords;
+	GLfloat *positions;
+};
+
+static void sphere_coords_slice(void *context, unsigned long first, unsigned long last)
+{
+	SPHERE_SLICES *slices = (SPHERE_SLICES *)context;
+	project_sphere_coords(slices->batch, slices->coords + first, last - first,
+		slices->positions + first * POSELEMS);
+}
+
+//tables are built once for the whole batch so each slice gets the same numbers
+void sphereCoords(const VCOORD *coords, unsigned long count, GLfloat *positions, MULTIPLIERS *dimensions, float diamModifier)
+{
+	SPHERE_BATCH batch;
+	plan_sphere_coords(coords, count, dimensions, diamModifier, &batch);
+
+	SPHERE_SLICES slices;
+	slices.batch = &batch;
+	slices.coords = coords;
+	slices.positions = positions;
+	run_geometry_slices(count, sphere_coords_slice, &slices);
+}
+
 //take coord in space, convert back to a/b
 void sphereAB(FCOORD *c, float *a, float *b, MULTIPLIERS *mults)
 {
@@ -128,41 +234,6 @@ void bezierPT(FCOORD *startC, FCOORD *bezierC, FCOORD *endC, int pointnum, int t
 	resultC->z = ((1 - t) * (1 - t) * startC->z + 2 * (1 - t) * t * bezierC->z + t * t * endC->z);
 }
 
-/*
-input: an 'a' coordinate, left and right columns of screen, horiz separation
-return: if coord is within those columns
-only as accurate as the inaccurate mystery constant
-
-TODO: come up with a way of deriving row 'b' from a given coordinate
-then we can improve performance even more by looking at the top and bottom rows
-instead of getting everything in the column
-
-Graph tends to not have much per column though so this isn't a desperate requirement
-*/
-bool a_coord_on_screen(int a, int leftcol, int rightcol, float hedgesep)
-{
-	/* the idea here is to calculate the column of the given coordinate
-	   dunno how though!
-	   FIX ME - to fix text display
-	*/
-									//bad bad bad bad bad bad bad... but close. gets worse the wider the graph is
-	int coordcolumn = floor(-a / (COLOUR_PICKING_MYSTERY_CONSTANTA / hedgesep));
-	coordcolumn = coordcolumn % ADIVISIONS;
-
-	if (leftcol > rightcol)
-	{
-		int shifter = ADIVISIONS - leftcol;
-		leftcol = 0;
-		rightcol += shifter;
-		coordcolumn += shifter;
-	}
-
-	//this code is horrendous and doesn't fix it and ugh
-	int stupidHack = 1;
-	if ((coordcolumn >= leftcol) && (coordcolumn <= (rightcol+stupidHack))) return true;
-	else return false;
-}
-
 //returns if the coord is present on the screen
 bool is_on_screen(DCOORD * screenCoord, void *clientState)
 {
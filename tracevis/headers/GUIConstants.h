@@ -20,20 +20,6 @@ Lots of GUI related constants
 
 #pragma once
 
-//more divisions = smoother curves
-#define ADIVISIONS 32
-#define BDIVISIONS 16
-
-/*
-don't know, please figure out how to derive properly.
-I derived this by making the colpick sphere permenant and 
-looking at the column of example verts at given h_edge_seps
-eg: 
-coord -8a is between col 0 and 1 at h_edge_sep ~1.39. 1.39*8 = 11.12
-coord -14a is between col 0 and 1 at h_edge_sep ~0.8. 0.8*14 = 11.2
-*/
-#define COLOUR_PICKING_MYSTERY_CONSTANTA 11.16
-
 #define al_col_red al_map_rgb(255, 0, 0)
 #define al_col_green al_map_rgb(0, 255, 0)
 #define al_col_white al_map_rgb(255, 255, 255)
@@ -87,10 +73,6 @@ coord -14a is between col 0 and 1 at h_edge_sep ~0.8. 0.8*14 = 11.2
 #define WFPOSBUFSIZE WIREFRAMELOOPS * WF_POINTSPERLINE * POSELEMS * sizeof(GLfloat)
 #define WFCOLBUFSIZE WIREFRAMELOOPS * WF_POINTSPERLINE * COLELEMS * sizeof(GLfloat)
 
-#define VERTSPERQUAD 4
-#define COL_SPHERE_VERTS ((180 / BDIVISIONS)-2)*(WF_POINTSPERLINE/2)*VERTSPERQUAD
-#define COL_SPHERE_BUFSIZE COL_SPHERE_VERTS*POSELEMS*sizeof(float)
-
 #define M_PI acos(-1.0)
 #define DEGREESMUL float(180 / M_PI)
 
@@ -137,9 +119,14 @@ coord -14a is between col 0 and 1 at h_edge_sep ~0.8. 0.8*14 = 11.2
 
 //number of divisions of long curve. More = smoother, worse(?) performance
 #define LONGCURVEPTS 32
+//points evaluated along a long curve, and the GL_LINES vertices drawing it
+#define LONGCURVESEGS ((LONGCURVEPTS + 2) / 2)
+#define LONGCURVEVERTS (LONGCURVESEGS * 2 + 2)
 
 #define DEFAULTPOINTSIZE 5
 #define PREVIEW_POINT_SIZE 5
+//edges the preview thread renders each update, shared between graphs by how far behind they are
+#define PREVIEW_EDGES_PER_TICK 10000
 
 #define BMODMAG  0.55
 #define BAdj 35
@@ -147,6 +134,14 @@ coord -14a is between col 0 and 1 at h_edge_sep ~0.8. 0.8*14 = 11.2
 #define INITIALZOOM 80000
 #define EXTERN_VISIBLE_ZOOM_FACTOR 25
 #define INSTEXT_VISIBLE_ZOOMFACTOR 7
+//zoom factors past which big graphs are drawn as blocks/functions/modules
+#define LOD_BLOCK_ZOOMFACTOR 100
+#define LOD_FUNCTION_ZOOMFACTOR 200
+#define LOD_MODULE_ZOOMFACTOR 400
+//graphs smaller than this are always drawn in full
+#define LOD_MIN_NODES 10000
+//least time between rebuilds of a level for changed execution counts
+#define LOD_COUNT_REFRESH_MS 1000
 
 //how far floating text rises per frame. can be negative. todo: add to config
 #define EXTERN_FLOAT_RATE 0.5
@@ -170,6 +165,8 @@ coord -14a is between col 0 and 1 at h_edge_sep ~0.8. 0.8*14 = 11.2
 //offset the instruction text on the drawn node
 #define INS_X_OFF 5
 #define INS_Y_OFF 1
+//how close the mouse must be to a node to show its instruction
+#define MOUSEOVER_NODE_PIXELS 12
 
 #define MAX_LIVE_ANIMATION_NODES_PER_FRAME 100
 
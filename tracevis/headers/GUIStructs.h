@@ -27,6 +27,30 @@ A messy collection of state structures, generally targeted to the visualiser sta
 #include "timeline.h"
 #include "clientConfig.h"
 
+#define INSPECT_DEFAULT_TOPN 10
+
+//display modes of headless graph images
+#define SNAPSHOT_STATIC 0
+#define SNAPSHOT_HEATMAP 1
+#define SNAPSHOT_CONDITIONAL 2
+//one image of each mode
+#define SNAPSHOT_ALL 3
+#define SNAPSHOT_DEFAULT_SIZE 1024
+
+//camera and size of a headless graph image
+struct SNAPSHOT_VIEW {
+	//same as the main display rotation
+	float xturn = 0;
+	float yturn = 0;
+	//camera distance as a multiple of the distance that fits the whole sphere in the image
+	float zoom = 1;
+	int mode = SNAPSHOT_STATIC;
+	unsigned int width = SNAPSHOT_DEFAULT_SIZE;
+	unsigned int height = SNAPSHOT_DEFAULT_SIZE;
+	//otherwise ppm
+	bool png = false;
+};
+
 #define XOFF 0
 #define YOFF 1
 #define ZOFF 2
@@ -83,6 +107,8 @@ struct LAUNCHOPTIONS {
 	bool caffine = false;
 	bool pause = false;
 	bool basic = false;
+	//one node per basic block instead of per instruction
+	bool blockNodes = false;
 	bool debugMode = false;
 };
 
@@ -93,7 +119,6 @@ public:
 
 	void gen_wireframe_buffers()
 	{
-		glGenBuffers(2, colSphereVBOs);
 		glGenBuffers(2, wireframeVBOs);
 	}
 
@@ -119,20 +144,34 @@ public:
 	int show_ins_text = INSTEXT_AUTO;
 	int show_extern_text = EXTERNTEXT_SYMS;
 
-	int leftcolumn = 0;
-	int rightcolumn = 0;
-
 	void *widgets = 0;
 	int animationUpdate = 0;
 	bool animFinished = false;
 	bool skipLoop = false;
+	//replay position marked as one end of a heat window
+	bool heatWindowMarked = false;
+	unsigned long heatWindowMark = 0;
 
 	bool mouse_dragging = false;
+	//over the main graph, -1 when elsewhere
+	int mouseX = -1;
+	int mouseY = -1;
 	thread_graph_data *mouse_drag_graph = NULL;
 	map <PID_TID, NODEPAIR> graphPositions;
 
 	string commandlineLaunchPath;
 	string commandlineLaunchArgs;
+	//headless save inspection
+	string commandlineInspectPath;
+	unsigned int inspectTopN = INSPECT_DEFAULT_TOPN;
+	//headless trace slicing
+	string commandlineSlicePath;
+	PID_TID sliceTID = 0;
+	unsigned long sliceStart = 0;
+	unsigned long sliceEnd = 0;
+	//headless graph images
+	string commandlineSnapshotPath;
+	SNAPSHOT_VIEW snapshotView;
 	//for future random pipe names
 	//char pipeprefix[20];
 
@@ -147,9 +186,6 @@ public:
 	PROCESS_DATA *activePid = NULL;
 	PROCESS_DATA* spawnedProcess = NULL;
 
-	GRAPH_DISPLAY_DATA *col_pick_sphere = NULL;
-	GLuint colSphereVBOs[2];
-	
 	GRAPH_DISPLAY_DATA *wireframe_sphere = NULL;
 	GLuint wireframeVBOs[2];
 	bool remakeWireframe = false;
@@ -168,12 +204,4 @@ public:
 	bool saving = false;
 };
 
-//screen top bottom red green
-//for edge picking
-struct SCREEN_EDGE_PIX {
-	double leftgreen = 0;
-	double rightgreen = 0;
-	double topred = 0;
-	double bottomred = 0;
-};
 
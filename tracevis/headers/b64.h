@@ -4,3 +4,5 @@
 
 std::string base64_encode(unsigned char const*, unsigned int len);
 std::string base64_decode(std::string const& s);
+//true if everything from start onwards is alphabet or padding
+bool base64_is_clean(std::string const& s, size_t start);
@@ -51,7 +51,6 @@ public:
 	struct {
 		int FPS;
 		int processDelay;
-		int threadDelay;
 		float spinPerFrame;
 		int edgesPerRender;
 		ALLEGRO_COLOR background;
@@ -81,6 +80,8 @@ public:
 
 	float animationFadeRate;
 	unsigned int maxArgStorage;
+	//write rendered geometry into saves so they display instantly on load
+	bool saveRenderedBuffers;
 
 	//these are not saved in the config file but toggled at runtime
 	void updateSavePath(string path);
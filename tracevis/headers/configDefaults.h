@@ -46,7 +46,6 @@ Defaults for using when a config file exist
 
 #define PREVIEW_RENDER_FPS 10
 #define PREVIEW_UPDATE_DELAY_MS 100
-#define PREVIEW_DELAY_PER_GRAPH 20
 #define PREVIEW_SPIN_PER_FRAME 0.6
 #define PREVIEW_EDGES_PER_RENDER 60
 #define PREVIEW_BACKGROUND al_col_black
@@ -81,4 +80,7 @@ Defaults for using when a config file exist
 #define DEFAULT_MAX_TRACE_BUFSIZE 400000
 
 //mazimum number of args to store per external
-#define DEFAULT_MAX_ARG_STORAGE 100
\ No newline at end of file
+#define DEFAULT_MAX_ARG_STORAGE 100
+
+//store rendered vertex buffers in saves. faster loading, bigger files
+#define DEFAULT_SAVE_RENDERED_BUFFERS false
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Keeps track of which bytes of some vertex data changed since each opengl buffer
+filled from it was last uploaded, so uploads can send just those bytes.
+Doesn't call opengl or lock anything, the owner of the data does both
+*/
+#pragma once
+#include "stdafx.h"
+
+//past this many separate ranges the closest two are merged
+#define DIRTY_MAX_RANGES 64
+
+//[first, second) in bytes
+typedef pair<unsigned long, unsigned long> BYTE_RANGE;
+
+class dirty_ranges
+{
+public:
+	void mark(unsigned long start, unsigned long end);
+	//moves the ranges below limit into out, anything past it is kept for later
+	void take(unsigned long limit, vector<BYTE_RANGE> *out);
+	//forget ranges below limit
+	void discard(unsigned long limit);
+	bool empty() { return ranges.empty(); }
+	unsigned long range_count() { return ranges.size(); }
+
+private:
+	void merge_closest();
+	//sorted, not touching each other
+	vector<BYTE_RANGE> ranges;
+};
+
+//an opengl buffer filled from the data
+struct UPLOAD_TARGET {
+	dirty_ranges dirty;
+	//size the buffer was last given
+	unsigned long bufferBytes = 0;
+};
+
+class upload_tracker
+{
+public:
+	//marks the bytes changed for every buffer filled from the data
+	void mark(unsigned long start, unsigned long end);
+	//the data changed completely (eg: a new palette)
+	void mark_all();
+	//ranges to send to a buffer that has to hold endByte bytes. true if the buffer must be
+	//given newBufferBytes first, which loses its contents so all of them are sent
+	bool take(unsigned int buffer, unsigned long endByte, vector<BYTE_RANGE> *ranges, unsigned long *newBufferBytes);
+
+private:
+	//new buffers start with no size so they get everything on their first upload
+	map<unsigned int, UPLOAD_TARGET> targets;
+};
@@ -36,5 +36,11 @@ public:
 
 	//number of times executed, temporary variable used by heatmap solver
 	unsigned long chainedWeight = 0;
+	//number of times executed, counted by the trace handler as it follows the edge
+	unsigned long executionCount = 0;
+	//handler couldn't attribute all executions (eg: unchained block with several targets)
+	bool countUncertain = false;
+	//waiting in the trace handler's list of changed edges
+	bool heatDirty = false;
 };
 
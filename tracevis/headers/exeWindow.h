@@ -47,6 +47,7 @@ private:
 
 	agui::CheckBox *pauseCB;
 	agui::CheckBox *basicCB;
+	agui::CheckBox *blockNodesCB;
 	agui::CheckBox *debugCB;
 	agui::CheckBox *hideVMCB;
 	agui::CheckBox *hideSleepCB;
@@ -100,6 +101,8 @@ public:
 			clientState->launchopts.caffine = state;
 		else if (thisNeedsAnIDField == "Pause on start")
 			clientState->launchopts.pause = state;
+		else if (thisNeedsAnIDField == "Block nodes")
+			clientState->launchopts.blockNodes = state;
 		//else if (thisNeedsAnIDField == "Debugger mode")
 		//	clientState->launchopts.debugMode = state; 
 		else
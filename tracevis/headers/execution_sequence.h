@@ -0,0 +1,147 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Packed record of the blocks a thread executed, for animation and replay
+Each entry is a 32 bit handle into a process wide table of blocks. Each run of a loop
+is one record shared by the entries of its blocks.
+*/
+#pragma once
+#include "stdafx.h"
+#include "traceConstants.h"
+#include <atomic>
+
+/*
+append only list for one writer and any number of readers
+items never move once written so readers can hold references to anything below a size()
+they have read without locking
+*/
+template <typename T, unsigned int CHUNKBITS>
+class chunked_list
+{
+public:
+	~chunked_list()
+	{
+		T **chunks = directory.load();
+		for (unsigned long i = 0; i < dirCapacity && chunks; ++i)
+			delete[] chunks[i];
+		delete[] chunks;
+		for (size_t i = 0; i < retired.size(); ++i)
+			delete[] retired[i];
+	}
+
+	void push_back(const T &item)
+	{
+		unsigned long idx = count.load(std::memory_order_relaxed);
+		if (!(idx & CHUNKMASK)) add_chunk(idx >> CHUNKBITS);
+		directory.load(std::memory_order_relaxed)[idx >> CHUNKBITS][idx & CHUNKMASK] = item;
+		count.store(idx + 1, std::memory_order_release);
+	}
+
+	unsigned long size() const { return count.load(std::memory_order_acquire); }
+	bool empty() const { return !size(); }
+	const T &at(unsigned long idx) const
+	{
+		return directory.load(std::memory_order_acquire)[idx >> CHUNKBITS][idx & CHUNKMASK];
+	}
+
+private:
+	static const unsigned long CHUNKSIZE = 1UL << CHUNKBITS;
+	static const unsigned long CHUNKMASK = CHUNKSIZE - 1;
+
+	void add_chunk(unsigned long chunkIdx)
+	{
+		T **chunks = directory.load(std::memory_order_relaxed);
+		if (chunkIdx >= dirCapacity)
+		{
+			//readers may still be using the old directory, keep it until we die
+			unsigned long newCapacity = dirCapacity ? dirCapacity * 2 : 16;
+			T **newChunks = new T*[newCapacity]();
+			for (unsigned long i = 0; i < dirCapacity; ++i)
+				newChunks[i] = chunks[i];
+			newChunks[chunkIdx] = new T[CHUNKSIZE];
+			directory.store(newChunks, std::memory_order_release);
+			if (chunks) retired.push_back(chunks);
+			dirCapacity = newCapacity;
+			return;
+		}
+		chunks[chunkIdx] = new T[CHUNKSIZE];
+	}
+
+	std::atomic<T **> directory{ 0 };
+	std::atomic<unsigned long> count{ 0 };
+	unsigned long dirCapacity = 0;
+	vector<T **> retired;
+};
+
+typedef unsigned int BLOCK_HANDLE;
+//entry was executed as part of a loop
+#define SEQUENCE_LOOPED 0x80000000
+#define SEQUENCE_HANDLE_MASK 0x7fffffff
+#define NO_LOOP_ITERATIONS 0xbad
+
+struct SEQUENCE_BLOCK {
+	MEM_ADDRESS address;
+	BLOCK_IDENTIFIER blockID;
+	unsigned int insCount;
+};
+
+//block address, blockID, number of instructions executed
+typedef pair<pair<MEM_ADDRESS, BLOCK_IDENTIFIER>, unsigned int> SEQUENCE_BLOCK_KEY;
+
+//blocks seen by every thread of a process. handles are issued under a lock, resolved without one
+class block_table
+{
+public:
+	block_table() { tableMutex = CreateMutex(NULL, FALSE, NULL); }
+	BLOCK_HANDLE get_handle(MEM_ADDRESS address, BLOCK_IDENTIFIER blockID, unsigned int insCount);
+	const SEQUENCE_BLOCK &resolve(BLOCK_HANDLE handle) const { return blocks.at(handle); }
+
+private:
+	HANDLE tableMutex;
+	map<SEQUENCE_BLOCK_KEY, BLOCK_HANDLE> handles;
+	chunked_list<SEQUENCE_BLOCK, 10> blocks;
+};
+
+struct LOOP_RECORD {
+	unsigned long firstEntry;
+	unsigned long iterations;
+};
+
+class execution_sequence
+{
+public:
+	execution_sequence(block_table *processBlocks) { blocks = processBlocks; }
+
+	//writer: the thread's trace handler or the loader
+	void add_block(BLOCK_HANDLE handle) { entries.push_back(handle); }
+	//following add_loop_block calls are blocks of one run of a loop
+	void start_loop(unsigned long iterations);
+	void add_loop_block(BLOCK_HANDLE handle) { entries.push_back(handle | SEQUENCE_LOOPED); }
+
+	unsigned long size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+
+	BLOCK_HANDLE handle(unsigned long seqIdx) const { return entries.at(seqIdx) & SEQUENCE_HANDLE_MASK; }
+	const SEQUENCE_BLOCK &block(unsigned long seqIdx) const { return blocks->resolve(handle(seqIdx)); }
+	//<loop number starting at 1 or 0 for none, iterations>
+	pair<unsigned int, unsigned long> loop_state(unsigned long seqIdx) const;
+
+private:
+	block_table *blocks;
+	chunked_list<BLOCK_HANDLE, 12> entries;
+	chunked_list<LOOP_RECORD, 8> loops;
+};
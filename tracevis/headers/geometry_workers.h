@@ -0,0 +1,35 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+A thread per core for splitting big batches of vertex generation (sphere coords,
+edge curves) into slices. Each slice writes its own part of the output, so results
+are the same as doing the whole batch on one thread
+*/
+#pragma once
+#include "stdafx.h"
+
+//not worth waking another thread for fewer items than this
+#define GEOMETRY_MIN_SLICE 2048
+
+//does items [first, last) of a batch
+typedef void(*SLICE_WORK)(void *context, unsigned long first, unsigned long last);
+
+//splits [0, items) between the caller and the workers, returns when every slice is done
+//if another thread is using the workers the caller does the whole batch itself
+//minSlice is the fewest items worth giving a thread, for items that are slow to do
+void run_geometry_slices(unsigned long items, SLICE_WORK work, void *context,
+	unsigned long minSlice = GEOMETRY_MIN_SLICE);
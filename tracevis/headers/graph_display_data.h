@@ -16,53 +16,195 @@ limitations under the License.
 
 /*
 This class holds (and provides dubiously mutex guarded access to) OpenGl vertex and colour data
+
+Vertices live in chunks that never move once allocated, each twice the size of the last,
+so growing the buffer never copies it. Writers hold the pos/col mutex while they write
+and publish the new vertex count with set_numVerts. Readers take get_numVerts and can
+read anything below it without locking.
+
+Resets and reloads write over the same chunks, so they bump a generation first.
+A reader that might overlap one takes get_generation before get_numVerts and
+throws away what it read if same_generation fails afterwards.
+
+Writes are recorded against every opengl buffer filled from the data so uploads
+only send what changed. In place edits have to be marked by whoever makes them.
 */
 #pragma once
 #include <stdafx.h>
 #include "mathStructs.h"
+#include "dirty_ranges.h"
+#include <atomic>
+#include <intrin.h>
+
+//vertices in the first chunk, as a power of 2
+#define DISPLAY_FIRST_CHUNK_BITS 8
+//enough for 2^32 vertices
+#define DISPLAY_MAX_CHUNKS 24
+
+//chunk holding a vertex and the vertex's offset into it
+inline unsigned int display_chunk(unsigned long vertIdx, unsigned long *offset)
+{
+	unsigned long chunkIdx;
+	_BitScanReverse(&chunkIdx, (vertIdx >> DISPLAY_FIRST_CHUNK_BITS) + 1);
+	*offset = vertIdx - (((1UL << chunkIdx) - 1) << DISPLAY_FIRST_CHUNK_BITS);
+	return chunkIdx;
+}
+
+inline unsigned long display_chunk_verts(unsigned int chunkIdx)
+{
+	return 1UL << (chunkIdx + DISPLAY_FIRST_CHUNK_BITS);
+}
 
 class GRAPH_DISPLAY_DATA {
 public:
 	GRAPH_DISPLAY_DATA(bool preview = false);
 	~GRAPH_DISPLAY_DATA();
 
-	vector <float>* acquire_pos(int holder = 0);
-	vector <float>* acquire_col();
-
-	float *readonly_col() { if (!vcolarray.empty()) return &vcolarray.at(0); return 0; }
-	float *readonly_pos() { if (!vposarray.empty()) return &vposarray.at(0); return 0; }
-
+	//writer locks, must be held to write or append the corresponding data
+	bool acquire_pos(int holder = 0);
+	void acquire_col();
 	void release_pos();
 	void release_col();
+
+	//vertex data, 0 if the vertex has never been written
+	GLfloat *pos_at(unsigned long vertIdx) { return vert_at(posChunks, POSELEMS, vertIdx); }
+	GLfloat *col_at(unsigned long vertIdx) { return vert_at(colChunks, COLELEMS, vertIdx); }
+	//like pos_at/col_at, also gives the number of vertices stored contiguously from there
+	GLfloat *pos_run(unsigned long vertIdx, unsigned long *runVerts) { return run_at(posChunks, POSELEMS, vertIdx, runVerts); }
+	GLfloat *col_run(unsigned long vertIdx, unsigned long *runVerts) { return run_at(colChunks, COLELEMS, vertIdx, runVerts); }
+
+	//adds to the end of the written data, caller holds the lock
+	void append_pos(const GLfloat *pos, unsigned long verts);
+	void append_col(const GLfloat *col, unsigned long verts);
+	//vertices changed in place since they were appended, caller holds the lock
+	void mark_pos(unsigned long firstVert, unsigned long verts);
+	void mark_col(unsigned long firstVert, unsigned long verts);
+	//ranges of verts vertices to send to an opengl buffer, see upload_tracker::take
+	bool take_dirty(bool colours, unsigned int buffer, unsigned long verts,
+		vector<BYTE_RANGE> *ranges, unsigned long *newBufferBytes);
+	//vertices written so far, may be ahead of numVerts
+	unsigned long pos_count() { return posWritten; }
+	unsigned long col_count() { return colWritten; }
+	//contiguous copy of everything written
+	void copy_pos(vector<GLfloat> *out);
+	void copy_col(vector<GLfloat> *out);
+
+	//adds vertices built by the caller under one lock, returns the colour index of the first
+	unsigned int append_verts(const GLfloat *pos, const GLfloat *col, unsigned int verts);
+	//everything written is sent to the opengl buffers again
+	void mark_all();
+
 	void clear();
+	//chunks are kept for reuse so readers never see them freed
 	void reset();
-	unsigned int col_size() { return colSize; }
-	unsigned int pos_size() { return posSize; }
-	unsigned int col_sizec() { return vcolarray.size(); }
-	//this is actually quite slow? or at least is a significant % of reported cpu time
-	unsigned int col_buf_capacity_floats() { return vcolarraySize; }
-	unsigned int get_numVerts() { return numVerts; }
+	unsigned int col_size() { return get_numVerts() * COLELEMS * sizeof(GLfloat); }
+	unsigned int pos_size() { return get_numVerts() * POSELEMS * sizeof(GLfloat); }
+	unsigned int get_numVerts() { return numVerts.load(std::memory_order_acquire); }
 	void set_numVerts(unsigned int num);
 	unsigned int get_renderedEdges() { return edgesRendered; }
 	void inc_edgesRendered() { ++edgesRendered; }
+	unsigned int get_generation() { return generation.load(std::memory_order_acquire); }
+	bool same_generation(unsigned int gen);
 
 	bool get_coord(unsigned int index, FCOORD* result);
+	//replace contents with copies of buffers rendered previously (ie: from a save)
+	void load_buffers(vector<GLfloat> *pos, vector<GLfloat> *col, unsigned int verts, unsigned int edges);
 
 	bool isPreview() { return preview; }
 
 private:
+	typedef std::atomic<GLfloat *> CHUNKDIR[DISPLAY_MAX_CHUNKS];
+	GLfloat *vert_at(CHUNKDIR &chunks, unsigned int elems, unsigned long vertIdx)
+	{
+		unsigned long offset;
+		unsigned int chunkIdx = display_chunk(vertIdx, &offset);
+		GLfloat *chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+		return chunk ? chunk + offset * elems : 0;
+	}
+	GLfloat *run_at(CHUNKDIR &chunks, unsigned int elems, unsigned long vertIdx, unsigned long *runVerts);
+	unsigned long append(CHUNKDIR &chunks, unsigned int elems, unsigned long written, const GLfloat *data, unsigned long verts);
+	void copy_out(CHUNKDIR &chunks, unsigned int elems, unsigned long written, vector<GLfloat> *out);
+	void discard_written();
+
 	HANDLE posmutex;
 	HANDLE colmutex;
-	unsigned int numVerts = 0;
-
-	vector<GLfloat> vposarray;
-	vector<GLfloat> vcolarray;
+	std::atomic<unsigned int> numVerts{ 0 };
+	std::atomic<unsigned int> generation{ 0 };
 
-	unsigned int colSize = 0;
-	unsigned int posSize = 0;
-	unsigned int vcolarraySize = 0;
+	CHUNKDIR posChunks;
+	CHUNKDIR colChunks;
+	unsigned long posWritten = 0;
+	unsigned long colWritten = 0;
+	upload_tracker posUploads;
+	upload_tracker colUploads;
 
 	//not used for nodes
 	unsigned int edgesRendered = 0;
 	bool preview = false;
-};
\ No newline at end of file
+};
+
+//colours in a palette layer
+#define PALETTE_MAX_COLOURS 256
+//uploaded as RGBA bytes
+#define PALETTE_VERT_BYTES COLELEMS
+
+/*
+Colours for a display mode that recolours the main geometry from a handful of colours (heatmap, conditionals)
+One palette index per vertex instead of 4 floats, positions come from the main buffers.
+Same chunking, locking and generations as GRAPH_DISPLAY_DATA
+*/
+class PALETTE_LAYER {
+public:
+	PALETTE_LAYER();
+	~PALETTE_LAYER();
+
+	//must be held to write indices or change the palette
+	void acquire_col();
+	void release_col();
+
+	void set_colour(unsigned char index, const GLfloat *rgba);
+	unsigned char *index_at(unsigned long vertIdx);
+	//like index_at, also gives the number of indices stored contiguously from there
+	unsigned char *index_run(unsigned long vertIdx, unsigned long *runVerts);
+
+	//adds verts vertices of one colour, caller holds the lock
+	void append(unsigned char index, unsigned long verts);
+	//recolours vertices already written, caller holds the lock
+	void fill(unsigned long firstVert, unsigned long verts, unsigned char index);
+	//swaps everything written for indices built elsewhere, caller holds the lock
+	void replace(vector<unsigned char> *indices, unsigned int edges);
+	unsigned long count() { return written; }
+	//everything written is sent to the opengl buffers again
+	void mark_all();
+	//ranges of verts expanded vertices to send to an opengl buffer, see upload_tracker::take
+	bool take_dirty(unsigned int buffer, unsigned long verts,
+		vector<BYTE_RANGE> *ranges, unsigned long *newBufferBytes);
+
+	//RGBA bytes for a run of indices
+	void expand(const unsigned char *indices, unsigned long verts, unsigned char *out);
+	//everything written as RGBA floats, the format saves use
+	void copy_col(vector<GLfloat> *out);
+	//replace contents with saved RGBA floats, fails if they have too many colours for a palette
+	bool load_colours(vector<GLfloat> *col, unsigned int verts, unsigned int edges);
+
+	void reset();
+	unsigned int get_numVerts() { return numVerts.load(std::memory_order_acquire); }
+	void set_numVerts(unsigned int num) { numVerts.store(num, std::memory_order_release); }
+	unsigned int get_renderedEdges() { return edgesRendered; }
+	void set_renderedEdges(unsigned int edges) { edgesRendered = edges; }
+	unsigned int get_generation() { return generation.load(std::memory_order_acquire); }
+	bool same_generation(unsigned int gen);
+
+private:
+	void discard_written();
+
+	HANDLE colmutex;
+	std::atomic<unsigned char *> chunks[DISPLAY_MAX_CHUNKS];
+	unsigned long written = 0;
+	std::atomic<unsigned int> numVerts{ 0 };
+	std::atomic<unsigned int> generation{ 0 };
+	unsigned int edgesRendered = 0;
+	unsigned char palette[PALETTE_MAX_COLOURS][COLELEMS];
+	//in expanded RGBA bytes
+	upload_tracker uploads;
+};
@@ -0,0 +1,108 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Coarser versions of a graph for drawing when zoomed out
+Blocks collapse chains of instructions, functions group the nodes between calls and returns,
+modules group everything executed in a module. Each group is drawn at the position of its
+first node. Only touched by the main graph render thread
+*/
+#pragma once
+#include "stdafx.h"
+#include "graph_display_data.h"
+#include "node_data.h"
+#include "edge_data.h"
+
+//every node drawn
+#define LOD_NONE -1
+#define LOD_BLOCK 0
+#define LOD_FUNCTION 1
+#define LOD_MODULE 2
+#define LOD_LEVELS 3
+
+//graph edge inside a single group
+#define LOD_INTERNAL_EDGE 0xffffffff
+
+struct LOD_GROUP {
+	//node the group is drawn at
+	unsigned int representative;
+};
+
+struct LOD_EDGE {
+	//groups
+	unsigned int source;
+	unsigned int target;
+	//class of the first graph edge between them
+	char edgeClass;
+	//summed executions of the graph edges, refreshed when the geometry is built
+	unsigned long weight;
+};
+
+struct LOD_LEVEL {
+	//group of each node
+	vector<unsigned int> nodeGroups;
+	vector<LOD_GROUP> groups;
+	vector<LOD_EDGE> edges;
+	map<NODEPAIR, unsigned int> edgeIndexes;
+	//aggregated edge of each graph edge added, LOD_INTERNAL_EDGE for ones inside a group
+	vector<unsigned int> memberEdges;
+	bool geometryDirty = true;
+};
+
+class graph_lod
+{
+public:
+	graph_lod();
+	~graph_lod();
+
+	//edges are added in the order of the graph's edge list, nodes are grouped as they are reached
+	void add_edge(edge_data *e, node_data *source, node_data *target);
+	unsigned long edge_count() { return graphEdges.size(); }
+	//node positions moved (eg: rescale)
+	void positions_changed();
+	//edge executions changed, levels are rebuilt for it at most every LOD_COUNT_REFRESH_MS
+	void counts_changed(unsigned long countUpdates);
+
+	//level worth drawing a graph of numNodes at a zoom factor
+	static int level_for_zoom(float zmul, unsigned int numNodes);
+	//builds the geometry of a level if it isn't already, false if nothing changed
+	bool build_geometry(int level, GRAPH_DISPLAY_DATA *mainnodes, map<int, ALLEGRO_COLOR> *lineColours);
+	int get_built_level() { return builtLevel; }
+	GRAPH_DISPLAY_DATA *get_nodes() { return lodnodes; }
+	GRAPH_DISPLAY_DATA *get_lines() { return lodlines; }
+
+private:
+	void add_node_group(LOD_LEVEL *level, unsigned int nodeIdx);
+	void join_group(LOD_LEVEL *level, unsigned int nodeIdx, unsigned int groupIdx);
+	bool is_assigned(LOD_LEVEL *level, unsigned int nodeIdx);
+	void group_module(node_data *n);
+	void group_target(edge_data *e, node_data *source, node_data *target);
+	void add_lod_edge(LOD_LEVEL *level, edge_data *e, unsigned int sourceIdx, unsigned int targetIdx);
+
+	LOD_LEVEL levels[LOD_LEVELS];
+	vector<edge_data *> graphEdges;
+	//function group of the caller, by the return address of its call instructions
+	map<MEM_ADDRESS, unsigned int> returnGroups;
+	map<int, unsigned int> moduleGroups;
+
+	int builtLevel = LOD_NONE;
+	//node colours are copied from the main nodes, so a rebuild of them needs one here too
+	unsigned int builtNodesGeneration = 0;
+	unsigned long seenCountUpdates = 0;
+	DWORD64 lastCountRefresh = 0;
+	GRAPH_DISPLAY_DATA *lodnodes;
+	GRAPH_DISPLAY_DATA *lodlines;
+};
@@ -24,6 +24,29 @@ Header for sphere coordinate processing functions
 void recalculate_scale(MULTIPLIERS *mults);
 //take longitude a, latitude b, output coord in space
 void sphereCoord(int ia, float b, FCOORD *c, MULTIPLIERS *dimensions, float diamModifier = 0);
+//sphereCoord of many a/b/bMod coords at once, writes POSELEMS floats for each
+//big batches are split over the geometry worker threads
+void sphereCoords(const VCOORD *coords, unsigned long count, GLfloat *positions, MULTIPLIERS *dimensions, float diamModifier = 0);
+
+//sin/cos of every whole step between low and high along one axis
+struct AXIS_TRIG {
+	int low;
+	vector<float> sinv;
+	vector<float> cosv;
+};
+
+//lookup tables for one batch of sphereCoords, read only once built
+struct SPHERE_BATCH {
+	MULTIPLIERS *dimensions;
+	float diamModifier;
+	//too spread out for tables, uses sphereCoord
+	bool sparse;
+	AXIS_TRIG aTrig, bTrig, mTrig;
+};
+void plan_sphere_coords(const VCOORD *coords, unsigned long count, MULTIPLIERS *dimensions,
+	float diamModifier, SPHERE_BATCH *batch);
+//any part of the batch the plan was made for
+void project_sphere_coords(SPHERE_BATCH *batch, const VCOORD *coords, unsigned long count, GLfloat *positions);
 float linedist(FCOORD *c1, FCOORD *c2);
 float linedist(DCOORD *c1, FCOORD *c2);
 void midpoint(FCOORD *c1, FCOORD *c2, FCOORD *c3);
@@ -34,5 +57,4 @@ float zoomFactor(long cameraZoom, long sphereSize);
 void bezierPT(FCOORD *startC, FCOORD *bezierC, FCOORD *endC, int pointnum, int totalpoints, FCOORD *resultC);
 void sphereAB(FCOORD *c, float *a, float *b, MULTIPLIERS *dimensions);
 void sphereAB(DCOORD *c, float *a, float *b, MULTIPLIERS *dimensions);
-bool is_on_screen(DCOORD * screenCoord, void *clientState);
-bool a_coord_on_screen(int a, int leftcol, int rightcol, float hedgesep);
\ No newline at end of file
+bool is_on_screen(DCOORD * screenCoord, void *clientState);
\ No newline at end of file
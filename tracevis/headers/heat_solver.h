@@ -0,0 +1,70 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Works out how many times each edge was followed from how many times each node ran
+Executions into a node = executions out of it = executions of the node, so whenever
+a node has one edge left unsolved on a side, that edge takes whatever is remaining
+*/
+#pragma once
+#include "stdafx.h"
+
+struct HEAT_EDGE {
+	unsigned int source;
+	unsigned int target;
+	unsigned long weight = 0;
+	bool solved = false;
+};
+
+//a node whose edges don't add up to its executions
+struct HEAT_RESIDUAL {
+	unsigned int node;
+	//executions not accounted for by solved edges, negative if the edges carry too many
+	long long inResidual;
+	long long outResidual;
+};
+
+class heat_solver
+{
+public:
+	//nodeHeat: executions of each node, by node index
+	heat_solver(vector<unsigned long> *nodeHeat) { heat = nodeHeat; }
+	//returns edge number, the position of the edge's result in edges
+	unsigned long add_edge(unsigned int source, unsigned int target);
+	//edge with a known execution count, only used to balance the others
+	unsigned long add_counted_edge(unsigned int source, unsigned int target, unsigned long weight);
+	//entryNode ran once without an edge into it, finalNode once without an edge out of it
+	void solve(unsigned int entryNode, unsigned int finalNode);
+
+	vector<HEAT_EDGE> edges;
+	vector<HEAT_RESIDUAL> residuals;
+	unsigned long solvedEdges = 0;
+
+private:
+	void set_weight(unsigned long edgeIdx, long long weight);
+	void queue_node(unsigned int nodeIdx);
+	void solve_node(unsigned int nodeIdx);
+	void build_adjacency();
+	void apply_counted_edges();
+
+	vector<unsigned long> *heat;
+	vector<long long> remainingIn, remainingOut;
+	vector<unsigned int> unsolvedIn, unsolvedOut;
+	//edge numbers of each node's edges, packed by node: edgesOut[outStart[n]...outStart[n+1]]
+	vector<unsigned long> inStart, outStart, edgesIn, edgesOut;
+	vector<unsigned int> worklist;
+	vector<bool> queued;
+};
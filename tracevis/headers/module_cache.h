@@ -0,0 +1,43 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Content addressed store of module data shared between saves
+Symbol tables are written once to modcache\ beside the save and saves reference them by key
+*/
+#pragma once
+#include "stdafx.h"
+#include "traceStructs.h"
+
+#define MODCACHE_DIR "modcache\\"
+#define MODCACHE_REF '#'
+//decodes kept between loads. past these the cache is emptied and refills from the saves loaded after
+#define MODCACHE_MAX_MODULES 512
+#define MODCACHE_MAX_INSTRUCTIONS 1000000
+
+//serialise symbols of one module with addresses relative to its base
+string modcache_encode_syms(map<MEM_ADDRESS, string> *syms, MEM_ADDRESS modbase);
+//key = hash of module path + hash of encoded table
+string modcache_key(string modpath, string *encodedSyms);
+
+//write encoded table to store if it isn't already there
+bool modcache_store(string saveDir, string key, string *encodedSyms);
+//insert symbols for key into piddata, decoding from store only on first use
+//false if saveDir has no valid entry for key
+bool modcache_load_syms(string saveDir, string key, MEM_ADDRESS modbase, int modnum, PROCESS_DATA *piddata);
+
+//disassemble opcodes at address, reusing decodes from previously loaded saves
+bool modcache_disassemble(csh hCapstone, string opcodes, INS_DATA *insdata, MEM_ADDRESS address);
@@ -36,6 +36,18 @@ public:
 
 	bool get_screen_pos(GRAPH_DISPLAY_DATA *vdata, PROJECTDATA *pd, DCOORD *screenPos);
 	FCOORD sphereCoordB(MULTIPLIERS *dimensions, float diamModifier);
+	//block nodes are drawn for the last instruction run, which moves if the block
+	//was first cut short by an exception. returns false if the block didn't grow
+	bool extend_block(INSLIST *block, unsigned int insCount)
+	{
+		if (insCount <= blockInsCount) return false;
+		ins = block->at(insCount - 1);
+		address = ins->address;
+		//anything seen of the old last instruction's condition doesn't apply
+		conditional = ins->conditional;
+		blockInsCount = insCount;
+		return true;
+	}
 
 	unsigned int index = 0;
 	VCOORD vcoord;
@@ -53,9 +65,9 @@ public:
 	unsigned int parentIdx = 0;
 
 	unsigned long executionCount = 0;
-	unsigned long chain_remaining_in = 0;
-	unsigned long chain_remaining_out = 0;
-	DWORD heat_run_marker;
+	//block nodes stand for a whole basic block ending in ins, 0 for a single instruction
+	unsigned int blockInsCount = 0;
+	MEM_ADDRESS blockAddress = 0;
 
 	set<unsigned int> incomingNeighbours;
 	set<unsigned int> outgoingNeighbours;
@@ -0,0 +1,77 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Buckets the drawn nodes of a graph by where they sit on the sphere so text and
+mouseover lookups only look at nodes in the part of the sphere being viewed
+Only used by the main display thread
+*/
+#pragma once
+#include "stdafx.h"
+#include "mathStructs.h"
+#include "graph_display_data.h"
+
+//cells around the sphere and from pole to pole
+#define NODEGRID_COLUMNS 64
+#define NODEGRID_ROWS 32
+
+//the space the main graph camera can see, in graph coordinates
+class view_frustum
+{
+public:
+	view_frustum(PROJECTDATA *pd);
+	//inside the edges of the screen and the near/far clipping planes
+	bool point_visible(const GLfloat *pos);
+	bool box_visible(const GLfloat *boxMin, const GLfloat *boxMax);
+	//not hidden behind the curve of a sphere through the point
+	bool near_side(const GLfloat *pos);
+	//the whole box is on the side of the sphere facing away from the camera
+	bool box_far_side(const GLfloat *boxMin, const GLfloat *boxMax);
+
+private:
+	double planes[6][4];
+	double camera[3];
+};
+
+struct NODEGRID_CELL {
+	vector<unsigned int> nodes;
+	GLfloat boxMin[POSELEMS];
+	GLfloat boxMax[POSELEMS];
+};
+
+class node_grid
+{
+public:
+	//indexes nodes drawn since the last call
+	void update(GRAPH_DISPLAY_DATA *mainnodes);
+	//drop everything, for when the nodes move
+	void reset();
+
+	//nodes that may be on screen. nearSideOnly leaves out the ones behind the sphere
+	void visible_nodes(view_frustum *view, bool nearSideOnly, vector<unsigned int> *nodes);
+	//nearest node on the near side within maxPixels of an opengl screen position
+	bool nearest_node(PROJECTDATA *pd, view_frustum *view, double x, double y,
+		double maxPixels, unsigned int *nodeIdx);
+
+private:
+	unsigned int cell_index(const GLfloat *pos);
+
+	GRAPH_DISPLAY_DATA *nodedata = 0;
+	unsigned int indexedNodes = 0;
+	NODEGRID_CELL cells[NODEGRID_COLUMNS * NODEGRID_ROWS];
+	//cells holding any nodes
+	vector<unsigned int> usedCells;
+};
@@ -27,6 +27,10 @@ void frame_gl_setup(VISSTATE* clientState);
 void frame_gl_teardown();
 
 void load_VBO(int index, GLuint *VBOs, int bufsize, float *data);
+//upload the first verts positions/colours of display data, a chunk at a time
+void load_VBO_pos(int index, GLuint *VBOs, GRAPH_DISPLAY_DATA *data, unsigned int verts);
+void load_VBO_col(int index, GLuint *VBOs, GRAPH_DISPLAY_DATA *data, unsigned int verts);
+void load_VBO_palette(int index, GLuint *VBOs, PALETTE_LAYER *layer, unsigned int verts);
 void load_edge_VBOS(GLuint *VBOs, GRAPH_DISPLAY_DATA *lines);
 void loadVBOs(GLuint *VBOs, GRAPH_DISPLAY_DATA *verts, GRAPH_DISPLAY_DATA *lines);
 void gen_graph_VBOs(thread_graph_data *graph);
@@ -35,11 +39,9 @@ void array_render(int prim, int POSVBO, int COLVBO, GLuint *buffers, int quantit
 
 void rotate_to_user_view(VISSTATE *clientState);
 
-void edge_picking_colours(VISSTATE *clientState, SCREEN_EDGE_PIX *TBRG, bool doClear = true);
 void array_render_points(int POSVBO, int COLVBO, GLuint *buffers, int quantity);
 void array_render_lines(int POSVBO, int COLVBO, GLuint *buffers, int quantity);
 void draw_wireframe(VISSTATE *clientState, GLint *starts, GLint *sizes);
-void plot_colourpick_sphere(VISSTATE *clientState);
 
 void drawHighlightLine(FCOORD endPt, ALLEGRO_COLOR *colour);
 void gather_projection_data(PROJECTDATA *pd);
\ No newline at end of file
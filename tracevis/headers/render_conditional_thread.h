@@ -24,6 +24,12 @@ Header for the thread that renders graph conditional data
 #include "thread_graph_data.h"
 #include "base_thread.h"
 
+//palette entries of the conditional node colours
+#define COND_PALETTE_INVISIBLE 0
+#define COND_PALETTE_FAIL 1
+#define COND_PALETTE_SUCCEED 2
+#define COND_PALETTE_BOTH 3
+
 class conditional_renderer : public base_thread
 {
 public:
@@ -34,13 +40,20 @@ public:
 	PROCESS_DATA *piddata = 0;
 	VISSTATE *clientState;
 	void setUpdateDelay(int delay) { updateDelayMS = delay; }
+	//colours a graph once without starting the thread, for headless rendering
+	bool render_once(thread_graph_data *graph);
 
 private:
 	void main_loop();
 	thread_graph_data *thisgraph;
 	int updateDelayMS = 200;
 	
+	void load_colours();
 	bool render_graph_conditional(thread_graph_data *graph);
+	unsigned char condition_index(int condStatus);
+	//state each node was last drawn with
+	map<thread_graph_data *, vector<int>> drawnStates;
+	vector<unsigned int> dirtyNodes;
 
 	float invisibleCol[4];
 	float failOnlyCol[4];
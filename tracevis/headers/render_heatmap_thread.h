@@ -32,6 +32,19 @@ struct COLSTRUCT {
 	float a;
 };
 
+//full render after this fraction of the edges have been recoloured in place
+#define HEAT_REBIN_FRACTION 0.1
+
+//colour bands from the last full render of a graph, for recolouring edges in place
+struct HEAT_BINNING {
+	//every weight came from the trace handler's counts, so changed edges don't need a solve
+	bool exact = false;
+	//lowest weight of each colour after the first
+	vector<unsigned long> cuts;
+	unsigned long binnedEdges = 0;
+	unsigned long recolouredEdges = 0;
+};
+
 class heatmap_renderer : public base_thread
 {
 public:
@@ -41,12 +54,31 @@ public:
 	PROCESS_DATA *piddata = 0;
 	VISSTATE *clientState;
 	void setUpdateDelay(int delay) { updateDelayMS = delay; }
+	//colours a graph once without starting the thread, for headless rendering
+	bool render_once(thread_graph_data *graph);
 
 private:
 	void main_loop();
+	void load_colours();
 	int updateDelayMS = 200;
 	thread_graph_data *thisgraph;
 	bool render_graph_heatmap(thread_graph_data *graph, bool verbose = false);
+	bool update_graph_heatmap(thread_graph_data *graph);
+	map<thread_graph_data *, HEAT_BINNING> binnings;
+	//edges changed since the last pass over a graph
+	vector<NODEPAIR> dirtyEdges;
+	bool build_window_heat(thread_graph_data *graph);
+	//executions of each node in the heat window of the graph being rendered
+	vector<unsigned long> windowExecs;
 	vector<COLSTRUCT> colourRange;
 
+	//kept between renders so their storage is reused
+	//sorted distinct edge weights of the graph being rendered
+	vector<unsigned long> heatValues;
+	//weight and first vertex of each rendered edge
+	vector<unsigned long> edgeHeats;
+	vector<unsigned int> edgeVertStarts;
+	//palette index of each line vertex, published to the graph's layer in one go
+	vector<unsigned char> heatIndices;
+
 };
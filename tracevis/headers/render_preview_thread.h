@@ -34,5 +34,8 @@ public:
 
 private:
 	void main_loop();
+	//gives each graph some of the budget, in proportion to its backlog
+	void render_share(vector<pair<thread_graph_data *, unsigned long>> *backlogs, unsigned long *budget);
+	unsigned long shareRotation = 0;
 
 };
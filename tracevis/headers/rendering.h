@@ -31,19 +31,24 @@ Miscellaneous graphics routines that don't fit into the graph class
 //takes the vertex data structure vertdata, start and end coordinate, colour, type, scaling factors and places resulting array position in arraypos
 //not a nice call
 int drawCurve(GRAPH_DISPLAY_DATA *vertdata, FCOORD *startC, FCOORD *endC, ALLEGRO_COLOR *colour, int edgetype, MULTIPLIERS *dimensions, int *arraypos);
+//renders a run of edges onto linedata in order, split over the geometry worker threads
+//sets the vertSize/arraypos of each edge unless drawing a preview
+void draw_edge_batch(thread_graph_data *graph, vector<pair<NODEPAIR, edge_data *>> *edges,
+	GRAPH_DISPLAY_DATA *linedata, map<int, ALLEGRO_COLOR> *lineColours, bool preview);
 
 //wireframe starts/sizes are the opengl vertex array positions/offsets
 void maintain_draw_wireframe(VISSTATE *clientState, GLint *wireframeStarts, GLint *wireframeSizes);
 void plot_wireframe(VISSTATE *clientState);
 void performMainGraphDrawing(VISSTATE *clientState, map <PID_TID, vector<EXTTEXT>> *externFloatingText);
 
-int add_node(node_data *n, GRAPH_DISPLAY_DATA *vertdata, 
-	GRAPH_DISPLAY_DATA *animvertdata, MULTIPLIERS *dimensions, map<int, ALLEGRO_COLOR> *nodeColours);
+ALLEGRO_COLOR *node_colour(node_data *n, map<int, ALLEGRO_COLOR> *nodeColours);
 int draw_new_nodes(thread_graph_data *graph, GRAPH_DISPLAY_DATA *vertsdata, map<int, ALLEGRO_COLOR> *nodeColours);
 void rescale_nodes(thread_graph_data *graph, bool isPreview);
 
 void render_static_graph(thread_graph_data *graph, VISSTATE *clientState);
-int render_preview_graph(thread_graph_data *activeGraph, VISSTATE *clientState);
+void render_lod_graph(thread_graph_data *graph, VISSTATE *clientState);
+//renders new nodes and up to maxEdges new edges
+int render_preview_graph(thread_graph_data *activeGraph, VISSTATE *clientState, unsigned long maxEdges);
 void display_graph(VISSTATE *clientState, thread_graph_data *graph, PROJECTDATA *pd);
 void display_big_heatmap(VISSTATE *clientState);
 void display_big_conditional(VISSTATE *clientState);
@@ -0,0 +1,114 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Checkpoints over the block sequence of a thread so replay can seek without stepping
+Built one entry at a time by the sequence's writer, read without locking
+*/
+#pragma once
+#include "stdafx.h"
+#include "execution_sequence.h"
+
+//sequence entries between checkpoints, bounds the walk done by a seek
+#define REPLAY_CHECKPOINT_INTERVAL 1024
+//checkpoints between full call count snapshots
+#define REPLAY_KEYFRAME_INTERVAL 64
+
+//replay state at the start of a sequence entry
+struct REPLAY_CHECKPOINT {
+	unsigned long sequenceIndex = 0;
+	//instructions executed before sequenceIndex, loop iterations included
+	unsigned long instructionIndex = 0;
+	//loops started before sequenceIndex
+	unsigned int loopsPlayed = 0;
+	//executions of block-ending nodes since the previous checkpoint
+	vector<pair<unsigned int, unsigned long>> callDelta;
+	//complete counts, only on keyframes
+	map<unsigned int, unsigned long> callCounts;
+};
+
+class replay_index
+{
+public:
+	//lastNode is the node that calls any externs the block makes
+	void add_entry(unsigned int insCount, unsigned int loopID, unsigned long iterations, unsigned int lastNode);
+	//entries indexed so far, for the writer
+	unsigned long size() { return entries; }
+
+	bool empty() { return checkpoints.empty(); }
+	//nearest checkpoint at or before the position
+	unsigned long checkpoint_before_sequence(unsigned long seqIdx);
+	unsigned long checkpoint_before_instruction(unsigned long insIdx);
+	const REPLAY_CHECKPOINT &checkpoint(unsigned long checkpointIdx) { return checkpoints.at(checkpointIdx); }
+	//per node execution counts at a checkpoint, in the form of thread_graph_data::callCounter
+	void call_counts(unsigned long checkpointIdx, map<unsigned int, unsigned long> *counts);
+
+private:
+	void add_checkpoint();
+
+	chunked_list<REPLAY_CHECKPOINT, 6> checkpoints;
+	unsigned long entries = 0;
+	unsigned long instructions = 0;
+	unsigned int loopsStarted = 0;
+	unsigned int lastLoopID = 0;
+
+	map<unsigned int, unsigned long> pendingCalls;
+	map<unsigned int, unsigned long> totalCalls;
+};
+
+//supplies the node ending each sequence entry to a seek
+class replay_nodes
+{
+public:
+	virtual unsigned int get_last_node(unsigned long sequenceId) = 0;
+};
+
+//position of a replay in the block sequence
+//blocks are counted as they are left, so callCounter always holds the executions of
+//the entries before sequenceIndex - the same counts a seek rebuilds from the index
+class replay_cursor
+{
+public:
+	void reset();
+	//moves on one block, iterating loops. executed is set to the block that was played
+	bool advance(execution_sequence *sequence, unsigned long *executed);
+	//jumps to the start of targetSeq, or of the loop holding it
+	bool seek(execution_sequence *sequence, replay_index *index, replay_nodes *nodes, unsigned long targetSeq);
+	//first entry of the loop containing seqIdx
+	static unsigned long loop_start(execution_sequence *sequence, unsigned long seqIdx);
+
+	//which BB we are pointing to in the sequence list
+	unsigned long sequenceIndex = 0;
+	//position out of all the instructions instrumented
+	unsigned long animInstructionIndex = 0;
+	unsigned int loopsPlayed = 0;
+
+	bool looping = false;
+	//record how many times each block in loop has been animated
+	vector<unsigned long> animLoopProgress;
+	//index into sequence where start of loop is
+	unsigned long animLoopStartIdx = 0;
+	//current progress animating loop
+	unsigned long animLoopIndex = 0;
+	unsigned long loopIteration = 0;
+	unsigned long targetIterations = 0;
+
+	//number of times each node executed, used for tracking which extern arg to display
+	map <unsigned int, unsigned long> callCounter;
+
+private:
+	void end_loop();
+};
@@ -0,0 +1,28 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Headless save inspector
+Streams a save section by section and prints summary statistics without building graphs
+*/
+#pragma once
+#include "stdafx.h"
+#include "GUIStructs.h"
+
+//big read buffer so we are limited by the disk rather than the stream
+#define INSPECT_READ_BUFSIZE (4 * 1024 * 1024)
+
+bool inspect_save(VISSTATE *clientState, string filename, unsigned int topN);
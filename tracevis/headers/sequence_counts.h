@@ -0,0 +1,54 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Running execution totals of each block over a thread's sequence
+Answers how many times each block ran between two sequence positions
+*/
+#pragma once
+#include "stdafx.h"
+#include "execution_sequence.h"
+
+//sequence entries between checkpoints, bounds the walk done at each end of a window
+#define SEQCOUNT_CHECKPOINT_INTERVAL 1024
+
+class sequence_counts
+{
+public:
+	//catch up with entries appended since the last call
+	void index(execution_sequence *sequence);
+	//executions of every block run in sequence range [start, end), loop iterations included
+	void window_counts(execution_sequence *sequence, unsigned long start, unsigned long end, 
+		map<BLOCK_HANDLE, unsigned long> *counts);
+	unsigned long size() { return indexed; }
+
+private:
+	//executions of the block before checkpoint checkpointIdx
+	unsigned long checkpoint_total(BLOCK_HANDLE handle, unsigned long checkpointIdx);
+	//executions of each block from the checkpoint before seqIdx up to seqIdx
+	void count_from_checkpoint(execution_sequence *sequence, unsigned long seqIdx, map<BLOCK_HANDLE, unsigned long> *counts);
+
+	//by block handle: <checkpoint, executions of the block before it>
+	//only for checkpoints the block ran in the interval before
+	vector<vector<pair<unsigned long, unsigned long>>> checkpoints;
+	//executions of each block so far
+	vector<unsigned long> totals;
+	//blocks run since the last checkpoint
+	vector<BLOCK_HANDLE> touched;
+	//handles that have been run, so a window doesn't walk the whole table
+	vector<BLOCK_HANDLE> seenHandles;
+	unsigned long indexed = 0;
+};
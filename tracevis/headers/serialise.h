@@ -34,14 +34,15 @@ Graph/Process Saving/Loading routines
 #define tag_DISAS 44
 
 void writetag(ofstream *file, char tag, int id = 0);
-void saveProcessData(PROCESS_DATA *piddata, ofstream *file);
+void saveProcessData(PROCESS_DATA *piddata, ofstream *file, string saveDir);
 void saveTrace(VISSTATE * clientState);
 bool verifyTag(ifstream *file, char tag, int id = 0);
 
 int extractb64path(ifstream *file, unsigned long *modNum, string *modpath, string endTag);
 
 int extractmodsyms(stringstream *blob, int modnum, PROCESS_DATA* piddata);
-bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddata);
+//saveDir is the directory of the save file, its module cache is looked for there
+bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddata, string saveDir);
 bool loadProcessGraphs(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddata);
 
 //save every graph in activePid
@@ -0,0 +1,50 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Headless graph images
+Rasterises the vertex data of a graph on the CPU so saves can be drawn on machines without opengl
+*/
+#pragma once
+#include "stdafx.h"
+#include "GUIStructs.h"
+
+//same as the main display
+#define SNAPSHOT_FOV 45
+#define SNAPSHOT_NEAR 500
+//space left around the sphere when it is fitted to the image
+#define SNAPSHOT_FIT_MARGIN 1.05
+//rows of the image drawn as one piece of work
+#define SNAPSHOT_BAND_ROWS 16
+
+//RGBA bytes, top row first
+struct SNAPSHOT_IMAGE {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	vector<unsigned char> pixels;
+};
+
+//draws the nodes then edges of a rendered graph in one of the SNAPSHOT_ display modes
+//heatmap/conditional colours must already be built
+void render_snapshot(thread_graph_data *graph, SNAPSHOT_VIEW *view, int mode, SNAPSHOT_IMAGE *image);
+bool write_ppm(SNAPSHOT_IMAGE *image, string path);
+//through an allegro memory bitmap, so doesn't need a display
+bool write_png(SNAPSHOT_IMAGE *image, string path);
+
+//loads every thread graph in a save and writes images of them in the modes of view
+bool snapshot_save(VISSTATE *clientState, string savefile, SNAPSHOT_VIEW *view);
+//default name for an image of a thread, next to the save it came from
+string snapshot_path(string savefile, PID_TID TID, int mode, bool png);
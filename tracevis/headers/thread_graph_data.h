@@ -25,6 +25,10 @@ Monsterous class that handles the bulk of graph management
 #include "graph_display_data.h"
 #include "traceMisc.h"
 #include "OSspecific.h"
+#include "replay_index.h"
+#include "sequence_counts.h"
+#include "graph_lod.h"
+#include "node_grid.h"
 
 //max length to display in diff summary
 #define MAX_DIFF_PATH_LENGTH 50
@@ -40,7 +44,23 @@ struct EXTERNCALLDATA {
 	bool drawFloating = false;
 };
 
-class thread_graph_data
+//a lit edge and where its colours were in the anim lines when it was lit
+struct ANIM_EDGE {
+	NODEPAIR edge;
+	unsigned long firstVert;
+	unsigned int verts;
+};
+
+//nodes and edges of one block as executed by this thread, looked up once for animation
+struct BLOCK_SPAN {
+	vector<unsigned int> nodes;
+	//edges between consecutive nodes, may be short if the block faulted
+	vector<edge_data *> internalEdges;
+	//<first node of a following block, edge to it>
+	vector<pair<unsigned int, edge_data *>> exits;
+};
+
+class thread_graph_data : public replay_nodes
 {
 	GRAPH_DISPLAY_DATA *mainnodesdata = 0;
 	GRAPH_DISPLAY_DATA *mainlinedata = 0;
@@ -58,9 +78,25 @@ class thread_graph_data
 	HANDLE disassemblyMutex;
 
 	//these are the edges/nodes that are brightend in the animation
-	map <NODEPAIR, edge_data *> activeEdgeMap;
-	//<index, final (still active) node>
-	map <unsigned int, bool> activeNodeMap;
+	//compact lists so fading costs the number of lit elements, flags stop duplicates
+	//edges are flagged by their first anim line vertex, looked up again only when the lines are rebuilt
+	vector <ANIM_EDGE> activeEdges;
+	vector <bool> activeEdgeFlags;
+	unsigned int activeEdgeGeneration = 0;
+	vector <unsigned int> activeNodes;
+	vector <bool> activeNodeFlags;
+	void activate_anim_edge(NODEPAIR edgePair, edge_data *e);
+	void relocate_anim_edges();
+	void activate_anim_node(unsigned int nodeIdx);
+	void clear_anim_active();
+
+	//by sequence block handle. only touched by the animation
+	vector<BLOCK_SPAN *> blockSpans;
+	BLOCK_SPAN faultedSpan;
+	//block address, blockID -> node, for block nodes
+	map<pair<MEM_ADDRESS, BLOCK_IDENTIFIER>, unsigned int> blockNodeIndex;
+	BLOCK_SPAN *get_block_span(unsigned long seqIdx);
+	edge_data *get_span_exit(BLOCK_SPAN *span, unsigned int targetNode);
 
 
 #ifdef XP_COMPATIBLE
@@ -83,6 +119,7 @@ class thread_graph_data
 
 	bool advance_sequence(bool);
 	bool decrease_sequence();
+	void index_replay();
 
 	bool loadEdgeDict(ifstream *file);
 	bool loadExterns(ifstream *file);
@@ -91,9 +128,16 @@ class thread_graph_data
 	bool loadStats(ifstream *file);
 	bool loadAnimationData(ifstream *file);
 	bool loadCallSequence(ifstream *file);
+	bool loadEdgeCounts(ifstream *file);
+	void saveDisplayBuffers(ofstream *file);
+	bool loadDisplayBuffers(ifstream *file);
+
+	pair<unsigned long, unsigned long> heatWindow = make_pair(0, 0);
 
-	//which BB we are pointing to in the sequence list
-	unsigned long sequenceIndex = 0;
+	HANDLE dirtyMutex = CreateMutex(NULL, FALSE, NULL);
+	vector<NODEPAIR> heatDirtyEdges;
+	unsigned long countUpdates = 0;
+	vector<unsigned int> conditionalDirtyNodes;
 	//which instruction we are pointing to in the BB
 	unsigned long blockInstruction = 0;
 	bool newanim = true;
@@ -114,12 +158,17 @@ public:
 
 	void display_active(bool showNodes, bool showEdges);
 	void display_static(bool showNodes, bool showEdges);
+	//draws the groups of the level the lod last built
+	void display_lod(bool showNodes, bool showEdges);
 
 	void acquireNodeReadLock() { getNodeReadLock(); }
 	void releaseNodeReadLock() { dropNodeReadLock(); }
 
 	int render_edge(NODEPAIR ePair, GRAPH_DISPLAY_DATA *edgedata, map<int, ALLEGRO_COLOR> *lineColours,
 		ALLEGRO_COLOR *forceColour = 0, bool preview = false);
+	//for edges looked up beforehand, doesn't touch the edge dictionary
+	int render_edge(NODEPAIR ePair, edge_data *e, GRAPH_DISPLAY_DATA *edgedata, map<int, ALLEGRO_COLOR> *lineColours,
+		ALLEGRO_COLOR *forceColour = 0, bool preview = false);
 	
 	bool edge_exists(NODEPAIR edge, edge_data **edged);
 	void add_edge(edge_data e, node_data *source, node_data *target);
@@ -131,14 +180,23 @@ public:
 	GRAPH_DISPLAY_DATA *get_previewnodes() { return previewnodes; }
 	GRAPH_DISPLAY_DATA *get_activelines() { return animlinedata; }
 	GRAPH_DISPLAY_DATA *get_activenodes() { return animnodesdata; }
+	PROCESS_DATA *get_piddata() { return piddata; }
 	void render_new_edges(bool doResize, map<int, ALLEGRO_COLOR> *lineColoursArr);
 
 	unsigned int fill_extern_log(ALLEGRO_TEXTLOG *textlog, unsigned int logSize);
 
-	bool serialise(ofstream *file);
+	//saveBuffers also writes rendered geometry so loads don't have to regenerate it
+	bool serialise(ofstream *file, bool saveBuffers);
 	bool unserialise(ifstream *file, map <MEM_ADDRESS, INSLIST> *disassembly);
 	//string get_mod_name(map <int, string> *modpaths);
 	bool basic = false;
+	//edge executionCounts were recorded by the trace handler. false for saves made before they were
+	bool edgeCounts = true;
+	//each node is a whole basic block rather than an instruction
+	bool blockNodes = false;
+	bool find_block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, unsigned int *nodeIdx);
+	void add_block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, unsigned int nodeIdx);
+	bool extend_block_node(unsigned int nodeIdx, INSLIST *block, unsigned int insCount);
 
 	//these are called a lot. make sure as efficient as possible
 	inline edge_data *get_edge(NODEPAIR edge);
@@ -159,6 +217,9 @@ public:
 
 	void start_edgeL_iteration(EDGELIST::iterator *edgeIt, EDGELIST::iterator *edgeEnd);
 	void stop_edgeL_iteration();
+	//copies up to maxEdges of the edge list from index first, returns number copied
+	unsigned long copy_edge_range(unsigned long first, unsigned long maxEdges,
+		vector<pair<NODEPAIR, edge_data *>> *edges);
 
 	//i feel like this misses the point, idea is to iterate safely
 	EDGELIST *edgeLptr() { return &edgeList; } 
@@ -166,6 +227,7 @@ public:
 	void animate_latest(float fadeRate);
 
 	INS_DATA* get_last_instruction(unsigned long sequenceId);
+	unsigned int get_last_node(unsigned long sequenceId);
 	string get_node_sym(unsigned int idx, PROCESS_DATA* piddata);
 
 	//if block at targetSequence called something, this highlights it. if sendArg true, adds floating latest arg to animation
@@ -175,6 +237,11 @@ public:
 	void reset_mainlines();
 	unsigned int derive_anim_node();
 	void performStep(int stepSize, bool skipLoop);
+	//jump replay to the start of a block or the block holding an instruction
+	//positions inside loops go to the start of the loop
+	bool seek_sequence(unsigned long targetSeq);
+	bool seek_instruction(unsigned long targetIns);
+	unsigned long get_sequence_index() { return replay.sequenceIndex; }
 	unsigned int updateAnimation(unsigned int updateSize, bool animationMode, bool skipLoop);
 	VCOORD *get_active_node_coord();
 	void set_active_node(unsigned int idx);
@@ -215,16 +282,12 @@ public:
 	string modPath;
 
 	HANDLE funcQueueMutex = CreateMutex(NULL, FALSE, NULL);
-	//number of times each extern called, used for tracking which arg to display
-	map <unsigned int, unsigned long> callCounter;
 
 	//keep track of graph dimensions
 	int maxA = 0;
 	int maxB = 0;
 	long zoomLevel = 0;
 
-	unsigned long vertResizeIndex = 0;
-
 	MULTIPLIERS *m_scalefactors = NULL;
 	MULTIPLIERS *p_scalefactors = NULL;
 
@@ -232,6 +295,18 @@ public:
 	bool needVBOReload_main = true;
 	GLuint graphVBOs[4] = { 0,0,0,0 };
 
+	//blocks/functions/modules for drawing zoomed out. only used by the main graph render thread
+	graph_lod *lod = 0;
+	//adds edges drawn since the last call to the lod
+	void update_lod();
+	bool needVBOReload_lod = true;
+	GLuint lodVBOs[4] = { 0,0,0,0 };
+
+	//drawn nodes by position on the sphere, for text and mouseover. only used by the main display thread
+	node_grid *nodeGrid = 0;
+	//set by the render thread when it rescales the drawn nodes
+	bool nodesMoved = false;
+
 	HANDLE graphwritingMutex = CreateMutex(NULL, FALSE, NULL);
 	
 	bool isGraphBusy();
@@ -241,6 +316,8 @@ public:
 	//node+edge col+pos
 	bool needVBOReload_preview = true;
 	bool previewNeedsResize = false;
+	//in the scrolled part of the preview pane, set by the main display thread
+	bool previewVisible = true;
 	GLuint previewVBOs[4] = { 0,0,0,0 };
 	GRAPH_DISPLAY_DATA *previewnodes = 0;
 	GRAPH_DISPLAY_DATA *previewlines = 0;
@@ -249,40 +326,40 @@ public:
 	//lowest/highest numbers of edge iterations
 	pair<unsigned long,unsigned long> heatExtremes;
 	GLuint heatmapEdgeVBO[1] = { 0 };
-	GRAPH_DISPLAY_DATA *heatmaplines = 0;
+	PALETTE_LAYER *heatmaplines = 0;
+	//limit heat to executions in sequence range [start, end). end of 0 for the whole trace
+	void set_heat_window(unsigned long start, unsigned long end);
+	pair<unsigned long, unsigned long> get_heat_window();
+	bool heatWindowChanged = false;
+	//running block totals for windowed heat, only used by the heatmap thread
+	sequence_counts heatWindowCounts;
+	//edges whose execution count changed, published by the trace handler for the heatmap thread
+	void mark_heat_dirty(vector<NODEPAIR> *edges);
+	void take_heat_dirty(vector<NODEPAIR> *edges);
+	//goes up each time counts are published, for anyone else that shows them
+	unsigned long get_count_updates();
 
 	bool needVBOReload_conditional = true;
 	//number of taken, not taken conditionals
 	pair<unsigned long, unsigned long> condCounts;
+	//nodes whose conditional state changed after they were added
+	void take_conditional_dirty(vector<unsigned int> *nodes);
 	GLuint conditionalVBOs[2] = { 0 };
-	GRAPH_DISPLAY_DATA *conditionallines = 0;
-	GRAPH_DISPLAY_DATA *conditionalnodes = 0;
-
-	//todo: make private, add inserter
-	vector <pair<MEM_ADDRESS,unsigned int>> bbsequence; //block address, number of instructions
-	vector <BLOCK_IDENTIFIER> mutationSequence; //blockID
-
-	//<which loop this is, how many iterations of this block>
-	//todo: make private, add inserter
-	vector <pair<unsigned int, unsigned long>> loopStateList;
-
-	//record how many times each block in loop has been animated
-	vector<unsigned long> animLoopProgress;
-	//index into sequence where start of loop is
-	unsigned long animLoopStartIdx = 0;
-	//current progress animating loop
-	unsigned long animLoopIndex = 0;
+	PALETTE_LAYER *conditionallines = 0;
+	PALETTE_LAYER *conditionalnodes = 0;
+
+	//blocks executed in order + loop state. appended by the trace handler only
+	execution_sequence *blockSequence = 0;
+	//checkpoints over the sequence, appended with it
+	replay_index replayIndex;
+	//position and loop progress of the replay
+	replay_cursor replay;
+
 	//total number of individual loops
 	unsigned int loopCounter = 0;
 
-	//position out of all the instructions instrumented
-	unsigned long animInstructionIndex = 0;
 	unsigned long totalInstructions = 0;
 
-	unsigned int loopsPlayed = 0;
-	unsigned long loopIteration = 0;
-	unsigned long targetIterations = 0;
-
 	bool needVBOReload_active = true;
 	//two sets of VBOs for graph so we can display one
 	//while the other is being written
@@ -70,6 +70,7 @@ Constants used to interpret and plot the trace data
 #define RETURNA_OFFSET -4
 #define RETURNB_OFFSET 3
 
+//stored args start with one of these markers, base64 contents are decoded on display
 #define ARG_NOTB64 '0'
 #define ARG_BASE64 '1'
 
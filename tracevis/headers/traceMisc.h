@@ -31,5 +31,8 @@ int extract_pid_tid(char *char_buf, string marker, PID_TID *target);
 int caught_stoi(string s, int *result, int base);
 int caught_stoi(string s, unsigned int *result, int base);
 int caught_stoul(string s, unsigned long *result, int base);
+int caught_stof(string s, float *result);
 
-string generate_funcArg_string(string sym, ARGLIST args);
\ No newline at end of file
+string generate_funcArg_string(string sym, ARGLIST args);
+//decode a stored (marker prefixed) arg for display
+string stored_arg_contents(const string *storedArg);
\ No newline at end of file
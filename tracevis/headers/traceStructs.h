@@ -23,6 +23,7 @@ Structures used to represent the disassembly
 #include "traceConstants.h"
 #include "OSspecific.h"
 #include "b64.h"
+#include "execution_sequence.h"
 
 /*
 Pinched from Boost
@@ -153,6 +154,8 @@ public:
 	//list of basic blocks
 	//   address		    blockID			instructionlist
 	map <MEM_ADDRESS, map<BLOCK_IDENTIFIER, INSLIST *>> blocklist;
+	//blocks referenced by the execution sequences of all threads
+	block_table sequenceBlocks;
 
 	map <int,int> activeMods;
 	map <MEM_ADDRESS, BB_DATA *> externdict;
@@ -53,6 +53,8 @@ struct BLOCKREPEAT {
 	unsigned int insCount = 0;
 	vector<pair<MEM_ADDRESS, BLOCK_IDENTIFIER>> targBlocks;
 	unsigned long totalExecs;
+	//executions can be attributed to the exit edge
+	bool singleTarget = false;
 	INSLIST *blockInslist = 0;
 };
 
@@ -76,6 +78,8 @@ public:
 	timeline *timelinebuilder;
 	thread_trace_reader *reader;
 	bool basicMode = false;
+	//add a node per basic block rather than per instruction
+	bool blockMode = false;
 	void set_max_arg_storage(unsigned int maxargs) { arg_storage_capacity = maxargs; }
 	bool *saveFlag;
 
@@ -99,25 +103,36 @@ private:
 	bool run_external(MEM_ADDRESS targaddr, unsigned long repeats, NODEPAIR *resultPair);
 
 	void runBB(TAG *tag, int startIndex, int repeats);
+	void run_block_node(TAG *tag, unsigned int numInstructions, unsigned long repeats, bool faulted);
+	char block_entry_class(bool alreadyExecuted);
 	void run_faulting_BB(TAG *tag);
 
 	void positionVert(int *pa, int *pb, int *pbMod, MEM_ADDRESS address);
 	void updateStats(int a, int b, unsigned int bMod);
 
 	bool set_target_instruction(INS_DATA *instruction);
-	void handle_new_instruction(INS_DATA *instruction, BLOCK_IDENTIFIER blockID, unsigned long repeats);
+	void handle_new_instruction(INS_DATA *instruction, BLOCK_IDENTIFIER blockID, unsigned long repeats, MEM_ADDRESS entryAddress);
 	//void handle_existing_instruction(INS_DATA *instruction);
 	bool get_extern_at_address(MEM_ADDRESS address, BB_DATA ** BB, int attempts);
 	bool find_internal_at_address(MEM_ADDRESS address, int attempts);
 
 	INSLIST *find_block_disassembly(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID);
+	bool block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, bool blockEnd, unsigned int *nodeIdx);
 
 	void handle_tag(TAG *thistag, unsigned long repeats);
 	void handle_exception_tag(TAG *thistag);
+	BLOCK_HANDLE sequence_handle(TAG *thistag);
 
 	int find_containing_module(MEM_ADDRESS address);
 	void dump_loop();
 	bool assign_blockrepeats();
+	void count_repeat_edge(NODEPAIR edgePair, edge_data *edge, BLOCKREPEAT *repeat);
+	void edge_count_changed(NODEPAIR edgePair, edge_data *edge);
+	void publish_dirty_edges();
+	//edges with changed counts not yet given to the graph
+	vector<NODEPAIR> dirtyEdges;
+	vector<edge_data *> dirtyEdgePtrs;
+	void attribute_loop_edges(bool entered, unsigned int entryVert);
 
 	vector <BLOCKREPEAT> blockRepeatQueue;
 	DWORD64 lastRepeatUpdate = GetTickCount64();
@@ -147,5 +162,7 @@ private:
 	vector<TAG> loopCache;
 	NODEPAIR repeatStart;
 	NODEPAIR repeatEnd;
+	//handles this thread has already got from the process block table, saves taking its lock
+	map<SEQUENCE_BLOCK_KEY, BLOCK_HANDLE> sequenceHandles;
 	unsigned int arg_storage_capacity = 100;
 };
\ No newline at end of file
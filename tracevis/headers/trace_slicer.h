@@ -0,0 +1,32 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Trace slicing
+Cuts a window of one thread's block sequence out of a save into a standalone save
+*/
+#pragma once
+#include "stdafx.h"
+#include "GUIStructs.h"
+
+#define SLICE_READ_BUFSIZE (4 * 1024 * 1024)
+
+//writes the blocks, nodes, edges, externs and args touched by sequence entries [start, end) of thread TID
+//nodes are renumbered in order of first execution and counts only cover the window
+bool slice_trace(VISSTATE *clientState, string savefile, PID_TID TID, unsigned long start, unsigned long end, string outfile);
+
+//default name for a slice, next to the save it was cut from
+string slice_path(string savefile, PID_TID TID, unsigned long start, unsigned long end);
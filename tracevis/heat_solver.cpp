@@ -0,0 +1,177 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Edge execution solver for the heatmap
+*/
+#include "stdafx.h"
+#include "heat_solver.h"
+
+unsigned long heat_solver::add_edge(unsigned int source, unsigned int target)
+{
+	HEAT_EDGE edge;
+	edge.source = source;
+	edge.target = target;
+	edges.push_back(edge);
+	return edges.size() - 1;
+}
+
+unsigned long heat_solver::add_counted_edge(unsigned int source, unsigned int target, unsigned long weight)
+{
+	HEAT_EDGE edge;
+	edge.source = source;
+	edge.target = target;
+	edge.weight = weight;
+	edge.solved = true;
+	edges.push_back(edge);
+	return edges.size() - 1;
+}
+
+//counting sort of edge numbers by source and by target
+void heat_solver::build_adjacency()
+{
+	unsigned int numNodes = heat->size();
+	inStart.assign(numNodes + 1, 0);
+	outStart.assign(numNodes + 1, 0);
+
+	vector<HEAT_EDGE>::iterator edgeIt = edges.begin();
+	for (; edgeIt != edges.end(); ++edgeIt)
+	{
+		++outStart[edgeIt->source + 1];
+		++inStart[edgeIt->target + 1];
+	}
+	for (unsigned int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+	{
+		unsolvedOut[nodeIdx] = outStart[nodeIdx + 1];
+		unsolvedIn[nodeIdx] = inStart[nodeIdx + 1];
+		outStart[nodeIdx + 1] += outStart[nodeIdx];
+		inStart[nodeIdx + 1] += inStart[nodeIdx];
+	}
+
+	edgesOut.resize(edges.size());
+	edgesIn.resize(edges.size());
+	vector<unsigned long> outPos(outStart.begin(), outStart.end() - 1);
+	vector<unsigned long> inPos(inStart.begin(), inStart.end() - 1);
+	for (unsigned long edgeIdx = 0; edgeIdx < edges.size(); ++edgeIdx)
+	{
+		edgesOut[outPos[edges[edgeIdx].source]++] = edgeIdx;
+		edgesIn[inPos[edges[edgeIdx].target]++] = edgeIdx;
+	}
+}
+
+//take counted edges out of the unknowns before anything is queued
+void heat_solver::apply_counted_edges()
+{
+	vector<HEAT_EDGE>::iterator edgeIt = edges.begin();
+	for (; edgeIt != edges.end(); ++edgeIt)
+	{
+		if (!edgeIt->solved) continue;
+		++solvedEdges;
+		remainingOut[edgeIt->source] -= edgeIt->weight;
+		remainingIn[edgeIt->target] -= edgeIt->weight;
+		--unsolvedOut[edgeIt->source];
+		--unsolvedIn[edgeIt->target];
+	}
+}
+
+void heat_solver::queue_node(unsigned int nodeIdx)
+{
+	if (queued[nodeIdx]) return;
+	queued[nodeIdx] = true;
+	worklist.push_back(nodeIdx);
+}
+
+void heat_solver::set_weight(unsigned long edgeIdx, long long weight)
+{
+	HEAT_EDGE *edge = &edges[edgeIdx];
+	//a negative remainder is recorded as a residual when the node is checked
+	edge->weight = (weight > 0) ? (unsigned long)weight : 0;
+	edge->solved = true;
+	++solvedEdges;
+
+	remainingOut[edge->source] -= weight;
+	remainingIn[edge->target] -= weight;
+	if (--unsolvedOut[edge->source] == 1) queue_node(edge->source);
+	if (--unsolvedIn[edge->target] == 1) queue_node(edge->target);
+}
+
+void heat_solver::solve_node(unsigned int nodeIdx)
+{
+	queued[nodeIdx] = false;
+
+	if (unsolvedOut[nodeIdx] == 1)
+		for (unsigned long i = outStart[nodeIdx]; i < outStart[nodeIdx + 1]; ++i)
+			if (!edges[edgesOut[i]].solved)
+			{
+				set_weight(edgesOut[i], remainingOut[nodeIdx]);
+				break;
+			}
+
+	if (unsolvedIn[nodeIdx] == 1)
+		for (unsigned long i = inStart[nodeIdx]; i < inStart[nodeIdx + 1]; ++i)
+			if (!edges[edgesIn[i]].solved)
+			{
+				set_weight(edgesIn[i], remainingIn[nodeIdx]);
+				break;
+			}
+}
+
+//each node is queued when a side drops to one unknown edge and each edge is solved once: O(V+E)
+void heat_solver::solve(unsigned int entryNode, unsigned int finalNode)
+{
+	unsigned int numNodes = heat->size();
+	remainingIn.resize(numNodes);
+	remainingOut.resize(numNodes);
+	unsolvedIn.resize(numNodes);
+	unsolvedOut.resize(numNodes);
+	queued.assign(numNodes, false);
+	for (unsigned int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+		remainingIn[nodeIdx] = remainingOut[nodeIdx] = heat->at(nodeIdx);
+	//the thread starts here rather than following an edge in
+	if (entryNode < numNodes && remainingIn[entryNode])
+		--remainingIn[entryNode];
+	//the thread ends here rather than following an edge out
+	if (finalNode < numNodes && remainingOut[finalNode])
+		--remainingOut[finalNode];
+
+	build_adjacency();
+	apply_counted_edges();
+
+	for (unsigned int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+		if (unsolvedOut[nodeIdx] == 1 || unsolvedIn[nodeIdx] == 1)
+			queue_node(nodeIdx);
+
+	while (!worklist.empty())
+	{
+		unsigned int nodeIdx = worklist.back();
+		worklist.pop_back();
+		solve_node(nodeIdx);
+	}
+
+	//fully solved sides that don't balance
+	for (unsigned int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+	{
+		bool inBad = !unsolvedIn[nodeIdx] && remainingIn[nodeIdx] && inStart[nodeIdx + 1] != inStart[nodeIdx];
+		bool outBad = !unsolvedOut[nodeIdx] && remainingOut[nodeIdx] && outStart[nodeIdx + 1] != outStart[nodeIdx];
+		if (!inBad && !outBad) continue;
+
+		HEAT_RESIDUAL residual;
+		residual.node = nodeIdx;
+		residual.inResidual = inBad ? remainingIn[nodeIdx] : 0;
+		residual.outResidual = outBad ? remainingOut[nodeIdx] : 0;
+		residuals.push_back(residual);
+	}
+}
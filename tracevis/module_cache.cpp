@@ -0,0 +1,165 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Content addressed store of module data shared between saves
+*/
+#include "stdafx.h"
+#include "module_cache.h"
+#include "basicblock_handler.h"
+#include "traceMisc.h"
+#include "OSspecific.h"
+#include "b64.h"
+
+//decoded tables seen recently, offsets relative to module base
+//only touched by save/load which run one at a time
+static map<string, map<MEM_ADDRESS, string>> symCache;
+//decoded instructions seen recently
+static map<pair<MEM_ADDRESS, string>, INS_DATA> disasCache;
+
+//FNV-1a, stable across runs unlike std::hash
+static unsigned long long fnv1a(const string *data)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < data->size(); ++i)
+	{
+		hash ^= (unsigned char)data->at(i);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+string modcache_encode_syms(map<MEM_ADDRESS, string> *syms, MEM_ADDRESS modbase)
+{
+	stringstream encoded;
+	map<MEM_ADDRESS, string>::iterator symIt = syms->begin();
+	for (; symIt != syms->end(); ++symIt)
+		encoded << (symIt->first - modbase) << "," <<
+			base64_encode((unsigned char*)symIt->second.c_str(), symIt->second.size()) << "@";
+	return encoded.str();
+}
+
+string modcache_key(string modpath, string *encodedSyms)
+{
+	stringstream key;
+	key << std::hex << setfill('0') << setw(16) << fnv1a(&modpath) << setw(16) << fnv1a(encodedSyms);
+	return key.str();
+}
+
+static string modcache_path(string saveDir, string key)
+{
+	return saveDir + MODCACHE_DIR + key + ".sym";
+}
+
+bool modcache_store(string saveDir, string key, string *encodedSyms)
+{
+	if (symCache.count(key) && fileExists(modcache_path(saveDir, key))) return true;
+
+	string cacheDir = saveDir + MODCACHE_DIR;
+	if (!fileExists(cacheDir) && !CreateDirectoryA(cacheDir.c_str(), NULL))
+	{
+		cerr << "[rgat]Warning: Could not create module cache directory " << cacheDir << endl;
+		return false;
+	}
+
+	string path = modcache_path(saveDir, key);
+	if (fileExists(path)) return true;
+
+	//write to temp name first so a partial entry is never referenced
+	string tmppath = path + ".tmp";
+	ofstream entryfile;
+	entryfile.open(tmppath.c_str(), std::ofstream::binary);
+	if (!entryfile.is_open())
+	{
+		cerr << "[rgat]Warning: Could not write module cache entry " << tmppath << endl;
+		return false;
+	}
+	entryfile << *encodedSyms;
+	entryfile.close();
+	renameFile(tmppath, path);
+	return fileExists(path);
+}
+
+static bool decode_entry(string *encodedSyms, map<MEM_ADDRESS, string> *syms)
+{
+	stringstream blob(*encodedSyms);
+	string symOffset_s, b64Sym;
+	MEM_ADDRESS symOffset;
+	while (getline(blob, symOffset_s, ','))
+	{
+		if (!caught_stoul(symOffset_s, &symOffset, 10)) {
+			cerr << "[rgat]modcache: bad symbol offset: " << symOffset_s << endl;
+			return false;
+		}
+		getline(blob, b64Sym, '@');
+		syms->emplace(symOffset, base64_decode(b64Sym));
+	}
+	return true;
+}
+
+bool modcache_load_syms(string saveDir, string key, MEM_ADDRESS modbase, int modnum, PROCESS_DATA *piddata)
+{
+	map<string, map<MEM_ADDRESS, string>>::iterator cacheIt = symCache.find(key);
+	if (cacheIt == symCache.end())
+	{
+		//missing entries are reported by the caller, which may look elsewhere
+		string path = modcache_path(saveDir, key);
+		ifstream entryfile;
+		entryfile.open(path.c_str(), std::ifstream::binary);
+		if (!entryfile.is_open()) return false;
+		stringstream entryContents;
+		entryContents << entryfile.rdbuf();
+		entryfile.close();
+
+		string encoded = entryContents.str();
+		if (modcache_key(piddata->modpaths[modnum], &encoded) != key)
+		{
+			cerr << "[rgat]ERROR: Module cache entry " << path << " does not match its key" << endl;
+			return false;
+		}
+
+		map<MEM_ADDRESS, string> decoded;
+		if (!decode_entry(&encoded, &decoded)) return false;
+		if (symCache.size() >= MODCACHE_MAX_MODULES)
+			symCache.clear();
+		cacheIt = symCache.emplace(key, decoded).first;
+	}
+
+	map<MEM_ADDRESS, string> *modsyms = &piddata->modsymsPlain[modnum];
+	map<MEM_ADDRESS, string>::iterator symIt = cacheIt->second.begin();
+	for (; symIt != cacheIt->second.end(); ++symIt)
+		modsyms->emplace_hint(modsyms->end(), symIt->first + modbase, symIt->second);
+	return true;
+}
+
+bool modcache_disassemble(csh hCapstone, string opcodes, INS_DATA *insdata, MEM_ADDRESS address)
+{
+	pair<MEM_ADDRESS, string> insKey = make_pair(address, opcodes);
+	map<pair<MEM_ADDRESS, string>, INS_DATA>::iterator disasIt = disasCache.find(insKey);
+	if (disasIt == disasCache.end())
+	{
+		INS_DATA decoded;
+		if (!disassemble_ins(hCapstone, opcodes, &decoded, address)) return false;
+		decoded.opcodes = opcodes;
+		if (disasCache.size() >= MODCACHE_MAX_INSTRUCTIONS)
+			disasCache.clear();
+		disasIt = disasCache.emplace(insKey, decoded).first;
+	}
+
+	//template has no thread or block membership so the copy starts clean
+	*insdata = disasIt->second;
+	return true;
+}
@@ -69,7 +69,11 @@ bool node_data::serialise(ofstream *outfile)
 	*outfile << external << ",";
 
 	if (!external)
+	{
 		*outfile << ins->mutationIndex;
+		if (blockInsCount)
+			*outfile << "," << blockAddress << "," << mutation << "," << blockInsCount;
+	}
 	else
 	{
 		*outfile << funcargs.size() << ","; //number of calls
@@ -80,9 +84,23 @@ bool node_data::serialise(ofstream *outfile)
 			*outfile << callIt->size() << ",";
 			for (argIt = callIt->begin(); argIt != callIt->end(); argIt++)
 			{
-				string argstring = argIt->second;
-				const unsigned char* cus_argstring = reinterpret_cast<const unsigned char*>(argstring.c_str());
-				*outfile << argIt->first << "," << base64_encode(cus_argstring, argstring.size()) << ",";
+				*outfile << argIt->first << ",";
+				string *argstring = &argIt->second;
+				if (argstring->empty())
+				{
+					*outfile << ",";
+					continue;
+				}
+
+				//args that arrived encoded can be written as they are
+				if (argstring->at(0) == ARG_BASE64 && base64_is_clean(*argstring, 1))
+					*outfile << argstring->substr(1) << ",";
+				else
+				{
+					string plainArg = stored_arg_contents(argstring);
+					const unsigned char* cus_argstring = reinterpret_cast<const unsigned char*>(plainArg.c_str());
+					*outfile << base64_encode(cus_argstring, plainArg.size()) << ",";
+				}
 			}
 		}
 	}
@@ -162,15 +180,29 @@ int node_data::unserialise(ifstream *file, map <MEM_ADDRESS, INSLIST> *disassemb
 	{
 		external = false;
 
+		//mutation index, then block address, blockID and size for block nodes
 		getline(*file, value_s, '}');
-		if (!caught_stoi(value_s, (int *)&mutation, 10))
+		stringstream insFields(value_s);
+		string field_s;
+		getline(insFields, field_s, ',');
+		if (!caught_stoi(field_s, (int *)&mutation, 10))
 			return -1;
+		unsigned int insMutation = mutation;
+
+		if (getline(insFields, field_s, ','))
+		{
+			if (!caught_stoul(field_s, &blockAddress, 10)) return -1;
+			getline(insFields, field_s, ',');
+			if (!caught_stoul(field_s, &mutation, 10)) return -1;
+			getline(insFields, field_s, ',');
+			if (!caught_stoi(field_s, (int *)&blockInsCount, 10)) return -1;
+		}
 
 		map<MEM_ADDRESS, INSLIST>::iterator addressIt = disassembly->find(address);
-		if ((addressIt == disassembly->end()) || (mutation >= addressIt->second.size()))
+		if ((addressIt == disassembly->end()) || (insMutation >= addressIt->second.size()))
 			return -1;
 
-		ins = addressIt->second.at(mutation);
+		ins = addressIt->second.at(insMutation);
 		return 1;
 	}
 
@@ -196,8 +228,8 @@ int node_data::unserialise(ifstream *file, map <MEM_ADDRESS, INSLIST> *disassemb
 			if (!caught_stoi(value_s, &argidx, 10))
 				return -1;
 			getline(*file, value_s, ',');
-			string decodedarg = base64_decode(value_s);
-			callArgs.push_back(make_pair(argidx, decodedarg));
+			//decoded when displayed
+			callArgs.push_back(make_pair(argidx, string(1, ARG_BASE64) + value_s));
 		}
 		if (!callArgs.empty())
 			funcCalls.push_back(callArgs);
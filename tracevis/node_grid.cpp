@@ -0,0 +1,219 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Buckets the drawn nodes of a graph by where they sit on the sphere
+*/
+#include "stdafx.h"
+#include "node_grid.h"
+#include "GUIConstants.h"
+#include <cfloat>
+
+//planes bounding the clip volume, taken from the rows of projection * modelview
+view_frustum::view_frustum(PROJECTDATA *pd)
+{
+	double clip[16];
+	for (int col = 0; col < 4; ++col)
+		for (int row = 0; row < 4; ++row)
+		{
+			clip[col * 4 + row] = 0;
+			for (int k = 0; k < 4; ++k)
+				clip[col * 4 + row] += pd->projection[k * 4 + row] * pd->model_view[col * 4 + k];
+		}
+
+	for (int axis = 0; axis < 3; ++axis)
+		for (int elem = 0; elem < 4; ++elem)
+		{
+			planes[axis * 2][elem] = clip[elem * 4 + 3] + clip[elem * 4 + axis];
+			planes[axis * 2 + 1][elem] = clip[elem * 4 + 3] - clip[elem * 4 + axis];
+		}
+
+	//modelview is rotation then translation, the camera is the translation undone
+	const GLdouble *mv = pd->model_view;
+	for (int axis = 0; axis < 3; ++axis)
+		camera[axis] = -(mv[axis * 4] * mv[12] + mv[axis * 4 + 1] * mv[13] + mv[axis * 4 + 2] * mv[14]);
+}
+
+bool view_frustum::point_visible(const GLfloat *pos)
+{
+	for (int planeIdx = 0; planeIdx < 6; ++planeIdx)
+	{
+		const double *plane = planes[planeIdx];
+		if (plane[0] * pos[0] + plane[1] * pos[1] + plane[2] * pos[2] + plane[3] < 0)
+			return false;
+	}
+	return true;
+}
+
+//rejects the box if its corner furthest along a plane's normal is outside
+bool view_frustum::box_visible(const GLfloat *boxMin, const GLfloat *boxMax)
+{
+	for (int planeIdx = 0; planeIdx < 6; ++planeIdx)
+	{
+		const double *plane = planes[planeIdx];
+		double distance = plane[3];
+		for (int axis = 0; axis < 3; ++axis)
+			distance += plane[axis] * (plane[axis] > 0 ? boxMax[axis] : boxMin[axis]);
+		if (distance < 0) return false;
+	}
+	return true;
+}
+
+//past the horizon of a sphere centred on the origin when pos.camera < |pos|^2
+bool view_frustum::near_side(const GLfloat *pos)
+{
+	double towardsCamera = 0, radiusSq = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		towardsCamera += pos[axis] * camera[axis];
+		radiusSq += pos[axis] * pos[axis];
+	}
+	return towardsCamera >= radiusSq;
+}
+
+//points facing away from the camera are always past the horizon
+bool view_frustum::box_far_side(const GLfloat *boxMin, const GLfloat *boxMax)
+{
+	double towardsCamera = 0;
+	for (int axis = 0; axis < 3; ++axis)
+		towardsCamera += camera[axis] * (camera[axis] > 0 ? boxMax[axis] : boxMin[axis]);
+	return towardsCamera < 0;
+}
+
+unsigned int node_grid::cell_index(const GLfloat *pos)
+{
+	double longitude = atan2(pos[2], pos[0]);
+	double latitude = atan2(pos[1], sqrt(pos[0] * pos[0] + pos[2] * pos[2]));
+	int column = (int)((longitude + M_PI) / (2 * M_PI) * NODEGRID_COLUMNS);
+	int row = (int)((latitude + M_PI / 2) / M_PI * NODEGRID_ROWS);
+	column = min(max(column, 0), NODEGRID_COLUMNS - 1);
+	row = min(max(row, 0), NODEGRID_ROWS - 1);
+	return row * NODEGRID_COLUMNS + column;
+}
+
+void node_grid::update(GRAPH_DISPLAY_DATA *mainnodes)
+{
+	if (mainnodes != nodedata)
+	{
+		reset();
+		nodedata = mainnodes;
+	}
+
+	unsigned int drawnNodes = nodedata->get_numVerts();
+	for (; indexedNodes < drawnNodes; ++indexedNodes)
+	{
+		GLfloat *pos = nodedata->pos_at(indexedNodes);
+		NODEGRID_CELL *cell = &cells[cell_index(pos)];
+		if (cell->nodes.empty())
+		{
+			usedCells.push_back(cell - cells);
+			std::copy(pos, pos + POSELEMS, cell->boxMin);
+			std::copy(pos, pos + POSELEMS, cell->boxMax);
+		}
+		else
+			for (int axis = 0; axis < POSELEMS; ++axis)
+			{
+				cell->boxMin[axis] = min(cell->boxMin[axis], pos[axis]);
+				cell->boxMax[axis] = max(cell->boxMax[axis], pos[axis]);
+			}
+		cell->nodes.push_back(indexedNodes);
+	}
+}
+
+void node_grid::reset()
+{
+	vector<unsigned int>::iterator cellIt = usedCells.begin();
+	for (; cellIt != usedCells.end(); ++cellIt)
+		cells[*cellIt].nodes.clear();
+	usedCells.clear();
+	indexedNodes = 0;
+}
+
+void node_grid::visible_nodes(view_frustum *view, bool nearSideOnly, vector<unsigned int> *nodes)
+{
+	nodes->clear();
+	vector<unsigned int>::iterator cellIt = usedCells.begin();
+	for (; cellIt != usedCells.end(); ++cellIt)
+	{
+		NODEGRID_CELL *cell = &cells[*cellIt];
+		if (!view->box_visible(cell->boxMin, cell->boxMax)) continue;
+		if (nearSideOnly && view->box_far_side(cell->boxMin, cell->boxMax)) continue;
+
+		vector<unsigned int>::iterator nodeIt = cell->nodes.begin();
+		for (; nodeIt != cell->nodes.end(); ++nodeIt)
+		{
+			GLfloat *pos = nodedata->pos_at(*nodeIt);
+			if (!view->point_visible(pos)) continue;
+			if (nearSideOnly && !view->near_side(pos)) continue;
+			nodes->push_back(*nodeIt);
+		}
+	}
+}
+
+bool node_grid::nearest_node(PROJECTDATA *pd, view_frustum *view, double x, double y,
+	double maxPixels, unsigned int *nodeIdx)
+{
+	bool found = false;
+	double bestDistSq = maxPixels * maxPixels;
+	vector<unsigned int>::iterator cellIt = usedCells.begin();
+	for (; cellIt != usedCells.end(); ++cellIt)
+	{
+		NODEGRID_CELL *cell = &cells[*cellIt];
+		if (!view->box_visible(cell->boxMin, cell->boxMax)) continue;
+		if (view->box_far_side(cell->boxMin, cell->boxMax)) continue;
+
+		//skip cells whose screen footprint is nowhere near the point
+		//corners behind the camera don't project sensibly, just search those cells
+		double left = DBL_MAX, right = -DBL_MAX, bottom = DBL_MAX, top = -DBL_MAX;
+		bool behindCamera = false;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			DCOORD screenCorner;
+			gluProject((corner & 1) ? cell->boxMax[0] : cell->boxMin[0],
+				(corner & 2) ? cell->boxMax[1] : cell->boxMin[1],
+				(corner & 4) ? cell->boxMax[2] : cell->boxMin[2],
+				pd->model_view, pd->projection, pd->viewport,
+				&screenCorner.x, &screenCorner.y, &screenCorner.z);
+			left = min(left, screenCorner.x);
+			right = max(right, screenCorner.x);
+			bottom = min(bottom, screenCorner.y);
+			top = max(top, screenCorner.y);
+			if (screenCorner.z < 0 || screenCorner.z > 1) behindCamera = true;
+		}
+		if (!behindCamera &&
+			(x < left - maxPixels || x > right + maxPixels || y < bottom - maxPixels || y > top + maxPixels))
+			continue;
+
+		vector<unsigned int>::iterator nodeIt = cell->nodes.begin();
+		for (; nodeIt != cell->nodes.end(); ++nodeIt)
+		{
+			GLfloat *pos = nodedata->pos_at(*nodeIt);
+			if (!view->point_visible(pos) || !view->near_side(pos)) continue;
+
+			DCOORD screenPos;
+			gluProject(pos[0], pos[1], pos[2], pd->model_view, pd->projection, pd->viewport,
+				&screenPos.x, &screenPos.y, &screenPos.z);
+			double distSq = (screenPos.x - x) * (screenPos.x - x) + (screenPos.y - y) * (screenPos.y - y);
+			if (distSq < bestDistSq)
+			{
+				bestDistSq = distSq;
+				*nodeIdx = *nodeIt;
+				found = true;
+			}
+		}
+	}
+	return found;
+}
@@ -75,6 +75,7 @@ void gen_graph_VBOs(thread_graph_data *graph)
 	glGenBuffers(1, graph->heatmapEdgeVBO);
 	glGenBuffers(2, graph->conditionalVBOs);
 	glGenBuffers(4, graph->activeVBOs);
+	glGenBuffers(4, graph->lodVBOs);
 	graph->VBOsGenned = true;
 }
 
@@ -92,19 +93,94 @@ void load_VBO(int index, GLuint *VBOs, int bufsize, float *data)
 	glBufferData(GL_ARRAY_BUFFER, bufsize, data, GL_DYNAMIC_DRAW);
 }
 
-void load_edge_VBOS(GLuint *VBOs, GRAPH_DISPLAY_DATA *lines)
+//sends the parts of the first verts vertices changed since this buffer was last loaded
+//each range is sent from the chunks it spans in turn
+static void load_VBO_chunks(int index, GLuint *VBOs, GRAPH_DISPLAY_DATA *data, bool colours, unsigned int verts)
+{
+	const unsigned int vertBytes = (colours ? COLELEMS : POSELEMS) * sizeof(GLfloat);
+	glBindBuffer(GL_ARRAY_BUFFER, VBOs[index]);
+
+	unsigned int generation = data->get_generation();
+	vector<BYTE_RANGE> ranges;
+	unsigned long bufferBytes;
+	if (data->take_dirty(colours, VBOs[index], verts, &ranges, &bufferBytes))
+		glBufferData(GL_ARRAY_BUFFER, bufferBytes, 0, GL_DYNAMIC_DRAW);
+
+	vector<BYTE_RANGE>::iterator rangeIt = ranges.begin();
+	for (; rangeIt != ranges.end(); ++rangeIt)
+	{
+		unsigned long vertIdx = rangeIt->first / vertBytes, runVerts;
+		const unsigned long rangeEnd = rangeIt->second / vertBytes;
+		while (vertIdx < rangeEnd)
+		{
+			GLfloat *run = colours ? data->col_run(vertIdx, &runVerts) : data->pos_run(vertIdx, &runVerts);
+			if (!run) break;
+			runVerts = min(runVerts, rangeEnd - vertIdx);
+			glBufferSubData(GL_ARRAY_BUFFER, vertIdx * vertBytes, runVerts * vertBytes, run);
+			vertIdx += runVerts;
+		}
+	}
+
+	//rewritten while we were sending it, the next load sends it all again
+	if (!data->same_generation(generation))
+		data->mark_all();
+}
+
+void load_VBO_pos(int index, GLuint *VBOs, GRAPH_DISPLAY_DATA *data, unsigned int verts)
 {
-	int posbufsize = lines->get_numVerts() * POSELEMS * sizeof(GLfloat);
-	load_VBO(VBO_LINE_POS, VBOs, posbufsize, lines->readonly_pos());
+	load_VBO_chunks(index, VBOs, data, false, verts);
+}
+
+void load_VBO_col(int index, GLuint *VBOs, GRAPH_DISPLAY_DATA *data, unsigned int verts)
+{
+	load_VBO_chunks(index, VBOs, data, true, verts);
+}
+
+//expands changed palette indices to RGBA bytes a chunk at a time, draw with GL_UNSIGNED_BYTE colours
+void load_VBO_palette(int index, GLuint *VBOs, PALETTE_LAYER *layer, unsigned int verts)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, VBOs[index]);
+
+	unsigned int generation = layer->get_generation();
+	vector<BYTE_RANGE> ranges;
+	unsigned long bufferBytes;
+	if (layer->take_dirty(VBOs[index], verts, &ranges, &bufferBytes))
+		glBufferData(GL_ARRAY_BUFFER, bufferBytes, 0, GL_DYNAMIC_DRAW);
+
+	vector<unsigned char> expanded;
+	vector<BYTE_RANGE>::iterator rangeIt = ranges.begin();
+	for (; rangeIt != ranges.end(); ++rangeIt)
+	{
+		unsigned long vertIdx = rangeIt->first / PALETTE_VERT_BYTES, runVerts;
+		const unsigned long rangeEnd = rangeIt->second / PALETTE_VERT_BYTES;
+		while (vertIdx < rangeEnd)
+		{
+			unsigned char *run = layer->index_run(vertIdx, &runVerts);
+			if (!run) break;
+			runVerts = min(runVerts, rangeEnd - vertIdx);
+			expanded.resize(runVerts * PALETTE_VERT_BYTES);
+			layer->expand(run, runVerts, &expanded.at(0));
+			glBufferSubData(GL_ARRAY_BUFFER, vertIdx * PALETTE_VERT_BYTES, runVerts * PALETTE_VERT_BYTES, &expanded.at(0));
+			vertIdx += runVerts;
+		}
+	}
+
+	if (!layer->same_generation(generation))
+		layer->mark_all();
+}
 
-	int linebufsize = lines->get_numVerts() * COLELEMS * sizeof(GLfloat);
-	load_VBO(VBO_LINE_COL, VBOs, linebufsize, lines->readonly_col());
+void load_edge_VBOS(GLuint *VBOs, GRAPH_DISPLAY_DATA *lines)
+{
+	unsigned int numVerts = lines->get_numVerts();
+	load_VBO_pos(VBO_LINE_POS, VBOs, lines, numVerts);
+	load_VBO_col(VBO_LINE_COL, VBOs, lines, numVerts);
 }
 
 void loadVBOs(GLuint *VBOs, GRAPH_DISPLAY_DATA *verts, GRAPH_DISPLAY_DATA *lines)
 {
-	load_VBO(VBO_NODE_POS, VBOs, verts->pos_size(), verts->readonly_pos());
-	load_VBO(VBO_NODE_COL, VBOs, verts->col_size(), verts->readonly_col());
+	unsigned int numVerts = verts->get_numVerts();
+	load_VBO_pos(VBO_NODE_POS, VBOs, verts, numVerts);
+	load_VBO_col(VBO_NODE_COL, VBOs, verts, numVerts);
 	load_edge_VBOS(VBOs, lines);
 }
 
@@ -140,84 +216,6 @@ void initial_gl_setup(VISSTATE *clientState)
 	glClearColor(0, 0, 0, 1.0);
 }
 
-//draw a segmented sphere with row gradiented red, cols green
-void plot_colourpick_sphere(VISSTATE *clientState)
-{
-	GRAPH_DISPLAY_DATA *spheredata = clientState->col_pick_sphere;
-	if (spheredata)
-		delete spheredata;
-
-	spheredata = new GRAPH_DISPLAY_DATA(COL_SPHERE_BUFSIZE);
-	clientState->col_pick_sphere = spheredata;
-
-	int diam = clientState->activeGraph->m_scalefactors->radius;
-	int rowi, coli;
-	float tlx, tlz, trx, topy, trz;
-	float basey, brx, brz, blz, blx;
-	int rowAngle = (int)(360 / BDIVISIONS);
-	
-	vector<GLfloat> *spherepos = spheredata->acquire_pos(23); 
-	vector<GLfloat> *spherecol = spheredata->acquire_col();
-	for (rowi = 180; rowi >= 0; rowi -= rowAngle) 
-	{
-		float colb = (float)rowi / 180;
-		float ringSizeTop, ringSizeBase, anglel, angler;
-		for (coli = 0; coli < ADIVISIONS; ++coli) 
-		{
-			float cola = 1 - ((float)coli / ADIVISIONS);
-			float iitop = rowi;
-			float iibase = rowi + rowAngle;
-
-			anglel = (2 * M_PI * coli) / ADIVISIONS;
-			angler = (2 * M_PI * (coli + 1)) / ADIVISIONS;
-
-			ringSizeTop = diam * sin((iitop*M_PI) / 180);
-			topy = diam * cos((iitop*M_PI) / 180);
-			tlx = ringSizeTop * cos(anglel);
-			trx = ringSizeTop * cos(angler);
-			tlz = ringSizeTop * sin(anglel);
-			trz = ringSizeTop * sin(angler);
-
-			ringSizeBase = diam * sin((iibase*M_PI) / 180);
-			basey = diam * cos((iibase*M_PI) / 180);
-			blx = ringSizeBase * cos(anglel);
-			blz = ringSizeBase * sin(anglel);
-			brx = ringSizeBase * cos(angler);
-			brz = ringSizeBase * sin(angler);
-
-			int i;
-			for (i = 0; i < 4; ++i)
-			{
-				spherecol->push_back(colb);
-				spherecol->push_back(cola);
-				spherecol->push_back(0);
-			}
-
-			//draw a segment of the sphere clockwise
-			spherepos->push_back(tlx);
-			spherepos->push_back(topy);
-			spherepos->push_back(tlz);
-
-			spherepos->push_back(trx);
-			spherepos->push_back(topy);
-			spherepos->push_back(trz);
-
-			spherepos->push_back(brx);
-			spherepos->push_back(basey);
-			spherepos->push_back(brz);
-
-			spherepos->push_back(blx);
-			spherepos->push_back(basey);
-			spherepos->push_back(blz);
-		}
-	}
-
-	load_VBO(VBO_SPHERE_POS, clientState->colSphereVBOs, COL_SPHERE_BUFSIZE, &spherepos->at(0));
-	load_VBO(VBO_SPHERE_COL, clientState->colSphereVBOs, COL_SPHERE_BUFSIZE, &spherecol->at(0));
-	spheredata->release_col();
-	spheredata->release_pos();
-}
-
 void rotate_to_user_view(VISSTATE *clientState)
 {
 	glTranslatef(0, 0, -clientState->cameraZoomlevel);
@@ -225,52 +223,6 @@ void rotate_to_user_view(VISSTATE *clientState)
 	glRotatef(-clientState->xturn, 0, 1, 0);
 }
 
-//draw a colourful gradiented sphere on the screen
-//read colours on edge so we can see where window is on sphere
-//reset back to state before the call
-//return colours in passed SCREEN_EDGE_PIX struct
-//pass doclear false if you want to see it for debugging
-void edge_picking_colours(VISSTATE *clientState, SCREEN_EDGE_PIX *TBRG, bool doClear)
-{
-	if (!clientState->col_pick_sphere)
-		plot_colourpick_sphere(clientState);
-
-	glPushMatrix();
-	//make sure camera only sees the nearest side of the sphere
-	gluPerspective(45, clientState->mainFrameSize.width / clientState->mainFrameSize.height, 50, 
-		clientState->cameraZoomlevel);
-	glLoadIdentity();
-
-	rotate_to_user_view(clientState);
-
-	glBindBuffer(GL_ARRAY_BUFFER, clientState->colSphereVBOs[0]);
-	glVertexPointer(3, GL_FLOAT, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, clientState->colSphereVBOs[1]);
-	glColorPointer(3, GL_FLOAT, 0, 0);
-	glDrawArrays(GL_QUADS, 0, COL_SPHERE_VERTS);
-
-	//no idea why this ajustment needed, found by trial and error
-	int height = clientState->mainFrameSize.height - 20;
-	int width = al_get_bitmap_width(clientState->mainGraphBMP);
-	int halfheight = height / 2;
-	int halfwidth = width / 2;
-
-	GLfloat pixelRGB[3];
-	glReadPixels(0, halfheight, 1, 1, GL_RGB, GL_FLOAT, pixelRGB);
-	TBRG->leftgreen = pixelRGB[1];
-	glReadPixels(width - 1, halfheight, 1, 1, GL_RGB, GL_FLOAT, pixelRGB);
-	TBRG->rightgreen = pixelRGB[1];
-	//not used yet
-	glReadPixels(halfwidth, height - 1, 1, 1, GL_RGB, GL_FLOAT, pixelRGB);
-	TBRG->topred = pixelRGB[0];
-	glReadPixels(halfwidth, 3, 1, 1, GL_RGB, GL_FLOAT, pixelRGB);
-	TBRG->bottomred = pixelRGB[0];
-	glPopMatrix();
-
-	if (doClear) //also need to call this function on every frame to see it
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-}
-
 void array_render_points(int POSVBO, int COLVBO, GLuint *buffers, int quantity) 
 {
 	array_render(GL_POINTS, POSVBO, COLVBO, buffers, quantity);
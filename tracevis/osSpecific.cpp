@@ -99,6 +99,15 @@ string basename(string path)
 	return path;
 }
 
+//get directory from path, with the trailing slash
+string dirname(string path)
+{
+	const size_t last_slash_idx = path.find_last_of("\\/");
+	if (std::string::npos == last_slash_idx)
+		return ".\\";
+	return path.substr(0, last_slash_idx + 1);
+}
+
 //returns path for saving files, tries to create if it doesn't exist
 bool getSavePath(string saveDir, string filename, string *result, PID_TID PID)
 {
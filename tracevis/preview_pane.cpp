@@ -61,29 +61,14 @@ void write_tid_text(ALLEGRO_FONT* font, thread_graph_data *graph, int x, int y)
 void uploadPreviewGraph(thread_graph_data *previewgraph) 
 {
 	GLuint *VBOs = previewgraph->previewVBOs;
-	load_VBO(VBO_NODE_POS, VBOs, previewgraph->previewnodes->pos_size(), previewgraph->previewnodes->readonly_pos());
-	load_VBO(VBO_NODE_COL, VBOs, previewgraph->previewnodes->col_size(), previewgraph->previewnodes->readonly_col());
+	GRAPH_DISPLAY_DATA *previewnodes = previewgraph->previewnodes;
+	unsigned int nodeVerts = previewnodes->get_numVerts();
+	load_VBO_pos(VBO_NODE_POS, VBOs, previewnodes, nodeVerts);
+	load_VBO_col(VBO_NODE_COL, VBOs, previewnodes, nodeVerts);
 
-	int posbufsize = previewgraph->previewlines->get_numVerts() * POSELEMS * sizeof(GLfloat);
-	int linebufsize = previewgraph->previewlines->get_numVerts() * COLELEMS * sizeof(GLfloat);
-	if (!posbufsize || !linebufsize) return;
-
-	vector<float> *lineVector = 0;
-	
-	lineVector = previewgraph->previewlines->acquire_pos(25);
-	if (previewgraph->previewlines->get_numVerts() == 0)
-	{
-		previewgraph->previewlines->release_pos();
-		return;
-	}
-	assert(!lineVector->empty());
-	load_VBO(VBO_LINE_POS, VBOs, posbufsize, &lineVector->at(0));
-	previewgraph->previewlines->release_pos();
-
-	lineVector = previewgraph->previewlines->acquire_col();
-	assert(!lineVector->empty());
-	load_VBO(VBO_LINE_COL, VBOs, linebufsize, &lineVector->at(0));
-	previewgraph->previewlines->release_col();
+	unsigned int lineVerts = previewgraph->previewlines->get_numVerts();
+	if (!lineVerts) return;
+	load_edge_VBOS(VBOs, previewgraph->previewlines);
 
 	previewgraph->needVBOReload_preview = false;
 }
@@ -211,8 +196,11 @@ void redrawPreviewGraphs(VISSTATE *clientState, map <PID_TID, NODEPAIR> *graphPo
 	for (;threadit != clientState->activePid->graphs.end(); ++threadit)
 	{
 		previewGraph = (thread_graph_data *)threadit->second;
-	
-		if (!previewGraph || !previewGraph->previewnodes->get_numVerts()) continue;
+		if (!previewGraph) continue;
+
+		//tells the preview thread which graphs to render first
+		previewGraph->previewVisible = (graphy > -PREV_Y_MULTIPLIER && graphy < clientState->displaySize.height);
+		if (!previewGraph->previewnodes->get_numVerts()) continue;
 
 		if (!previewGraph->VBOsGenned) 
 			gen_graph_VBOs(previewGraph);
@@ -21,8 +21,9 @@ Miscellaneous graphics routines that don't fit into the graph class
 #include "stdafx.h"
 #include "rendering.h"
 #include "OSspecific.h"
+#include "geometry_workers.h"
 
-//plot wireframe/colpick sphere in memory if they dont exist
+//plot wireframe sphere in memory if it doesnt exist
 //+draw wireframe
 void maintain_draw_wireframe(VISSTATE *clientState, GLint *wireframeStarts, GLint *wireframeSizes)
 {
@@ -34,10 +35,7 @@ void maintain_draw_wireframe(VISSTATE *clientState, GLint *wireframeStarts, GLin
 	}
 
 	if (!clientState->wireframe_sphere)
-	{
 		plot_wireframe(clientState);
-		plot_colourpick_sphere(clientState);
-	}
 
 	draw_wireframe(clientState, wireframeStarts, wireframeSizes);
 }
@@ -54,21 +52,20 @@ void plot_wireframe(VISSTATE *clientState)
 	const int points = WF_POINTSPERLINE;
 
 	int lineDivisions = (int)(360 / WIREFRAMELOOPS);
-	GRAPH_DISPLAY_DATA *wireframe_data = clientState->wireframe_sphere;
 	
-	vector <float> *vpos = wireframe_data->acquire_pos(234);
-	vector <float> *vcol = wireframe_data->acquire_col(); 
+	//only plotted once, built here and handed straight to opengl
+	vector <float> vpos, vcol;
 	for (ii = 0; ii < 180; ii += lineDivisions) {
 
 		float ringSize = diam * sin((ii*M_PI) / 180);
 		for (pp = 0; pp < WF_POINTSPERLINE; ++pp) {
 
 			float angle = (2 * M_PI * pp) / WF_POINTSPERLINE;
-			vpos->push_back(ringSize * cos(angle)); //x
-			vpos->push_back(diam * cos((ii*M_PI) / 180)); //y
-			vpos->push_back(ringSize * sin(angle)); //z
+			vpos.push_back(ringSize * cos(angle)); //x
+			vpos.push_back(diam * cos((ii*M_PI) / 180)); //y
+			vpos.push_back(ringSize * sin(angle)); //z
 
-			vcol->insert(vcol->end(), cols, end(cols));
+			vcol.insert(vcol.end(), cols, end(cols));
 		}
 	}
 
@@ -79,282 +76,301 @@ void plot_wireframe(VISSTATE *clientState)
 
 			float angle = (2 * M_PI * pp) / points;
 			float cosangle = cos(angle);
-			vpos->push_back(diam * cosangle * cos(degs2));
-			vpos->push_back(diam * sin(angle));
-			vpos->push_back(diam * cosangle * sin(degs2));
+			vpos.push_back(diam * cosangle * cos(degs2));
+			vpos.push_back(diam * sin(angle));
+			vpos.push_back(diam * cosangle * sin(degs2));
 
-			vcol->insert(vcol->end(), cols, end(cols));
+			vcol.insert(vcol.end(), cols, end(cols));
 		}
 	}
 
-	load_VBO(VBO_SPHERE_POS, clientState->wireframeVBOs, WFPOSBUFSIZE, &vpos->at(0));
-	load_VBO(VBO_SPHERE_COL, clientState->wireframeVBOs, WFCOLBUFSIZE, &vcol->at(0));
-	wireframe_data->release_pos();
-	wireframe_data->release_col();
+	load_VBO(VBO_SPHERE_POS, clientState->wireframeVBOs, WFPOSBUFSIZE, &vpos.at(0));
+	load_VBO(VBO_SPHERE_COL, clientState->wireframeVBOs, WFCOLBUFSIZE, &vcol.at(0));
 }
 
 //draw basic opengl line between 2 points
-void drawShortLinePoints(FCOORD *startC, FCOORD *endC, ALLEGRO_COLOR *colour, GRAPH_DISPLAY_DATA *vertdata, int *arraypos)
+void drawShortLinePoints(FCOORD *startC, FCOORD *endC, ALLEGRO_COLOR *colour, GLfloat *pos, GLfloat *col)
 {
-	
-	vector <float> *vpos = vertdata->acquire_pos(52); 
-	vector <float> *vcol = vertdata->acquire_col();
-
-	int numverts = vertdata->get_numVerts();
-
-	vpos->push_back(startC->x);
-	vpos->push_back(startC->y);
-	vpos->push_back(startC->z);
-	vcol->push_back(colour->r);
-	vcol->push_back(colour->g);
-	vcol->push_back(colour->b);
-	vcol->push_back(colour->a);
-
-	vpos->push_back(endC->x);
-	vpos->push_back(endC->y);
-	vpos->push_back(endC->z);
-	vcol->push_back(colour->r);
-	vcol->push_back(colour->g);
-	vcol->push_back(colour->b);
-	vcol->push_back(colour->a);
-
-	vertdata->set_numVerts(numverts + 2);
-	vertdata->release_pos();
-	vertdata->release_col();
-
+	pos[0] = startC->x; pos[1] = startC->y; pos[2] = startC->z;
+	pos[3] = endC->x; pos[4] = endC->y; pos[5] = endC->z;
+	for (int vert = 0; vert < 2; ++vert, col += COLELEMS)
+	{
+		col[0] = colour->r;
+		col[1] = colour->g;
+		col[2] = colour->b;
+		col[AOFF] = colour->a;
+	}
 }
 
-//draws a long curve with multiple vertices
-int drawLongCurvePoints(FCOORD *bezierC, FCOORD *startC, FCOORD *endC, ALLEGRO_COLOR *colour,
-	int edgeType, GRAPH_DISPLAY_DATA *vertdata, int curvePoints, int *colarraypos) {
-	float fadeArray[] = { 1,0.9,0.8,0.7,0.5,0.3,0.3,0.3,0.2,0.2,0.2,
-		0.3, 0.3, 0.5, 0.7, 0.9, 1 };
-
-	int vsadded = 0;
-	curvePoints += 2; 
-	vector<GLfloat> *vertpos = vertdata->acquire_pos(63);
-	vector<GLfloat> *vertcol = vertdata->acquire_col(); 
-
-	if (!vertpos || !vertcol) 
-		return 0;
-	*colarraypos = vertcol->size();
-	int ci = 0;
-	int pi = 0;
-
-	float cols[4] = { colour->r , colour->g, colour->b, 1 };
-
-	vertpos->push_back(startC->x);
-	vertpos->push_back(startC->y);
-	vertpos->push_back(startC->z);
-	
-	vertcol->insert(vertcol->end(), cols, end(cols));
-	++vsadded;
-	// > for smoother lines, less performance
-	int dt;
-	float fadeA = 0.9;
-	FCOORD resultC;
-
-	int segments = float(curvePoints) / 2;
-	for (dt = 1; dt < segments + 1; ++dt)
+//quadratic bezier weights of the start, control and end points at each point of a long curve
+struct CURVE_BASIS {
+	CURVE_BASIS()
 	{
-
-		if ((edgeType == IOLD) || (edgeType == IRET)) {
-			fadeA = fadeArray[dt - 1];
-			if (fadeA > 1) fadeA = 1;
+		for (int segment = 0; segment < LONGCURVESEGS; ++segment)
+		{
+			float t = float(segment + 1) / float(LONGCURVESEGS);
+			start[segment] = (1 - t) * (1 - t);
+			control[segment] = 2 * (1 - t) * t;
+			end[segment] = t * t;
 		}
-		else
-			fadeA = 0.9;
-		cols[3] = fadeA;
-
-		bezierPT(startC, bezierC, endC, dt, segments, &resultC);
-
-		//end last line
-		vertpos->push_back(resultC.x);
-		vertpos->push_back(resultC.y);
-		vertpos->push_back(resultC.z);
-		vertcol->insert(vertcol->end(), cols, end(cols));
-		++vsadded;
-
-		//start new line at same point 
-		//todo: this is waste of memory but far too much effort to fix for minimal gain
-		vertpos->push_back(resultC.x);
-		vertpos->push_back(resultC.y);
-		vertpos->push_back(resultC.z);
-		vertcol->insert(vertcol->end(), cols, end(cols));
-		++vsadded;
 	}
+	float start[LONGCURVESEGS];
+	float control[LONGCURVESEGS];
+	float end[LONGCURVESEGS];
+};
+static const CURVE_BASIS longCurveBasis;
 
-	vertpos->push_back(endC->x);
-	vertpos->push_back(endC->y);
-	vertpos->push_back(endC->z);
-	++vsadded;
-	cols[3] = 1;
-	vertcol->insert(vertcol->end(), cols, end(cols));
+//alpha of each point along old/return edges, faded in the middle
+static const float curveFade[LONGCURVESEGS] = { 1,0.9,0.8,0.7,0.5,0.3,0.3,0.3,0.2,0.2,0.2,
+	0.3, 0.3, 0.5, 0.7, 0.9, 1 };
 
-	int numverts = vertdata->get_numVerts();
+//draws a long curve with multiple vertices
+//each interior point ends one line and starts the next, so is written twice
+void drawLongCurvePoints(FCOORD *bezierC, FCOORD *startC, FCOORD *endC, ALLEGRO_COLOR *colour,
+	int edgeType, GLfloat *pos, GLfloat *col) 
+{
+	bool faded = (edgeType == IOLD) || (edgeType == IRET);
 
-	vertdata->set_numVerts(numverts + curvePoints + 2);
-	vertdata->release_col();
-	vertdata->release_pos();
+	pos[0] = startC->x;
+	pos[1] = startC->y;
+	pos[2] = startC->z;
+	for (int segment = 0; segment < LONGCURVESEGS; ++segment)
+	{
+		float startW = longCurveBasis.start[segment];
+		float controlW = longCurveBasis.control[segment];
+		float endW = longCurveBasis.end[segment];
+		GLfloat *point = &pos[(segment * 2 + 1) * POSELEMS];
+		point[0] = point[3] = startW * startC->x + controlW * bezierC->x + endW * endC->x;
+		point[1] = point[4] = startW * startC->y + controlW * bezierC->y + endW * endC->y;
+		point[2] = point[5] = startW * startC->z + controlW * bezierC->z + endW * endC->z;
+	}
+	GLfloat *lastPoint = &pos[(LONGCURVEVERTS - 1) * POSELEMS];
+	lastPoint[0] = endC->x;
+	lastPoint[1] = endC->y;
+	lastPoint[2] = endC->z;
 
-	return curvePoints + 2;
+	for (int vert = 0; vert < LONGCURVEVERTS; ++vert)
+	{
+		GLfloat *vertCol = &col[vert * COLELEMS];
+		vertCol[0] = colour->r;
+		vertCol[1] = colour->g;
+		vertCol[2] = colour->b;
+		if (!vert || vert == LONGCURVEVERTS - 1)
+			vertCol[AOFF] = 1;
+		else
+			vertCol[AOFF] = faded ? curveFade[(vert - 1) / 2] : 0.9;
+	}
 }
 
-//connect two nodes with an edge of automatic number of vertices
-int drawCurve(GRAPH_DISPLAY_DATA *linedata, FCOORD *startC, FCOORD *endC, 
-	ALLEGRO_COLOR *colour, int edgeType, MULTIPLIERS *dimensions, int *arraypos)
+//number of vertices an edge between two points is drawn with, 0 if it can't be drawn
+//places the control point of the curve in bezierC
+int curveShape(FCOORD *startC, FCOORD *endC, int edgeType, MULTIPLIERS *dimensions, FCOORD *bezierC)
 {
-	float r, b, g, a;
-	r = colour->r;
-	b = colour->b;
-	g = colour->g;
-	a = 1;
-
 	//describe the normal
 	FCOORD middleC;
 	midpoint(startC, endC, &middleC);
 	float eLen = linedist(startC, endC);
 
-	FCOORD bezierC;
-	int curvePoints;
-
 	switch (edgeType)
 	{
 		case INEW:
 		{
 			//todo: make this number much smaller for previews
-			curvePoints = eLen < 80 ? 1 : LONGCURVEPTS;
-			bezierC = middleC;
-			break;
+			*bezierC = middleC;
+			return eLen < 80 ? 2 : LONGCURVEVERTS;
 		}
 
 		case IRET:
 		case IOLD:
 		{
-			curvePoints = LONGCURVEPTS;
-
 			if (eLen < 2) 
-				bezierC = middleC;
+				*bezierC = middleC;
 			else
 			{
 				float oldMidA, oldMidB;
-				FCOORD bezierC2;
 				sphereAB(&middleC, &oldMidA, &oldMidB, dimensions);
-				sphereCoord(oldMidA, oldMidB, &bezierC, dimensions, -(eLen / 2));
+				sphereCoord(oldMidA, oldMidB, bezierC, dimensions, -(eLen / 2));
 
 				//i dont know why this problem happens or why this fixes it
-				if ((bezierC.x > 0) && (startC->x < 0 && endC->x < 0))
-					bezierC.x = -bezierC.x;
+				if ((bezierC->x > 0) && (startC->x < 0 && endC->x < 0))
+					bezierC->x = -bezierC->x;
 			}
-			break;
+			return LONGCURVEVERTS;
 		}
 
 		case ICALL:
 		case ILIB: 
 		case IEXCEPT:
 		{
-			curvePoints = LONGCURVEPTS;
-			bezierC = middleC;
-			break;
+			*bezierC = middleC;
+			return LONGCURVEVERTS;
 		}
 
 		default:
 			cerr << "[rgat]Error: Drawcurve unknown edgeType " << edgeType << endl;
 			return 0;
 	}
+}
+
+//writes the vertsDrawn vertices curveShape picked into pos/col
+void writeCurve(FCOORD *startC, FCOORD *endC, FCOORD *bezierC, int vertsDrawn,
+	ALLEGRO_COLOR *colour, int edgeType, GLfloat *pos, GLfloat *col)
+{
+	if (vertsDrawn == LONGCURVEVERTS)
+		drawLongCurvePoints(bezierC, startC, endC, colour, edgeType, pos, col);
+	else if (vertsDrawn == 2)
+		drawShortLinePoints(startC, endC, colour, pos, col);
+}
 
-	switch(curvePoints)
+//connect two nodes with an edge of automatic number of vertices
+int drawCurve(GRAPH_DISPLAY_DATA *linedata, FCOORD *startC, FCOORD *endC, 
+	ALLEGRO_COLOR *colour, int edgeType, MULTIPLIERS *dimensions, int *arraypos)
+{
+	FCOORD bezierC;
+	int vertsDrawn = curveShape(startC, endC, edgeType, dimensions, &bezierC);
+	if (!vertsDrawn) return 0;
+
+	GLfloat pos[LONGCURVEVERTS * POSELEMS];
+	GLfloat col[LONGCURVEVERTS * COLELEMS];
+	writeCurve(startC, endC, &bezierC, vertsDrawn, colour, edgeType, pos, col);
+	*arraypos = linedata->append_verts(pos, col, vertsDrawn);
+	return vertsDrawn;
+}
+
+//a run of edges having their vertices built in slices on the geometry workers
+struct EDGE_BATCH {
+	vector<pair<NODEPAIR, edge_data *>> *edges;
+	map<int, ALLEGRO_COLOR> *lineColours;
+	MULTIPLIERS *scaling;
+	//source and target coords of each edge
+	vector<VCOORD> nodeCoords;
+	vector<FCOORD> ends;
+	vector<FCOORD> beziers;
+	//vertices of each edge, then where each edge starts in pos/col
+	vector<unsigned int> edgeVerts;
+	vector<unsigned int> firstVert;
+	vector<GLfloat> pos;
+	vector<GLfloat> col;
+};
+
+static void shape_edge_slice(void *context, unsigned long first, unsigned long last)
+{
+	EDGE_BATCH *batch = (EDGE_BATCH *)context;
+	for (unsigned long edgeIdx = first; edgeIdx < last; ++edgeIdx)
 	{
-		case LONGCURVEPTS:
+		FCOORD *ends = &batch->ends[edgeIdx * 2];
+		for (int end = 0; end < 2; ++end)
 		{
-			int vertsdrawn = drawLongCurvePoints(&bezierC, startC, endC, colour, edgeType, linedata, curvePoints, arraypos);
-			return vertsdrawn;
+			VCOORD *coord = &batch->nodeCoords[edgeIdx * 2 + end];
+			float adjB = coord->b + float(coord->bMod * BMODMAG);
+			sphereCoord(coord->a, adjB, &ends[end], batch->scaling, 0);
 		}
-
-		case 1:
-			drawShortLinePoints(startC, endC, colour, linedata, arraypos);
-			return 2;
-
-		default:
-			cerr << "[rgat]Error: Drawcurve unknown curvePoints " << curvePoints << endl;
+		edge_data *e = batch->edges->at(edgeIdx).second;
+		batch->edgeVerts[edgeIdx] = curveShape(&ends[0], &ends[1], e->edgeClass, batch->scaling, &batch->beziers[edgeIdx]);
 	}
+}
 
-	return curvePoints;
+static void write_edge_slice(void *context, unsigned long first, unsigned long last)
+{
+	EDGE_BATCH *batch = (EDGE_BATCH *)context;
+	for (unsigned long edgeIdx = first; edgeIdx < last; ++edgeIdx)
+	{
+		if (!batch->edgeVerts[edgeIdx]) continue;
+		edge_data *e = batch->edges->at(edgeIdx).second;
+		assert((size_t)e->edgeClass < batch->lineColours->size());
+		unsigned long vertIdx = batch->firstVert[edgeIdx];
+		writeCurve(&batch->ends[edgeIdx * 2], &batch->ends[edgeIdx * 2 + 1], &batch->beziers[edgeIdx],
+			batch->edgeVerts[edgeIdx], &batch->lineColours->at(e->edgeClass), e->edgeClass,
+			&batch->pos[vertIdx * POSELEMS], &batch->col[vertIdx * COLELEMS]);
+	}
 }
 
-//converts a single node into node vertex data
-int add_node(node_data *n, GRAPH_DISPLAY_DATA *vertdata, GRAPH_DISPLAY_DATA *animvertdata, 
-	MULTIPLIERS *dimensions, map<int, ALLEGRO_COLOR> *nodeColours)
+/*
+same vertices as rendering each edge in turn with render_edge, built on every core:
+shape each edge to count its vertices, prefix sum the counts into a slot for each edge,
+write each edge into its slot, then append the lot at once
+*/
+void draw_edge_batch(thread_graph_data *graph, vector<pair<NODEPAIR, edge_data *>> *edges,
+	GRAPH_DISPLAY_DATA *linedata, map<int, ALLEGRO_COLOR> *lineColours, bool preview)
 {
-	ALLEGRO_COLOR *active_col;
+	unsigned long edgeCount = edges->size();
+	if (!edgeCount) return;
+
+	EDGE_BATCH batch;
+	batch.edges = edges;
+	batch.lineColours = lineColours;
+	batch.scaling = preview ? graph->p_scalefactors : graph->m_scalefactors;
+	batch.nodeCoords.resize(edgeCount * 2);
+	batch.ends.resize(edgeCount * 2);
+	batch.beziers.resize(edgeCount);
+	batch.edgeVerts.resize(edgeCount);
+	batch.firstVert.resize(edgeCount);
+
+	graph->acquireNodeReadLock();
+	for (unsigned long edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
+	{
+		NODEPAIR *ePair = &edges->at(edgeIdx).first;
+		batch.nodeCoords[edgeIdx * 2] = graph->locked_get_node(ePair->first)->vcoord;
+		batch.nodeCoords[edgeIdx * 2 + 1] = graph->locked_get_node(ePair->second)->vcoord;
+	}
+	graph->releaseNodeReadLock();
 
-	float adjB = n->vcoord.b + float(n->vcoord.bMod * BMODMAG);
-	FCOORD screenc;
-	sphereCoord(n->vcoord.a, adjB, &screenc, dimensions, 0);
-	
-	vector<GLfloat> *mainNpos = vertdata->acquire_pos(677);
-	vector<GLfloat> *mainNcol = vertdata->acquire_col();
+	run_geometry_slices(edgeCount, shape_edge_slice, &batch);
 
-	mainNpos->push_back(screenc.x);
-	mainNpos->push_back(screenc.y);
-	mainNpos->push_back(screenc.z);
+	unsigned long totalVerts = 0;
+	for (unsigned long edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
+	{
+		batch.firstVert[edgeIdx] = totalVerts;
+		totalVerts += batch.edgeVerts[edgeIdx];
+	}
 
-	if (n->external)
-		active_col = &nodeColours->at(EXTERNAL);
-	else {
-		switch (n->ins->itype) 
+	unsigned int arraypos = 0;
+	if (totalVerts)
+	{
+		batch.pos.resize(totalVerts * POSELEMS);
+		batch.col.resize(totalVerts * COLELEMS);
+		run_geometry_slices(edgeCount, write_edge_slice, &batch);
+		arraypos = linedata->append_verts(&batch.pos.at(0), &batch.col.at(0), totalVerts);
+	}
+
+	for (unsigned long edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
+	{
+		if (!preview)
 		{
-			case OPUNDEF:
-				if (n->conditional)
-					active_col = &nodeColours->at(JUMP);
-				else 
-					active_col = &nodeColours->at(NONFLOW);
-				break;
-			case OPJMP:
-				active_col = &nodeColours->at(JUMP);
-				break;
-			case OPRET:
-				active_col = &nodeColours->at(RETURN);
-				break;
-			case OPCALL:
-				active_col = &nodeColours->at(CALL);
-				break;
-			//case ISYS: //todo: never used - intended for syscalls
-			//	active_col = &al_col_grey;
-			//	break;
-
-			default:
-				cerr << "[rgat]Error: add_node unknown itype " << n->ins->itype << endl;
-				return 0;
+			edge_data *e = edges->at(edgeIdx).second;
+			e->vertSize = batch.edgeVerts[edgeIdx];
+			e->arraypos = e->vertSize ? arraypos + batch.firstVert[edgeIdx] * COLELEMS : 0;
 		}
+		linedata->inc_edgesRendered();
 	}
+}
 
-	mainNcol->push_back(active_col->r);
-	mainNcol->push_back(active_col->g);
-	mainNcol->push_back(active_col->b);
-	mainNcol->push_back(1);
-
-	vertdata->set_numVerts(vertdata->get_numVerts()+1);
-
-	vertdata->release_col();
-	vertdata->release_pos();
+//colour of a node from the type of its instruction
+ALLEGRO_COLOR *node_colour(node_data *n, map<int, ALLEGRO_COLOR> *nodeColours)
+{
+	if (n->external)
+		return &nodeColours->at(EXTERNAL);
 
-	//place node on the animated version of the graph
-	if (!vertdata->isPreview())
+	switch (n->ins->itype) 
 	{
+		case OPUNDEF:
+			if (n->conditional)
+				return &nodeColours->at(JUMP);
+			else 
+				return &nodeColours->at(NONFLOW);
+		case OPJMP:
+			return &nodeColours->at(JUMP);
+		case OPRET:
+			return &nodeColours->at(RETURN);
+		case OPCALL:
+			return &nodeColours->at(CALL);
+		//case ISYS: //todo: never used - intended for syscalls
+		//	return &al_col_grey;
 
-		vector<GLfloat> *animNcol = animvertdata->acquire_col();
-
-		animNcol->push_back(active_col->r);
-		animNcol->push_back(active_col->g);
-		animNcol->push_back(active_col->b);
-		animNcol->push_back(0);
-
-		animvertdata->set_numVerts(vertdata->get_numVerts() + 1);
-		animvertdata->release_col();
+		default:
+			cerr << "[rgat]Error: node_colour unknown itype " << n->ins->itype << endl;
+			return 0;
 	}
-
-	return 1;
 }
 
 //draw floating extern texts. delete from list if time expired
@@ -382,18 +398,15 @@ void drawFloatingExternTexts(thread_graph_data *graph, map <PID_TID, vector<EXTT
 	}
 
 	DCOORD nodepos;
+	view_frustum view(pd);
 	map <EXTTEXT*, int>::iterator drawIt = drawMap.begin();
 	for (; drawIt != drawMap.end(); ++drawIt)
 	{
 		EXTTEXT* ex = drawIt->first;
 		node_data *n = graph->get_node(ex->nodeIdx);
-		if (clientState->nearSide)
-		{
-			if (!a_coord_on_screen(n->vcoord.a, clientState->leftcolumn,
-				clientState->rightcolumn, graph->m_scalefactors->HEDGESEP))
-				continue;
-		}
 		if (!n->get_screen_pos(graph->get_mainnodes(), pd, &nodepos)) continue;
+		if (clientState->nearSide && !view.near_side(graph->get_mainnodes()->pos_at(n->index)))
+			continue;
 		string displayString = ex->displayString;
 		al_draw_text(clientState->standardFont, al_col_green,
 			nodepos.x, clientState->mainFrameSize.height - nodepos.y - ex->yOffset, 0, displayString.c_str());
@@ -440,28 +453,56 @@ void performMainGraphDrawing(VISSTATE *clientState, map <PID_TID, vector<EXTTEXT
 }
 
 //takes node data generated from trace, converts to opengl point locations/colours placed in vertsdata
+//every undrawn node is projected in one batch
 int draw_new_nodes(thread_graph_data *graph, GRAPH_DISPLAY_DATA *vertsdata, map<int, ALLEGRO_COLOR> *nodeColours) {
 	
 	MULTIPLIERS *scalefactors = vertsdata->isPreview() ? graph->p_scalefactors : graph->m_scalefactors;
 
-	int nodeIdx = 0;
-	int nodeEnd = graph->get_num_nodes();
-	if (nodeIdx == nodeEnd) return 0;
-	nodeIdx += vertsdata->get_numVerts();
+	unsigned int nodeIdx = vertsdata->get_numVerts();
+	unsigned int nodeEnd = graph->get_num_nodes();
+	if (nodeIdx >= nodeEnd) return 0;
 
-	if (nodeIdx == nodeEnd) return 0;
-	int maxVerts = 50;
-	for (; nodeIdx != nodeEnd; ++nodeIdx)
+	unsigned int newNodes = nodeEnd - nodeIdx;
+	vector<VCOORD> coords(newNodes);
+	vector<GLfloat> colours(newNodes * COLELEMS);
+
+	graph->acquireNodeReadLock();
+	for (unsigned int batchIdx = 0; batchIdx < newNodes; ++batchIdx)
 	{
-		int retries = 0;
-		while (!add_node(graph->get_node(nodeIdx), vertsdata, graph->animnodesdata, scalefactors, nodeColours))
-			{
-					//think mutexes fixes have made this irrelevant
-					Sleep(50);
-					if (retries++ > 25)
-						cerr<< "[rgat]MUTEX BLOCKAGE?" << endl;
-			}
-			if (!maxVerts--)break;
+		node_data *n = graph->locked_get_node(nodeIdx + batchIdx);
+		ALLEGRO_COLOR *active_col = node_colour(n, nodeColours);
+		//draw up to it, don't skip it
+		if (!active_col)
+		{
+			newNodes = batchIdx;
+			break;
+		}
+
+		coords[batchIdx] = n->vcoord;
+		GLfloat *colour = &colours[batchIdx * COLELEMS];
+		colour[0] = active_col->r;
+		colour[1] = active_col->g;
+		colour[2] = active_col->b;
+		colour[AOFF] = 1;
+	}
+	graph->releaseNodeReadLock();
+	if (!newNodes) return -1;
+
+	vector<GLfloat> positions(newNodes * POSELEMS);
+	sphereCoords(&coords.at(0), newNodes, &positions.at(0), scalefactors);
+	vertsdata->append_verts(&positions.at(0), &colours.at(0), newNodes);
+
+	//place nodes on the animated version of the graph, invisible until animated
+	if (!vertsdata->isPreview())
+	{
+		for (unsigned int batchIdx = 0; batchIdx < newNodes; ++batchIdx)
+			colours[batchIdx * COLELEMS + AOFF] = 0;
+
+		GRAPH_DISPLAY_DATA *animvertdata = graph->animnodesdata;
+		animvertdata->acquire_col();
+		animvertdata->append_col(&colours.at(0), newNodes);
+		animvertdata->set_numVerts(animvertdata->col_count());
+		animvertdata->release_col();
 	}
 	return 1;
 }
@@ -470,42 +511,28 @@ int draw_new_nodes(thread_graph_data *graph, GRAPH_DISPLAY_DATA *vertsdata, map<
 void rescale_nodes(thread_graph_data *graph, bool isPreview) {
 
 	MULTIPLIERS *scalefactors = isPreview ? graph->p_scalefactors : graph->m_scalefactors;
+	GRAPH_DISPLAY_DATA *vertsdata = isPreview ? graph->get_previewnodes() : graph->get_mainnodes();
 
-	GRAPH_DISPLAY_DATA *vertsdata;
-	unsigned long targetIdx, nodeIdx;
-
-	if (isPreview)
-	{
-		nodeIdx = 0;
-		vertsdata = graph->get_previewnodes();
-		targetIdx = vertsdata->get_numVerts();
-	}
-	else
-	{
-		//only resize 250 nodes per call to stop it hanging
-		nodeIdx = graph->vertResizeIndex;
-		graph->vertResizeIndex += 250;
-		vertsdata = graph->get_mainnodes();
-		targetIdx = min(graph->vertResizeIndex, vertsdata->get_numVerts());
-		if (targetIdx == vertsdata->get_numVerts()) graph->vertResizeIndex = 0;		
-	}
-	
-	if (!targetIdx) return;
-	
-	GLfloat *vpos = &vertsdata->acquire_pos(152)->at(0);
-
-	for (; nodeIdx != targetIdx; ++nodeIdx)
+	unsigned int numVerts = vertsdata->get_numVerts();
+	if (!numVerts) return;
+
+	vector<VCOORD> coords(numVerts);
+	graph->acquireNodeReadLock();
+	for (unsigned int nodeIdx = 0; nodeIdx < numVerts; ++nodeIdx)
+		coords[nodeIdx] = graph->locked_get_node(nodeIdx)->vcoord;
+	graph->releaseNodeReadLock();
+
+	//projected straight into each chunk
+	vertsdata->acquire_pos(152);
+	unsigned long nodeIdx = 0, runVerts;
+	while (nodeIdx < numVerts)
 	{
-		node_data *n = graph->get_node(nodeIdx);
-		FCOORD newCoord = n->sphereCoordB(scalefactors, 0);
-		assert(nodeIdx == n->index);
-
-		const int arrayIndex = nodeIdx * POSELEMS;
-		vpos[arrayIndex + XOFF] = newCoord.x;
-		vpos[arrayIndex + YOFF] = newCoord.y;
-		vpos[arrayIndex + ZOFF] = newCoord.z;
+		GLfloat *run = vertsdata->pos_run(nodeIdx, &runVerts);
+		runVerts = min(runVerts, numVerts - nodeIdx);
+		sphereCoords(&coords.at(nodeIdx), runVerts, run, scalefactors);
+		nodeIdx += runVerts;
 	}
-
+	vertsdata->mark_pos(0, numVerts);
 	vertsdata->release_pos();
 }
 
@@ -543,7 +570,6 @@ void render_static_graph(thread_graph_data *graph, VISSTATE *clientState)
 
 			recalculate_scale(graph->p_scalefactors);
 			doResize = true;
-			graph->vertResizeIndex = 0;
 		}
 
 		//more straightforward, stops graph from wrapping around the globe
@@ -561,18 +587,19 @@ void render_static_graph(thread_graph_data *graph, VISSTATE *clientState)
 			//cout << "[rgat]Max A coord too wide, shrinking graph horizontally from " << startA << " to " << widestPoint << endl;
 			recalculate_scale(graph->p_scalefactors);
 			doResize = true;
-			graph->vertResizeIndex = 0;
 		}
 	}
 
 	if (doResize) graph->previewNeedsResize = true;
 
-	if (doResize || graph->vertResizeIndex > 0)
+	if (doResize)
 	{
 		rescale_nodes(graph, false);
 		
 		graph->zoomLevel = graph->m_scalefactors->radius;
 		graph->needVBOReload_main = true;
+		graph->lod->positions_changed();
+		graph->nodesMoved = true;
 
 		if (clientState->wireframe_sphere)
 			clientState->remakeWireframe = true;
@@ -590,33 +617,35 @@ void render_static_graph(thread_graph_data *graph, VISSTATE *clientState)
 	graph->render_new_edges(doResize, &clientState->config->graphColours.lineColours);
 }
 
-//renders edgePerRender edges of graph onto the preview data
-int draw_new_preview_edges(VISSTATE* clientState, thread_graph_data *graph)
+//keeps the level of detail for the current zoom built, if it needs one
+void render_lod_graph(thread_graph_data *graph, VISSTATE *clientState)
 {
-	//draw edges
-	EDGELIST::iterator edgeIt, edgeEnd;
-	//todo, this should be done without the mutex using indexing instead of iteration
-	graph->start_edgeL_iteration(&edgeIt, &edgeEnd);
+	float zmul = zoomFactor(clientState->cameraZoomlevel, graph->m_scalefactors->radius);
+	int level = graph_lod::level_for_zoom(zmul, graph->get_num_nodes());
+	if (level == LOD_NONE) return;
 
-	std::advance(edgeIt, graph->previewlines->get_renderedEdges());
-	if (edgeIt != edgeEnd)
-		graph->needVBOReload_preview = true;
+	graph->update_lod();
+	graph->lod->counts_changed(graph->get_count_updates());
+	if (graph->lod->build_geometry(level, graph->get_mainnodes(), &clientState->config->graphColours.lineColours))
+		graph->needVBOReload_lod = true;
+}
 
-	int remainingEdges = clientState->config->preview.edgesPerRender;
-	map<int, ALLEGRO_COLOR> *lineColours = &clientState->config->graphColours.lineColours;
-	
-	for (; edgeIt != edgeEnd; ++edgeIt)
-	{
-		graph->render_edge(*edgeIt, graph->previewlines, lineColours, 0, true);
-		graph->previewlines->inc_edgesRendered();
-		if (!remainingEdges--)break;
-	}
-	graph->stop_edgeL_iteration();
+//renders up to maxEdges edges of graph onto the preview data, carrying on from the last one rendered
+int draw_new_preview_edges(VISSTATE* clientState, thread_graph_data *graph, unsigned long maxEdges)
+{
+	//edge lock is only held while the range is copied
+	vector<pair<NODEPAIR, edge_data *>> newEdges;
+	unsigned long firstEdge = graph->previewlines->get_renderedEdges();
+	if (!graph->copy_edge_range(firstEdge, maxEdges, &newEdges))
+		return 1;
+
+	graph->needVBOReload_preview = true;
+	draw_edge_batch(graph, &newEdges, graph->previewlines, &clientState->config->graphColours.lineColours, true);
 	return 1;
 }
 
 //should be same as rendering for main graph but - the animation + more pauses instead of all at once
-int render_preview_graph(thread_graph_data *previewGraph, VISSTATE *clientState)
+int render_preview_graph(thread_graph_data *previewGraph, VISSTATE *clientState, unsigned long maxEdges)
 {
 	bool doResize = false;
 	previewGraph->needVBOReload_preview = true;
@@ -636,7 +665,7 @@ int render_preview_graph(thread_graph_data *previewGraph, VISSTATE *clientState)
 		assert(0);
 	}
 
-	if (!draw_new_preview_edges(clientState, previewGraph))
+	if (!draw_new_preview_edges(clientState, previewGraph, maxEdges))
 	{
 		cerr << "ERROR: Failed drawing new edges in render_preview_graph! returned: " << vresult << endl;
 		assert(0);
@@ -687,7 +716,7 @@ void draw_func_args(VISSTATE *clientState, ALLEGRO_FONT *font, DCOORD screenCoor
 
 					while (argIt != args->end())
 					{
-							argstring << argIt->first << ": " << argIt->second;
+							argstring << argIt->first << ": " << stored_arg_contents(&argIt->second);
 							++argIt;
 					}
 			}
@@ -719,6 +748,7 @@ void show_extern_labels(VISSTATE *clientState, PROJECTDATA *pd, thread_graph_dat
 	vector<unsigned int> externListCopy = graph->externList;
 	dropMutex(graph->highlightsMutex);
 
+	view_frustum view(pd);
 	vector<unsigned int>::iterator externCallIt = externListCopy.begin();
 	for (; externCallIt != externListCopy.end(); ++externCallIt)
 	{
@@ -728,12 +758,8 @@ void show_extern_labels(VISSTATE *clientState, PROJECTDATA *pd, thread_graph_dat
 		DCOORD screenCoord;
 		if (!n->get_screen_pos(mainverts, pd, &screenCoord)) continue;
 
-		if (clientState->nearSide)
-		{
-			if(!a_coord_on_screen(n->vcoord.a, clientState->leftcolumn,
-				clientState->rightcolumn, graph->m_scalefactors->HEDGESEP))
-				continue;
-		}
+		if (clientState->nearSide && !view.near_side(mainverts->pos_at(n->index)))
+			continue;
 
 		if (is_on_screen(&screenCoord, clientState))
 			draw_func_args(clientState, clientState->standardFont, screenCoord, n);
@@ -741,7 +767,19 @@ void show_extern_labels(VISSTATE *clientState, PROJECTDATA *pd, thread_graph_dat
 }
 
 
-//iterate through all the nodes, draw instruction text for the ones in view
+//brings the grid up to date with the drawn nodes of the main graph
+static node_grid *refresh_node_grid(thread_graph_data *graph)
+{
+	if (graph->nodesMoved)
+	{
+		graph->nodesMoved = false;
+		graph->nodeGrid->reset();
+	}
+	graph->nodeGrid->update(graph->get_mainnodes());
+	return graph->nodeGrid;
+}
+
+//draw instruction text for the nodes in view
 void draw_instruction_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd, thread_graph_data *graph)
 {
 
@@ -749,24 +787,23 @@ void draw_instruction_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd, th
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	bool show_all_always = (clientState->show_ins_text == INSTEXT_ALL_ALWAYS);
-	unsigned int numVerts = graph->get_num_nodes();
 	GRAPH_DISPLAY_DATA *mainverts = graph->get_mainnodes();
+
+	//only looks at the part of the sphere in view. nodes on the far side are
+	//left out unless instruction display is always on
+	view_frustum view(pd);
+	vector<unsigned int> visibleNodes;
+	refresh_node_grid(graph)->visible_nodes(&view, !show_all_always, &visibleNodes);
+
 	stringstream ss;
 	DCOORD screenCoord;
 	string itext("?");
-	for (unsigned int i = 0; i < numVerts; ++i)
+	vector<unsigned int>::iterator visibleIt = visibleNodes.begin();
+	for (; visibleIt != visibleNodes.end(); ++visibleIt)
 	{
-		node_data *n = graph->get_node(i);
+		node_data *n = graph->get_node(*visibleIt);
 		if (n->external) continue;
 
-		//this check removes the bulk of the instructions at a low performance cost, including those
-		//on screen but on the other side of the sphere
-		//implementation is tainted by a horribly derived constant that sometimes rules out nodes on screen
-		//bypass by turning instruction display always on
-		if (!show_all_always && !a_coord_on_screen(n->vcoord.a, clientState->leftcolumn,
-			clientState->rightcolumn, graph->m_scalefactors->HEDGESEP))
-			continue;
-
 		if (!n->get_screen_pos(mainverts, pd, &screenCoord)) continue; //in graph but not rendered
 		if (screenCoord.x > clientState->mainFrameSize.width || screenCoord.x < -100) continue;
 		if (screenCoord.y > clientState->mainFrameSize.height || screenCoord.y < -100) continue;
@@ -779,7 +816,11 @@ void draw_instruction_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd, th
 				itext = n->ins->mnemonic;
 		}
 
-		ss << std::dec << n->index << "-0x" << std::hex << n->ins->address << ":" << itext;
+		//block nodes show where the block starts, its size and how it ends
+		if (n->blockInsCount)
+			ss << std::dec << n->index << "-0x" << std::hex << n->blockAddress << "[" << std::dec << n->blockInsCount << "]:" << itext;
+		else
+			ss << std::dec << n->index << "-0x" << std::hex << n->ins->address << ":" << itext;
 		al_draw_text(clientState->standardFont, al_col_white, screenCoord.x + INS_X_OFF,
 			clientState->mainFrameSize.height - screenCoord.y + INS_Y_OFF, ALLEGRO_ALIGN_LEFT,
 			ss.str().c_str());
@@ -787,6 +828,32 @@ void draw_instruction_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd, th
 	}
 }
 
+//full text of the instruction nearest the mouse
+void draw_mouseover_text(VISSTATE *clientState, PROJECTDATA *pd, thread_graph_data *graph)
+{
+	if (clientState->mouseX < 0 || clientState->mouseX > clientState->mainFrameSize.width) return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	view_frustum view(pd);
+	unsigned int nodeIdx;
+	//opengl screen coordinates start at the bottom
+	if (!refresh_node_grid(graph)->nearest_node(pd, &view, clientState->mouseX,
+		clientState->mainFrameSize.height - clientState->mouseY, MOUSEOVER_NODE_PIXELS, &nodeIdx))
+		return;
+
+	node_data *n = graph->get_node(nodeIdx);
+	if (n->external) return;
+
+	DCOORD screenCoord;
+	if (!n->get_screen_pos(graph->get_mainnodes(), pd, &screenCoord)) return;
+
+	stringstream ss;
+	ss << std::dec << n->index << "-0x" << std::hex << n->ins->address << ": " << n->ins->ins_text;
+	al_draw_text(clientState->standardFont, clientState->config->highlightColour, screenCoord.x + INS_X_OFF,
+		clientState->mainFrameSize.height - screenCoord.y + INS_Y_OFF, ALLEGRO_ALIGN_LEFT,
+		ss.str().c_str());
+}
+
 //only draws text for instructions with unsatisfied conditions
 void draw_condition_ins_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd, GRAPH_DISPLAY_DATA *vertsdata)
 {
@@ -795,26 +862,29 @@ void draw_condition_ins_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd,
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	bool show_all_always = (clientState->show_ins_text == INSTEXT_ALL_ALWAYS);
 	unsigned int numVerts = vertsdata->get_numVerts();
-	GLfloat *vcol = vertsdata->readonly_col();
-	for (unsigned int i = 0; i < numVerts; ++i)
+
+	view_frustum view(pd);
+	vector<unsigned int> visibleNodes;
+	refresh_node_grid(graph)->visible_nodes(&view, true, &visibleNodes);
+
+	vector<unsigned int>::iterator visibleIt = visibleNodes.begin();
+	for (; visibleIt != visibleNodes.end(); ++visibleIt)
 	{
-		node_data *n = graph->get_node(i);
+		if (*visibleIt >= numVerts) continue;
+		node_data *n = graph->get_node(*visibleIt);
 		if (n->external || !n->ins->conditional) continue;
 
-		if (!a_coord_on_screen(n->vcoord.a, clientState->leftcolumn, clientState->rightcolumn,
-			graph->m_scalefactors->HEDGESEP)) continue;
-
 		//todo: experiment with performance re:how much of these checks to include
 		DCOORD screenCoord;
 		if (!n->get_screen_pos(vertsdata, pd, &screenCoord)) continue;
 		if (screenCoord.x > clientState->mainFrameSize.width || screenCoord.x < -100) continue;
 		if (screenCoord.y > clientState->mainFrameSize.height || screenCoord.y < -100) continue;
 
-		const int vectNodePos = n->index*COLELEMS;
+		GLfloat *vcol = vertsdata->col_at(n->index);
 		ALLEGRO_COLOR textcol;
-		textcol.r = vcol[vectNodePos + ROFF];
-		textcol.g = vcol[vectNodePos + GOFF];
-		textcol.b = vcol[vectNodePos + BOFF];
+		textcol.r = vcol[ROFF];
+		textcol.g = vcol[GOFF];
+		textcol.b = vcol[BOFF];
 		textcol.a = 1;
 
 		string itext;
@@ -849,6 +919,7 @@ void draw_edge_heat_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd)
 	int edgelistEnd = graph->heatmaplines->get_renderedEdges();
 
 	set <node_data *> displayNodes;
+	view_frustum view(pd);
 
 	EDGELIST *edgelist = graph->edgeLptr();
 	for (; edgelistIdx < edgelistEnd; ++edgelistIdx)
@@ -858,9 +929,6 @@ void draw_edge_heat_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd)
 
 		//should these checks should be done on the midpoint rather than the first node?
 		if (firstNode->external) continue; //don't care about instruction in library call
-		if (!a_coord_on_screen(firstNode->vcoord.a, clientState->leftcolumn,
-			clientState->rightcolumn, graph->m_scalefactors->HEDGESEP))
-			continue;
 
 		edge_data *e = graph->get_edge(*ePair);
 		if (!e) {
@@ -870,6 +938,7 @@ void draw_edge_heat_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd)
 
 		DCOORD screenCoordA;
 		if(!firstNode->get_screen_pos(vertsdata, pd, &screenCoordA)) continue;
+		if (!view.near_side(vertsdata->pos_at(firstNode->index))) continue;
 
 		if (ePair->second >= graph->get_num_nodes()) continue;
 		DCOORD screenCoordB;
@@ -914,15 +983,22 @@ void draw_edge_heat_text(VISSTATE *clientState, int zdist, PROJECTDATA *pd)
 //standard animated or static display of the active graph
 void display_graph(VISSTATE *clientState, thread_graph_data *graph, PROJECTDATA *pd)
 {
+	float zmul = zoomFactor(clientState->cameraZoomlevel, graph->m_scalefactors->radius);
+	int lodLevel = graph_lod::level_for_zoom(zmul, graph->get_num_nodes());
+
 	if (clientState->modes.animation && !graph->basic)
 		graph->display_active(clientState->modes.nodes, clientState->modes.edges);
+	//full graph until the render thread has built this level
+	else if (lodLevel != LOD_NONE && lodLevel == graph->lod->get_built_level())
+		graph->display_lod(clientState->modes.nodes, clientState->modes.edges);
 	else
 		graph->display_static(clientState->modes.nodes, clientState->modes.edges);
-
-	float zmul = zoomFactor(clientState->cameraZoomlevel, graph->m_scalefactors->radius);
 	
 	if (clientState->show_ins_text && zmul < INSTEXT_VISIBLE_ZOOMFACTOR && graph->get_num_nodes() > 2)
 		draw_instruction_text(clientState, zmul, pd, graph);
+
+	if (clientState->show_ins_text != INSTEXT_NONE)
+		draw_mouseover_text(clientState, pd, graph);
 	
 	//if zoomed in, show all extern labels
 	if (zmul < EXTERN_VISIBLE_ZOOM_FACTOR && clientState->show_extern_text != EXTERNTEXT_NONE)
@@ -1046,9 +1122,9 @@ void display_big_heatmap(VISSTATE *clientState)
 
 	if (graph->needVBOReload_heatmap)
 	{
-		if (!graph->heatmaplines->get_numVerts()) return;
-		load_VBO(0, graph->heatmapEdgeVBO,
-			graph->heatmaplines->col_size(), graph->heatmaplines->readonly_col());
+		unsigned int heatVerts = graph->heatmaplines->get_numVerts();
+		if (!heatVerts) return;
+		load_VBO_palette(0, graph->heatmapEdgeVBO, graph->heatmaplines, heatVerts);
 		graph->needVBOReload_heatmap = false;
 	}
 
@@ -1069,7 +1145,7 @@ void display_big_heatmap(VISSTATE *clientState)
 		glVertexPointer(POSELEMS, GL_FLOAT, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, graph->heatmapEdgeVBO[0]);
-		glColorPointer(COLELEMS, GL_FLOAT, 0, 0);
+		glColorPointer(COLELEMS, GL_UNSIGNED_BYTE, 0, 0);
 
 		glDrawArrays(GL_LINES, 0, graph->heatmaplines->get_numVerts());
 	}
@@ -1100,10 +1176,10 @@ void display_big_conditional(VISSTATE *clientState)
 	{
 		if (!graph->conditionalnodes->get_numVerts() || !graph->conditionallines->get_numVerts()) return;
 
-		load_VBO(VBO_COND_NODE_COLOUR, graph->conditionalVBOs, 
-			graph->conditionalnodes->col_size(), graph->conditionalnodes->readonly_col());
-		load_VBO(VBO_COND_LINE_COLOUR, graph->conditionalVBOs, 
-			graph->conditionallines->col_size(), graph->conditionallines->readonly_col());
+		load_VBO_palette(VBO_COND_NODE_COLOUR, graph->conditionalVBOs, 
+			graph->conditionalnodes, graph->conditionalnodes->get_numVerts());
+		load_VBO_palette(VBO_COND_LINE_COLOUR, graph->conditionalVBOs, 
+			graph->conditionallines, graph->conditionallines->get_numVerts());
 
 		graph->needVBOReload_conditional = false;
 	}
@@ -1120,7 +1196,7 @@ void display_big_conditional(VISSTATE *clientState)
 		glVertexPointer(POSELEMS, GL_FLOAT, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, graph->conditionalVBOs[VBO_COND_NODE_COLOUR]);
-		glColorPointer(COLELEMS, GL_FLOAT, 0, 0);
+		glColorPointer(COLELEMS, GL_UNSIGNED_BYTE, 0, 0);
 		glDrawArrays(GL_POINTS, 0, graph->conditionalnodes->get_numVerts());
 	}
 
@@ -1130,7 +1206,7 @@ void display_big_conditional(VISSTATE *clientState)
 		glVertexPointer(POSELEMS, GL_FLOAT, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, graph->conditionalVBOs[VBO_COND_LINE_COLOUR]);
-		glColorPointer(COLELEMS, GL_FLOAT, 0, 0);
+		glColorPointer(COLELEMS, GL_UNSIGNED_BYTE, 0, 0);
 		glDrawArrays(GL_LINES, 0, graph->conditionallines->get_numVerts());
 
 	}
@@ -0,0 +1,211 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Checkpoints over the block sequence of a thread so replay can seek without stepping
+*/
+#include "stdafx.h"
+#include "replay_index.h"
+
+void replay_index::add_checkpoint()
+{
+	REPLAY_CHECKPOINT checkpoint;
+	checkpoint.sequenceIndex = entries;
+	checkpoint.instructionIndex = instructions;
+	checkpoint.loopsPlayed = loopsStarted;
+	checkpoint.callDelta.assign(pendingCalls.begin(), pendingCalls.end());
+	if (checkpoints.size() % REPLAY_KEYFRAME_INTERVAL == 0)
+		checkpoint.callCounts = totalCalls;
+
+	pendingCalls.clear();
+	checkpoints.push_back(checkpoint);
+}
+
+void replay_index::add_entry(unsigned int insCount, unsigned int loopID, unsigned long iterations, unsigned int lastNode)
+{
+	if (entries % REPLAY_CHECKPOINT_INTERVAL == 0)
+		add_checkpoint();
+
+	if (loopID && loopID != lastLoopID)
+		++loopsStarted;
+	lastLoopID = loopID;
+
+	instructions += insCount * iterations;
+	pendingCalls[lastNode] += iterations;
+	totalCalls[lastNode] += iterations;
+	++entries;
+}
+
+unsigned long replay_index::checkpoint_before_sequence(unsigned long seqIdx)
+{
+	return min(seqIdx / REPLAY_CHECKPOINT_INTERVAL, checkpoints.size() - 1);
+}
+
+unsigned long replay_index::checkpoint_before_instruction(unsigned long insIdx)
+{
+	//last checkpoint starting at or before the instruction
+	unsigned long low = 0, high = checkpoints.size();
+	while (high - low > 1)
+	{
+		unsigned long mid = low + (high - low) / 2;
+		if (checkpoints.at(mid).instructionIndex <= insIdx)
+			low = mid;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+void replay_index::call_counts(unsigned long checkpointIdx, map<unsigned int, unsigned long> *counts)
+{
+	//deltas are relative to the previous checkpoint, so apply those after the keyframe
+	unsigned long keyframe = checkpointIdx - (checkpointIdx % REPLAY_KEYFRAME_INTERVAL);
+	*counts = checkpoints.at(keyframe).callCounts;
+
+	for (unsigned long deltaIdx = keyframe + 1; deltaIdx <= checkpointIdx; ++deltaIdx)
+	{
+		const vector<pair<unsigned int, unsigned long>> *delta = &checkpoints.at(deltaIdx).callDelta;
+		vector<pair<unsigned int, unsigned long>>::const_iterator deltaIt = delta->begin();
+		for (; deltaIt != delta->end(); ++deltaIt)
+			(*counts)[deltaIt->first] += deltaIt->second;
+	}
+}
+
+void replay_cursor::end_loop()
+{
+	looping = false;
+	animLoopProgress.clear();
+	animLoopStartIdx = 0;
+	animLoopIndex = 0;
+	loopIteration = 0;
+	targetIterations = 0;
+}
+
+void replay_cursor::reset()
+{
+	sequenceIndex = 0;
+	animInstructionIndex = 0;
+	loopsPlayed = 0;
+	callCounter.clear();
+	end_loop();
+}
+
+unsigned long replay_cursor::loop_start(execution_sequence *sequence, unsigned long seqIdx)
+{
+	unsigned int loopID = sequence->loop_state(seqIdx).first;
+	if (!loopID) return seqIdx;
+	while (seqIdx && sequence->loop_state(seqIdx - 1).first == loopID)
+		--seqIdx;
+	return seqIdx;
+}
+
+bool replay_cursor::advance(execution_sequence *sequence, unsigned long *executed)
+{
+	if (sequenceIndex + 1 >= sequence->size()) return false;
+
+	*executed = sequenceIndex;
+	animInstructionIndex += sequence->block(sequenceIndex).insCount;
+
+	pair<unsigned int, unsigned long> loopState = sequence->loop_state(sequenceIndex);
+	//if not looping
+	if (!loopState.first)
+	{
+		++sequenceIndex;
+		return true;
+	}
+
+	//first we update loop progress
+
+	//just started loop
+	if (!looping)
+	{
+		looping = true;
+		targetIterations = loopState.second;
+		animLoopIndex = 0;
+		animLoopStartIdx = sequenceIndex;
+		loopIteration = 1;
+		animLoopProgress.push_back(loopIteration);
+	}
+	//block of first iteration of loop
+	else if (animLoopIndex >= animLoopProgress.size())
+	{
+		loopIteration = 1;
+		animLoopProgress.push_back(loopIteration);
+	}
+	else
+	{
+		loopIteration = animLoopProgress.at(animLoopIndex) + 1;
+		animLoopProgress.at(animLoopIndex) = loopIteration;
+	}
+
+	//now set where to go next
+	bool lastBlock = (sequence->loop_state(sequenceIndex + 1).first != loopState.first);
+	//last iteration of this block
+	if (loopIteration >= loopState.second)
+	{
+		if (lastBlock)
+		{
+			++loopsPlayed;
+			end_loop();
+		}
+		else
+			++animLoopIndex;
+		++sequenceIndex;
+	}
+	//last block of loop but not last iteration
+	else if (lastBlock)
+	{
+		sequenceIndex = animLoopStartIdx;
+		animLoopIndex = 0;
+	}
+	else //inside loop
+	{
+		++sequenceIndex;
+		++animLoopIndex;
+	}
+	return true;
+}
+
+bool replay_cursor::seek(execution_sequence *sequence, replay_index *index, replay_nodes *nodes, unsigned long targetSeq)
+{
+	if (targetSeq >= sequence->size() || index->empty()) return false;
+	targetSeq = loop_start(sequence, targetSeq);
+
+	unsigned long checkpointIdx = index->checkpoint_before_sequence(targetSeq);
+	const REPLAY_CHECKPOINT &checkpoint = index->checkpoint(checkpointIdx);
+	map<unsigned int, unsigned long> counts;
+	index->call_counts(checkpointIdx, &counts);
+	unsigned long insIdx = checkpoint.instructionIndex;
+	unsigned int loops = checkpoint.loopsPlayed;
+
+	//at most one checkpoint interval of entries to walk
+	for (unsigned long seqIdx = checkpoint.sequenceIndex; seqIdx < targetSeq; ++seqIdx)
+	{
+		pair<unsigned int, unsigned long> loopState = sequence->loop_state(seqIdx);
+		unsigned long iterations = loopState.first ? loopState.second : 1;
+		if (loopState.first && (!seqIdx || sequence->loop_state(seqIdx - 1).first != loopState.first))
+			++loops;
+		insIdx += sequence->block(seqIdx).insCount * iterations;
+		counts[nodes->get_last_node(seqIdx)] += iterations;
+	}
+
+	sequenceIndex = targetSeq;
+	animInstructionIndex = insIdx;
+	loopsPlayed = loops;
+	callCounter = counts;
+	end_loop();
+	return true;
+}
@@ -43,6 +43,9 @@ Doing agui widget manipulation in other threads will cause deque errors
 #include "timeline.h"
 #include "OSspecific.h"
 #include "clientConfig.h"
+#include "save_inspector.h"
+#include "trace_slicer.h"
+#include "snapshot.h"
 
 #pragma comment(lib, "glu32.lib")
 #pragma comment(lib, "OpenGL32.lib")
@@ -369,16 +372,9 @@ void closeTextLog(VISSTATE *clientState)
 }
 
 /*performs actions that need to be done quite often, but not every frame
-this includes checking the locations of the screen edge on the sphere and
-drawing new highlights for things that match the active filter*/
+this includes drawing new highlights for things that match the active filter*/
 void performIrregularActions(VISSTATE *clientState)
 {
-	SCREEN_EDGE_PIX TBRG;
-	//update where camera is pointing on sphere, used to choose which node text to draw
-	edge_picking_colours(clientState, &TBRG, true);
-	clientState->leftcolumn = (int)floor(ADIVISIONS * TBRG.leftgreen) - 1;
-	clientState->rightcolumn = (int)floor(ADIVISIONS * TBRG.rightgreen) - 1;
-
 	if (clientState->highlightData.highlightState && clientState->activeGraph->active)
 	{
 		TraceVisGUI *widgets = (TraceVisGUI *)clientState->widgets;
@@ -405,6 +401,12 @@ bool process_rgat_args(int argc, char **argv, VISSTATE *clientState)
 			continue;
 		}
 
+		if (arg == "-b")
+		{
+			clientState->launchopts.blockNodes = true;
+			continue;
+		}
+
 		if (arg == "-l")
 		{
 			if (idx + 1 < argc)
@@ -429,6 +431,94 @@ bool process_rgat_args(int argc, char **argv, VISSTATE *clientState)
 			return false;
 		}
 
+		if (arg == "-i")
+		{
+			if (idx + 1 < argc)
+			{
+				clientState->commandlineInspectPath = string(argv[++idx]);
+				continue;
+			}
+			cerr << "[rgat]ERROR: The -i option requires a path to a save file" << endl;
+			return false;
+		}
+
+		if (arg == "-t")
+		{
+			if (idx + 1 < argc && caught_stoi(string(argv[++idx]), &clientState->inspectTopN, 10))
+				continue;
+			cerr << "[rgat]ERROR: The -t option requires a number of entries" << endl;
+			return false;
+		}
+
+		if (arg == "-c")
+		{
+			if (idx + 4 < argc)
+			{
+				clientState->commandlineSlicePath = string(argv[++idx]);
+				if (caught_stoul(string(argv[++idx]), &clientState->sliceTID, 10) &&
+					caught_stoul(string(argv[++idx]), &clientState->sliceStart, 10) &&
+					caught_stoul(string(argv[++idx]), &clientState->sliceEnd, 10))
+					continue;
+			}
+			cerr << "[rgat]ERROR: The -c option requires a save file, thread ID, start and end sequence index" << endl;
+			return false;
+		}
+
+		if (arg == "-g")
+		{
+			if (idx + 1 < argc)
+			{
+				clientState->commandlineSnapshotPath = string(argv[++idx]);
+				continue;
+			}
+			cerr << "[rgat]ERROR: The -g option requires a path to a save file" << endl;
+			return false;
+		}
+
+		if (arg == "-gm")
+		{
+			string mode = (idx + 1 < argc) ? string(argv[++idx]) : "";
+			if (mode == "static") clientState->snapshotView.mode = SNAPSHOT_STATIC;
+			else if (mode == "heat") clientState->snapshotView.mode = SNAPSHOT_HEATMAP;
+			else if (mode == "cond") clientState->snapshotView.mode = SNAPSHOT_CONDITIONAL;
+			else if (mode == "all") clientState->snapshotView.mode = SNAPSHOT_ALL;
+			else
+			{
+				cerr << "[rgat]ERROR: The -gm option requires a mode of static, heat, cond or all" << endl;
+				return false;
+			}
+			continue;
+		}
+
+		if (arg == "-gs")
+		{
+			if (idx + 2 < argc &&
+				caught_stoi(string(argv[++idx]), &clientState->snapshotView.width, 10) &&
+				caught_stoi(string(argv[++idx]), &clientState->snapshotView.height, 10) &&
+				clientState->snapshotView.width && clientState->snapshotView.height)
+				continue;
+			cerr << "[rgat]ERROR: The -gs option requires an image width and height" << endl;
+			return false;
+		}
+
+		if (arg == "-gv")
+		{
+			if (idx + 3 < argc &&
+				caught_stof(string(argv[++idx]), &clientState->snapshotView.xturn) &&
+				caught_stof(string(argv[++idx]), &clientState->snapshotView.yturn) &&
+				caught_stof(string(argv[++idx]), &clientState->snapshotView.zoom) &&
+				clientState->snapshotView.zoom > 0)
+				continue;
+			cerr << "[rgat]ERROR: The -gv option requires x rotation, y rotation and zoom" << endl;
+			return false;
+		}
+
+		if (arg == "-gp")
+		{
+			clientState->snapshotView.png = true;
+			continue;
+		}
+
 		if (arg == "-h" || arg == "-?")
 		{
 			cout << "rgat - Instruction trace visualiser" << endl;
@@ -436,6 +526,15 @@ bool process_rgat_args(int argc, char **argv, VISSTATE *clientState)
 			cout << "-l target Execute target without arguments" << endl;
 			cout << "-p Pause execution on program start. Allows attaching a debugger" << endl;
 			cout << "-s Reduce sleep() calls and shorten tick counts for target" << endl;
+			cout << "-b Graph each basic block as a single node" << endl;
+			cout << "-i savefile Print statistics about a save file without loading it into the GUI" << endl;
+			cout << "-t N Number of hottest blocks/externs listed by -i (default " << INSPECT_DEFAULT_TOPN << ")" << endl;
+			cout << "-c savefile TID start end Cut block sequence entries [start, end) of thread TID into a new save" << endl;
+			cout << "-g savefile Draw an image of every thread graph in a save without opengl" << endl;
+			cout << "-gm mode Display mode drawn by -g: static, heat, cond or all (default static)" << endl;
+			cout << "-gs width height Size of images drawn by -g (default " << SNAPSHOT_DEFAULT_SIZE << "x" << SNAPSHOT_DEFAULT_SIZE << ")" << endl;
+			cout << "-gv xturn yturn zoom Rotation in degrees and zoom of -g images, zoom 1 fits the graph (default 0 0 1)" << endl;
+			cout << "-gp Write -g images as PNG instead of PPM" << endl;
 			return false;
 		}
 		else
@@ -445,6 +544,27 @@ bool process_rgat_args(int argc, char **argv, VISSTATE *clientState)
 		}
 	}
 
+	if (!clientState->commandlineInspectPath.empty())
+	{
+		if (fileExists(clientState->commandlineInspectPath)) return true;
+		cerr << "[rgat]ERROR: Save file [" << clientState->commandlineInspectPath << "] does not exist, exiting..." << endl;
+		return false;
+	}
+
+	if (!clientState->commandlineSlicePath.empty())
+	{
+		if (fileExists(clientState->commandlineSlicePath)) return true;
+		cerr << "[rgat]ERROR: Save file [" << clientState->commandlineSlicePath << "] does not exist, exiting..." << endl;
+		return false;
+	}
+
+	if (!clientState->commandlineSnapshotPath.empty())
+	{
+		if (fileExists(clientState->commandlineSnapshotPath)) return true;
+		cerr << "[rgat]ERROR: Save file [" << clientState->commandlineSnapshotPath << "] does not exist, exiting..." << endl;
+		return false;
+	}
+
 	if (!fileExists(clientState->commandlineLaunchPath))
 	{
 		cerr << "[rgat]ERROR: File [" << clientState->commandlineLaunchPath << "] does not exist, exiting..." << endl;
@@ -525,7 +645,7 @@ bool loadTrace(VISSTATE *clientState, string filename)
 
 	PROCESS_DATA *newpiddata = new PROCESS_DATA;
 	newpiddata->PID = PID;
-	if (!loadProcessData(clientState, &loadfile, newpiddata))
+	if (!loadProcessData(clientState, &loadfile, newpiddata, dirname(filename)))
 	{
 		cout << "[rgat]ERROR: Process data load failed" << endl;
 		return false;
@@ -576,6 +696,14 @@ static int handle_event(ALLEGRO_EVENT *ev, VISSTATE *clientState)
 
 	if (ev->type == ALLEGRO_EVENT_MOUSE_AXES)
 	{
+		if (mouse_in_previewpane(clientState, ev->mouse.x))
+			clientState->mouseX = clientState->mouseY = -1;
+		else
+		{
+			clientState->mouseX = ev->mouse.x;
+			clientState->mouseY = ev->mouse.y;
+		}
+
 		if (!clientState->activeGraph || widgets->isHighlightVisible()) return EV_MOUSE;
 
 		MULTIPLIERS *mainscale = clientState->activeGraph->m_scalefactors;
@@ -739,6 +867,33 @@ static int handle_event(ALLEGRO_EVENT *ev, VISSTATE *clientState)
 					change_mode(clientState, EV_BTN_HEATMAP);
 					break;
 
+				//mark replay position, then limit heat to between there and the new position
+				case ALLEGRO_KEY_H:
+				{
+					thread_graph_data *graph = clientState->activeGraph;
+					if (graph->get_heat_window().second)
+					{
+						graph->set_heat_window(0, 0);
+						cout << "[rgat]Heatmap showing whole trace" << endl;
+					}
+					else if (!clientState->heatWindowMarked)
+					{
+						clientState->heatWindowMark = graph->get_sequence_index();
+						clientState->heatWindowMarked = true;
+						cout << "[rgat]Heat window marked at block " << clientState->heatWindowMark << endl;
+					}
+					else
+					{
+						unsigned long position = graph->get_sequence_index();
+						unsigned long start = min(position, clientState->heatWindowMark);
+						unsigned long end = max(position, clientState->heatWindowMark) + 1;
+						graph->set_heat_window(start, end);
+						clientState->heatWindowMarked = false;
+						cout << "[rgat]Heatmap showing blocks " << start << " to " << end << endl;
+					}
+					break;
+				}
+
 				case ALLEGRO_KEY_M:
 					clientState->show_extern_text++;
 					if (clientState->show_extern_text > EXTERNTEXT_LAST)
@@ -977,11 +1132,16 @@ static int handle_event(ALLEGRO_EVENT *ev, VISSTATE *clientState)
 			return EV_NONE;
 	}
 
+	if (ev->type == ALLEGRO_EVENT_MOUSE_LEAVE_DISPLAY)
+	{
+		clientState->mouseX = clientState->mouseY = -1;
+		return EV_NONE;
+	}
+
 	switch (ev->type) {
 		case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
 		case ALLEGRO_EVENT_DISPLAY_SWITCH_OUT:
 		case ALLEGRO_EVENT_KEY_DOWN: //agui doesn't like this
-		case ALLEGRO_EVENT_MOUSE_LEAVE_DISPLAY:
 		case ALLEGRO_EVENT_KEY_UP:
 		case ALLEGRO_EVENT_MOUSE_ENTER_DISPLAY:
 		case ALLEGRO_EVENT_KEY_CHAR:
@@ -1058,6 +1218,19 @@ int main(int argc, char **argv)
 	{
 		if(!process_rgat_args(argc, argv, &clientState)) return 0;
 
+		if (!clientState.commandlineInspectPath.empty())
+			return inspect_save(&clientState, clientState.commandlineInspectPath, clientState.inspectTopN);
+
+		if (!clientState.commandlineSlicePath.empty())
+		{
+			string slicefile = slice_path(clientState.commandlineSlicePath, clientState.sliceTID, clientState.sliceStart, clientState.sliceEnd);
+			return slice_trace(&clientState, clientState.commandlineSlicePath, clientState.sliceTID,
+				clientState.sliceStart, clientState.sliceEnd, slicefile) ? 0 : 1;
+		}
+
+		if (!clientState.commandlineSnapshotPath.empty())
+			return snapshot_save(&clientState, clientState.commandlineSnapshotPath, &clientState.snapshotView) ? 0 : 1;
+
 		handleKBDExit();
 
 		HANDLE hProcessCoordinator = CreateThread(
@@ -1146,7 +1319,7 @@ int main(int argc, char **argv)
 	al_register_event_source(frame_timer_queue, al_get_timer_event_source(frametimer));
 	al_start_timer(frametimer);
 
-	//edge_picking_colours() is a hefty call, but doesn't need calling often
+	//highlight updates are hefty, but don't need doing often
 	ALLEGRO_TIMER *updatetimer = al_create_timer(40.0 / 60.0);
 	ALLEGRO_EVENT_QUEUE *low_frequency_timer_queue = al_create_event_queue();
 	al_register_event_source(low_frequency_timer_queue, al_get_timer_event_source(updatetimer));
@@ -1255,7 +1428,6 @@ int main(int argc, char **argv)
 
 				clientState.wireframe_sphere = new GRAPH_DISPLAY_DATA(WFCOLBUFSIZE * 2);
 				plot_wireframe(&clientState);
-				plot_colourpick_sphere(&clientState);
 
 				widgets->toggleSmoothDrawing(false);
 				graph->assign_modpath(activePid);
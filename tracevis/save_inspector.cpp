@@ -0,0 +1,418 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Headless save inspector
+Process data (modules, symbols, disassembly) is loaded with the normal loader as it is
+bounded by code size. Thread data is streamed one node/edge/sequence entry at a time.
+*/
+#include "stdafx.h"
+#include "save_inspector.h"
+#include "serialise.h"
+#include "node_data.h"
+#include "traceMisc.h"
+#include "GUIConstants.h"
+
+struct THREAD_SUMMARY {
+	PID_TID TID = 0;
+	unsigned long instructionNodes = 0;
+	unsigned long externNodes = 0;
+	unsigned long edges = 0;
+	unsigned long edgeClasses[IEXCEPT + 1] = { 0 };
+	unsigned long externs = 0;
+	unsigned long exceptions = 0;
+	unsigned long sequenceEntries = 0;
+	unsigned long loopEntries = 0;
+	unsigned long loopIterations = 0;
+	unsigned int loopCounter = 0;
+	unsigned long totalInstructions = 0;
+	unsigned long externCallRecords = 0;
+
+	//these grow with code size, not trace length
+	map<MEM_ADDRESS, unsigned long> blockHeat;
+	map<pair<int, MEM_ADDRESS>, unsigned long> externHeat;
+
+	vector<pair<string, streamoff>> sectionSizes;
+};
+
+static void markSection(ifstream *file, THREAD_SUMMARY *summary, string name, streamoff *lastPos)
+{
+	streamoff pos = file->tellg();
+	summary->sectionSizes.push_back(make_pair(name, pos - *lastPos));
+	*lastPos = pos;
+}
+
+static bool streamNodes(ifstream *file, PROCESS_DATA *piddata, map<INS_DATA *, MEM_ADDRESS> *blockStarts, THREAD_SUMMARY *summary)
+{
+	if (!verifyTag(file, tag_START, 'N')) return false;
+
+	while (true)
+	{
+		//only one node exists at a time
+		node_data n;
+		int result = n.unserialise(file, &piddata->disassembly);
+		if (result < 0) return false;
+		if (result == 0) return true;
+
+		if (n.external)
+		{
+			++summary->externNodes;
+			summary->externHeat[make_pair(n.nodeMod, n.address)] += n.executionCount;
+			continue;
+		}
+
+		++summary->instructionNodes;
+		map<INS_DATA *, MEM_ADDRESS>::iterator blockIt = blockStarts->find(n.ins);
+		MEM_ADDRESS blockAddr = (blockIt != blockStarts->end()) ? blockIt->second : n.ins->address;
+		unsigned long *heat = &summary->blockHeat[blockAddr];
+		if (n.executionCount > *heat)
+			*heat = n.executionCount;
+	}
+}
+
+//node loader consumes the D tag
+static bool streamEdges(ifstream *file, THREAD_SUMMARY *summary)
+{
+	string value_s;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}D") return true;
+		if (!file->good()) return false;
+		getline(*file, value_s, ',');
+		getline(*file, value_s, '@');
+		++summary->edges;
+		unsigned char edgeClass = value_s.c_str()[0];
+		if (edgeClass <= IEXCEPT)
+			++summary->edgeClasses[edgeClass];
+	}
+}
+
+//counts a { , separated } list such as externs or exceptions
+static bool streamIndexList(ifstream *file, char tag, unsigned long *count)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != tag) return false;
+
+	string endtag = string("}") + tag;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == endtag) return true;
+		if (!file->good()) return false;
+		++*count;
+	}
+}
+
+static bool streamStats(ifstream *file, THREAD_SUMMARY *summary)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'S') return false;
+
+	//maxA, maxB
+	getline(*file, value_s, ',');
+	getline(*file, value_s, ',');
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &summary->loopCounter, 10)) return false;
+	//baseMod
+	getline(*file, value_s, ',');
+	getline(*file, value_s, '}');
+	if (!caught_stoul(value_s, &summary->totalInstructions, 10)) return false;
+	getline(*file, value_s, ',');
+	return (value_s.c_str()[0] == 'S');
+}
+
+static bool streamAnimationData(ifstream *file, THREAD_SUMMARY *summary)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'A') return false;
+
+	unsigned int loopIdx;
+	unsigned long iterations;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}A") return true;
+		if (!file->good()) return false;
+
+		//block size, blockID
+		getline(*file, value_s, ',');
+		getline(*file, value_s, ',');
+
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &loopIdx, 10)) return false;
+		++summary->sequenceEntries;
+		if (loopIdx)
+		{
+			getline(*file, value_s, ',');
+			if (!caught_stoul(value_s, &iterations, 10)) return false;
+			++summary->loopEntries;
+			summary->loopIterations += iterations;
+		}
+	}
+}
+
+static bool streamCallSequence(ifstream *file, THREAD_SUMMARY *summary)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'C') return false;
+
+	unsigned int listSize;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}C") return true;
+		if (!file->good()) return false;
+
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &listSize, 10)) return false;
+		for (unsigned int i = 0; i < listSize * 2; ++i)
+			getline(*file, value_s, ',');
+		summary->externCallRecords += listSize;
+	}
+}
+
+//count,uncertain pairs for each edge
+static bool skipEdgeCounts(ifstream *file)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s != "W") return false;
+	getline(*file, value_s, '}');
+	getline(*file, value_s, ',');
+	return value_s == "W";
+}
+
+//skips the optional rendered buffer section without holding the buffers
+static bool skipDisplayBuffers(ifstream *file)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s != "G") return false;
+
+	//multipliers size, 2 multipliers, heat extremes
+	for (int i = 0; i < 5; ++i)
+		getline(*file, value_s, ',');
+
+	for (int buf = 0; buf < 5; ++buf)
+	{
+		for (int i = 0; i < 4; ++i)
+			getline(*file, value_s, ',');
+		file->ignore(numeric_limits<streamsize>::max(), ',');
+		file->ignore(numeric_limits<streamsize>::max(), ',');
+	}
+
+	unsigned long numEdges;
+	getline(*file, value_s, ',');
+	if (!caught_stoul(value_s, &numEdges, 10)) return false;
+	for (unsigned long i = 0; i < numEdges * 2; ++i)
+		file->ignore(numeric_limits<streamsize>::max(), ',');
+
+	getline(*file, value_s, ',');
+	return (value_s == "}G");
+}
+
+template <typename K>
+static vector<pair<K, unsigned long>> topEntries(map<K, unsigned long> *heatmap, unsigned int topN)
+{
+	vector<pair<K, unsigned long>> entries(heatmap->begin(), heatmap->end());
+	size_t count = min((size_t)topN, entries.size());
+	partial_sort(entries.begin(), entries.begin() + count, entries.end(),
+		[](const pair<K, unsigned long> &a, const pair<K, unsigned long> &b) { return a.second > b.second; });
+	entries.resize(count);
+	return entries;
+}
+
+static void printThreadSummary(THREAD_SUMMARY *summary, PROCESS_DATA *piddata, unsigned int topN)
+{
+	cout << endl << "Thread " << dec << summary->TID << endl;
+	cout << "  Nodes: " << summary->instructionNodes + summary->externNodes
+		<< " (" << summary->instructionNodes << " instruction, " << summary->externNodes << " extern)" << endl;
+	cout << "  Edges: " << summary->edges << " (call " << summary->edgeClasses[ICALL]
+		<< ", old " << summary->edgeClasses[IOLD] << ", ret " << summary->edgeClasses[IRET]
+		<< ", lib " << summary->edgeClasses[ILIB] << ", new " << summary->edgeClasses[INEW]
+		<< ", exception " << summary->edgeClasses[IEXCEPT] << ")" << endl;
+	cout << "  Instructions executed: " << summary->totalInstructions << endl;
+	cout << "  Block sequence entries: " << summary->sequenceEntries << endl;
+	cout << "  Loops: " << summary->loopCounter << " (" << summary->loopEntries << " looped entries, "
+		<< summary->loopIterations << " iterations)" << endl;
+	cout << "  Exceptions: " << summary->exceptions << endl;
+	cout << "  Extern call records: " << summary->externCallRecords << endl;
+
+	cout << "  Hottest blocks:" << endl;
+	vector<pair<MEM_ADDRESS, unsigned long>> hotBlocks = topEntries(&summary->blockHeat, topN);
+	for (size_t i = 0; i < hotBlocks.size(); ++i)
+		cout << "    0x" << hex << hotBlocks[i].first << dec << "  " << hotBlocks[i].second << endl;
+
+	cout << "  Most called externs:" << endl;
+	vector<pair<pair<int, MEM_ADDRESS>, unsigned long>> hotExterns = topEntries(&summary->externHeat, topN);
+	for (size_t i = 0; i < hotExterns.size(); ++i)
+	{
+		string sym, modpath;
+		piddata->get_sym(hotExterns[i].first.first, hotExterns[i].first.second, &sym);
+		piddata->get_modpath(hotExterns[i].first.first, &modpath);
+		if (sym.empty())
+		{
+			stringstream addr_ss;
+			addr_ss << "0x" << hex << hotExterns[i].first.second;
+			sym = addr_ss.str();
+		}
+		cout << "    " << basename(modpath) << ":" << sym << "  " << dec << hotExterns[i].second << endl;
+	}
+
+	cout << "  Section sizes (bytes):";
+	vector<pair<string, streamoff>>::iterator sectionIt = summary->sectionSizes.begin();
+	for (; sectionIt != summary->sectionSizes.end(); ++sectionIt)
+		cout << " " << sectionIt->first << "=" << sectionIt->second;
+	cout << endl;
+}
+
+static bool inspectThread(ifstream *file, PROCESS_DATA *piddata, map<INS_DATA *, MEM_ADDRESS> *blockStarts, unsigned int topN)
+{
+	THREAD_SUMMARY summary;
+	string tidstring;
+	getline(*file, tidstring, '{');
+	if (!caught_stoul(tidstring, &summary.TID, 10)) return false;
+
+	streamoff lastPos = file->tellg();
+	if (!streamNodes(file, piddata, blockStarts, &summary)) {
+		cerr << "[rgat]ERROR: Bad node data in thread " << summary.TID << endl; return false;
+	}
+	markSection(file, &summary, "nodes", &lastPos);
+
+	if (!streamEdges(file, &summary)) {
+		cerr << "[rgat]ERROR: Bad edge data in thread " << summary.TID << endl; return false;
+	}
+	markSection(file, &summary, "edges", &lastPos);
+
+	if (!streamIndexList(file, 'E', &summary.externs)) return false;
+	if (!streamIndexList(file, 'X', &summary.exceptions)) return false;
+	if (!streamStats(file, &summary)) return false;
+	markSection(file, &summary, "externs+exceptions+stats", &lastPos);
+
+	if (!streamAnimationData(file, &summary)) {
+		cerr << "[rgat]ERROR: Bad sequence data in thread " << summary.TID << endl; return false;
+	}
+	markSection(file, &summary, "sequence", &lastPos);
+
+	if (!streamCallSequence(file, &summary)) return false;
+	markSection(file, &summary, "calls", &lastPos);
+
+	if (file->peek() == 'W')
+	{
+		if (!skipEdgeCounts(file)) return false;
+		markSection(file, &summary, "edge counts", &lastPos);
+	}
+
+	if (file->peek() == 'G')
+	{
+		if (!skipDisplayBuffers(file)) return false;
+		markSection(file, &summary, "buffers", &lastPos);
+	}
+
+	if (file->peek() != '}') return false;
+	file->seekg(1, ios::cur);
+
+	printThreadSummary(&summary, piddata, topN);
+	return true;
+}
+
+bool inspect_save(VISSTATE *clientState, string filename, unsigned int topN)
+{
+	vector<char> readBuffer(INSPECT_READ_BUFSIZE);
+	ifstream loadfile;
+	loadfile.rdbuf()->pubsetbuf(&readBuffer.at(0), readBuffer.size());
+	loadfile.open(filename, std::ifstream::binary);
+	if (!loadfile.is_open())
+	{
+		cerr << "[rgat]ERROR: Failed to open " << filename << endl;
+		return false;
+	}
+
+	string s1, PID_s;
+	int PID;
+	loadfile >> s1;
+	if (s1 != "PID") {
+		cerr << "[rgat]ERROR: Corrupt save, start = " << s1 << endl;
+		return false;
+	}
+	loadfile >> PID_s;
+	if (!caught_stoi(PID_s, &PID, 10)) return false;
+	loadfile.seekg(1, ios::cur);
+
+	streamoff processStart = loadfile.tellg();
+	PROCESS_DATA piddata;
+	piddata.PID = PID;
+	if (!loadProcessData(clientState, &loadfile, &piddata, dirname(filename)))
+	{
+		cerr << "[rgat]ERROR: Process data load failed" << endl;
+		return false;
+	}
+	streamoff processSize = loadfile.tellg() - processStart;
+
+	cout << "Save: " << filename << endl;
+	cout << "PID: " << PID << endl;
+	cout << "Process data: " << processSize << " bytes, " << piddata.disassembly.size()
+		<< " instruction addresses, " << piddata.blocklist.size() << " block addresses" << endl;
+
+	cout << "Modules:" << endl;
+	map<int, string>::iterator pathIt = piddata.modpaths.begin();
+	for (; pathIt != piddata.modpaths.end(); ++pathIt)
+	{
+		unsigned long numSyms = 0;
+		if (piddata.modsymsPlain.count(pathIt->first))
+			numSyms = piddata.modsymsPlain.at(pathIt->first).size();
+		cout << "  " << pathIt->first << ": " << pathIt->second << " (" << numSyms << " symbols)" << endl;
+	}
+
+	//instructions don't know their block after a load, build the reverse mapping
+	map<INS_DATA *, MEM_ADDRESS> blockStarts;
+	map <MEM_ADDRESS, map<BLOCK_IDENTIFIER, INSLIST *>>::iterator blockIt = piddata.blocklist.begin();
+	for (; blockIt != piddata.blocklist.end(); ++blockIt)
+	{
+		map<BLOCK_IDENTIFIER, INSLIST *>::iterator blockIDIt = blockIt->second.begin();
+		for (; blockIDIt != blockIt->second.end(); ++blockIDIt)
+		{
+			INSLIST::iterator insIt = blockIDIt->second->begin();
+			for (; insIt != blockIDIt->second->end(); ++insIt)
+				blockStarts.emplace(*insIt, blockIt->first);
+		}
+	}
+
+	char tagbuf[3];
+	unsigned int threadCount = 0;
+	//peek sets eof at the end of the file and tellg fails after that, so keep the position first
+	streamoff bytesRead = loadfile.tellg();
+	while (loadfile.peek() == 'T')
+	{
+		loadfile.read(tagbuf, 3);
+		if (strncmp(tagbuf, "TID", 3)) break;
+		if (!inspectThread(&loadfile, &piddata, &blockStarts, topN))
+		{
+			cerr << "[rgat]ERROR: Thread data corrupt at offset " << loadfile.tellg() << endl;
+			return false;
+		}
+		++threadCount;
+		bytesRead = loadfile.tellg();
+	}
+
+	cout << endl << threadCount << " threads, " << bytesRead << " bytes read" << endl;
+	return true;
+}
@@ -0,0 +1,120 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Running execution totals of each block over a thread's sequence
+*/
+#include "stdafx.h"
+#include "sequence_counts.h"
+#include <climits>
+
+void sequence_counts::index(execution_sequence *sequence)
+{
+	unsigned long sequenceSize = sequence->size();
+	for (; indexed < sequenceSize; ++indexed)
+	{
+		BLOCK_HANDLE handle = sequence->handle(indexed);
+		pair<unsigned int, unsigned long> loopState = sequence->loop_state(indexed);
+		unsigned long executions = loopState.first ? loopState.second : 1;
+
+		if (handle >= totals.size())
+		{
+			totals.resize(handle + 1, 0);
+			checkpoints.resize(handle + 1);
+		}
+
+		if (!totals[handle])
+			seenHandles.push_back(handle);
+		//first run since the block's last checkpoint
+		unsigned long lastCheckpointed = checkpoints[handle].empty() ? 0 : checkpoints[handle].back().second;
+		if (totals[handle] == lastCheckpointed)
+			touched.push_back(handle);
+		totals[handle] += executions;
+
+		//totals before the next entry, for the blocks that moved
+		if ((indexed + 1) % SEQCOUNT_CHECKPOINT_INTERVAL == 0)
+		{
+			unsigned long checkpointIdx = (indexed + 1) / SEQCOUNT_CHECKPOINT_INTERVAL;
+			vector<BLOCK_HANDLE>::iterator touchedIt = touched.begin();
+			for (; touchedIt != touched.end(); ++touchedIt)
+			{
+				vector<pair<unsigned long, unsigned long>> *blockCheckpoints = &checkpoints[*touchedIt];
+				if (blockCheckpoints->empty() || blockCheckpoints->back().first != checkpointIdx)
+					blockCheckpoints->push_back(make_pair(checkpointIdx, totals[*touchedIt]));
+			}
+			touched.clear();
+		}
+	}
+}
+
+unsigned long sequence_counts::checkpoint_total(BLOCK_HANDLE handle, unsigned long checkpointIdx)
+{
+	vector<pair<unsigned long, unsigned long>> *blockCheckpoints = &checkpoints[handle];
+	vector<pair<unsigned long, unsigned long>>::iterator firstAfter = upper_bound(blockCheckpoints->begin(),
+		blockCheckpoints->end(), make_pair(checkpointIdx, ULONG_MAX));
+	if (firstAfter == blockCheckpoints->begin()) return 0;
+	return (firstAfter - 1)->second;
+}
+
+void sequence_counts::count_from_checkpoint(execution_sequence *sequence, unsigned long seqIdx, 
+	map<BLOCK_HANDLE, unsigned long> *counts)
+{
+	unsigned long walkIdx = seqIdx - (seqIdx % SEQCOUNT_CHECKPOINT_INTERVAL);
+	for (; walkIdx < seqIdx; ++walkIdx)
+	{
+		pair<unsigned int, unsigned long> loopState = sequence->loop_state(walkIdx);
+		(*counts)[sequence->handle(walkIdx)] += loopState.first ? loopState.second : 1;
+	}
+}
+
+void sequence_counts::window_counts(execution_sequence *sequence, unsigned long start, unsigned long end, 
+	map<BLOCK_HANDLE, unsigned long> *counts)
+{
+	end = min(end, indexed);
+	if (start >= end) return;
+
+	//both ends between the same checkpoints, just count the entries
+	unsigned long startCheckpoint = start / SEQCOUNT_CHECKPOINT_INTERVAL;
+	unsigned long endCheckpoint = end / SEQCOUNT_CHECKPOINT_INTERVAL;
+	if (startCheckpoint == endCheckpoint)
+	{
+		for (unsigned long seqIdx = start; seqIdx < end; ++seqIdx)
+		{
+			pair<unsigned int, unsigned long> loopState = sequence->loop_state(seqIdx);
+			(*counts)[sequence->handle(seqIdx)] += loopState.first ? loopState.second : 1;
+		}
+		return;
+	}
+
+	map<BLOCK_HANDLE, unsigned long> startExtra, endExtra;
+	count_from_checkpoint(sequence, start, &startExtra);
+	count_from_checkpoint(sequence, end, &endExtra);
+
+	vector<BLOCK_HANDLE>::iterator handleIt = seenHandles.begin();
+	for (; handleIt != seenHandles.end(); ++handleIt)
+	{
+		unsigned long endTotal = checkpoint_total(*handleIt, endCheckpoint);
+		map<BLOCK_HANDLE, unsigned long>::iterator extraIt = endExtra.find(*handleIt);
+		if (extraIt != endExtra.end()) endTotal += extraIt->second;
+
+		unsigned long startTotal = checkpoint_total(*handleIt, startCheckpoint);
+		extraIt = startExtra.find(*handleIt);
+		if (extraIt != startExtra.end()) startTotal += extraIt->second;
+
+		if (endTotal > startTotal)
+			counts->emplace(*handleIt, endTotal - startTotal);
+	}
+}
@@ -25,6 +25,7 @@ Graph/Process Saving/Loading routines
 #include "basicblock_handler.h"
 #include "OSspecific.h"
 #include "GUIManagement.h"
+#include "module_cache.h"
 
 #define tag_START '{'
 #define tag_END '}'
@@ -72,7 +73,8 @@ void saveModulePaths(PROCESS_DATA *piddata, ofstream *file)
 }
 
 //big, but worth doing in case environments differ
-void saveModuleSymbols(PROCESS_DATA *piddata, ofstream *file)
+//tables are written to the module cache and referenced by key where possible
+void saveModuleSymbols(PROCESS_DATA *piddata, ofstream *file, string saveDir)
 {
 	writetag(file, tag_START, tag_SYM);
 	*file << " ";
@@ -80,6 +82,19 @@ void saveModuleSymbols(PROCESS_DATA *piddata, ofstream *file)
 	for (; modSymIt != piddata->modsymsPlain.end(); ++modSymIt)
 	{
 		*file << modSymIt->first;
+
+		MEM_ADDRESS modbase = 0;
+		if (piddata->modBounds.count(modSymIt->first))
+			modbase = piddata->modBounds.at(modSymIt->first).first;
+
+		string encodedSyms = modcache_encode_syms(&modSymIt->second, modbase);
+		string key = modcache_key(piddata->modpaths[modSymIt->first], &encodedSyms);
+		if (!saveDir.empty() && modcache_store(saveDir, key, &encodedSyms))
+		{
+			*file << MODCACHE_REF << key << "@" << modbase << " ";
+			continue;
+		}
+
 		writetag(file, tag_START);
 		map<MEM_ADDRESS, string> ::iterator symIt = modSymIt->second.begin();
 		for (; symIt != modSymIt->second.end(); symIt++)
@@ -145,14 +160,14 @@ void saveBlockData(PROCESS_DATA *piddata, ofstream *file)
 	writetag(file, tag_END, tag_DISAS);
 }
 
-void saveProcessData(PROCESS_DATA *piddata, ofstream *file)
+void saveProcessData(PROCESS_DATA *piddata, ofstream *file, string saveDir)
 {
 	writetag(file, tag_START, tag_PROCESSDATA);
 
 	saveModulePaths(piddata, file);
 	*file << " ";
 
-	saveModuleSymbols(piddata, file);
+	saveModuleSymbols(piddata, file, saveDir);
 	*file << " ";
 
 	saveDisassembly(piddata, file);
@@ -208,7 +223,7 @@ void saveTrace(VISSTATE * clientState)
 	}
 
 	savefile << "PID " << clientState->activePid->PID << " ";
-	saveProcessData(clientState->activePid, &savefile);
+	saveProcessData(clientState->activePid, &savefile, dirname(path));
 
 	obtainMutex(clientState->activePid->graphsListMutex, 1012);
 	map <PID_TID, void *>::iterator graphit = clientState->activePid->graphs.begin();
@@ -220,7 +235,7 @@ void saveTrace(VISSTATE * clientState)
 			continue;
 		}
 		cout << "[rgat]Serialising graph: "<< graphit->first << endl;
-		graph->serialise(&savefile);
+		graph->serialise(&savefile, clientState->config->saveRenderedBuffers);
 	}
 	dropMutex(clientState->activePid->graphsListMutex);
 
@@ -286,7 +301,7 @@ int extractmodsyms(stringstream *blob, int modnum, PROCESS_DATA* piddata)
 }
 
 //load process data not specific to threads
-bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddata)
+bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddata, string saveDir)
 {
 	
 	if (!verifyTag(file, tag_START, tag_PROCESSDATA)) {
@@ -341,6 +356,32 @@ bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddat
 		*file >> modSymsBlob_s;
 		if (modSymsBlob_s == endTagStr) break;
 
+		//reference to module cache entry: modnum#key@modbase
+		size_t refPos = modSymsBlob_s.find(MODCACHE_REF);
+		if (refPos != string::npos)
+		{
+			if (!caught_stoi(modSymsBlob_s.substr(0, refPos), &modnum, 10)) return false;
+
+			stringstream rss(modSymsBlob_s.substr(refPos + 1));
+			string key, modbase_s;
+			MEM_ADDRESS modbase;
+			getline(rss, key, '@');
+			getline(rss, modbase_s, ' ');
+			if (!caught_stoul(modbase_s, &modbase, 10)) return false;
+
+			//saves made before the cache moved beside them kept it in the configured save directory
+			if (!modcache_load_syms(saveDir, key, modbase, modnum, piddata) &&
+				!modcache_load_syms(clientState->config->saveDir, key, modbase, modnum, piddata))
+			{
+				cerr << "[rgat]ERROR: Module cache entry " << key << " for module " << modnum << " not found in " <<
+					saveDir << MODCACHE_DIR << " or " << clientState->config->saveDir << MODCACHE_DIR << endl;
+				display_only_status_message("Load failed: module cache entry missing", clientState);
+				return false;
+			}
+			if (count++ > 255) return false;
+			continue;
+		}
+
 		stringstream mss(modSymsBlob_s);
 		getline(mss, modNum_s, '{');
 		if (!caught_stoi(modNum_s, &modnum, 10)) return false;
@@ -388,7 +429,8 @@ bool loadProcessData(VISSTATE *clientState, ifstream *file, PROCESS_DATA* piddat
 			INS_DATA *ins = new INS_DATA;
 			
 			getline(*file, opcodes, ',');
-			disassemble_ins(hCapstone, opcodes, ins, address);
+			modcache_disassemble(hCapstone, opcodes, ins, address);
+			ins->mutationIndex = midx;
 			mutationVector.push_back(ins);
 
 			string threadVertSize_s;
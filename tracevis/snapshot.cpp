@@ -0,0 +1,523 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Draws graphs into images without opengl
+Vertices are projected the way the main display projects them, then the image is
+split into bands of rows that are drawn on the geometry workers
+*/
+#include "stdafx.h"
+#include "snapshot.h"
+#include "geometry_workers.h"
+#include "rendering.h"
+#include "serialise.h"
+#include "traceMisc.h"
+#include "render_heatmap_thread.h"
+#include "render_conditional_thread.h"
+
+struct SCREEN_POINT {
+	bool visible;
+	float x, y;
+	const GLfloat *col;
+};
+
+struct SCREEN_LINE {
+	bool visible;
+	float x0, y0, x1, y1;
+	GLfloat col0[COLELEMS];
+	GLfloat col1[COLELEMS];
+};
+
+//vertex data of one image and what it becomes on screen
+struct SNAPSHOT_SCENE {
+	//modelview rotation, then the camera is distance along z
+	float rotation[9];
+	float distance;
+	float farClip;
+	//projection of x/y at distance 1
+	float xScale, yScale;
+	unsigned int width, height;
+
+	unsigned long nodeCount, lineCount;
+	vector<GLfloat> nodePos, nodeCol;
+	vector<GLfloat> linePos, lineCol;
+
+	vector<SCREEN_POINT> points;
+	vector<SCREEN_LINE> lines;
+	//points/lines touching each band, in draw order
+	vector<vector<unsigned long>> bandPoints;
+	vector<vector<unsigned long>> bandLines;
+
+	SNAPSHOT_IMAGE *image;
+};
+
+//translate(0,0,-distance) * rotate(-yturn, x axis) * rotate(-xturn, y axis), as rotate_to_user_view
+static void setup_camera(SNAPSHOT_SCENE *scene, SNAPSHOT_VIEW *view, float radius)
+{
+	float x = float(-view->xturn * M_PI / 180);
+	float y = float(-view->yturn * M_PI / 180);
+	float cosx = cos(x), sinx = sin(x), cosy = cos(y), siny = sin(y);
+	float rotation[9] = { cosx, 0, sinx,
+		siny * sinx, cosy, -siny * cosx,
+		-cosy * sinx, siny, cosy * cosx };
+	std::copy(rotation, rotation + 9, scene->rotation);
+
+	float aspect = float(view->width) / view->height;
+	float tanHalfFov = float(tan(SNAPSHOT_FOV * M_PI / 360));
+	scene->yScale = 1 / tanHalfFov;
+	scene->xScale = scene->yScale / aspect;
+
+	//narrowest of the two fields of view decides how far away the sphere fits
+	float halfFov = atan(tanHalfFov * min(aspect, 1.0f));
+	scene->distance = float(view->zoom * SNAPSHOT_FIT_MARGIN * radius / sin(halfFov));
+	scene->farClip = scene->distance + radius;
+	scene->width = view->width;
+	scene->height = view->height;
+}
+
+static void to_eye(SNAPSHOT_SCENE *scene, const GLfloat *pos, float *eye)
+{
+	const float *r = scene->rotation;
+	eye[0] = r[0] * pos[0] + r[1] * pos[1] + r[2] * pos[2];
+	eye[1] = r[3] * pos[0] + r[4] * pos[1] + r[5] * pos[2];
+	eye[2] = r[6] * pos[0] + r[7] * pos[1] + r[8] * pos[2] - scene->distance;
+}
+
+//pixel coordinates, y down from the top row
+static void to_screen(SNAPSHOT_SCENE *scene, const float *eye, float *x, float *y)
+{
+	float depth = -eye[2];
+	*x = (eye[0] * scene->xScale / depth + 1) * 0.5f * scene->width;
+	*y = (1 - eye[1] * scene->yScale / depth) * 0.5f * scene->height;
+}
+
+static void lerp(const float *a, const float *b, float t, int elems, float *out)
+{
+	for (int elem = 0; elem < elems; ++elem)
+		out[elem] = a[elem] + (b[elem] - a[elem]) * t;
+}
+
+static void project_points_slice(void *context, unsigned long first, unsigned long last)
+{
+	SNAPSHOT_SCENE *scene = (SNAPSHOT_SCENE *)context;
+	float halfPoint = DEFAULTPOINTSIZE / 2.0f;
+	for (unsigned long pointIdx = first; pointIdx < last; ++pointIdx)
+	{
+		SCREEN_POINT *point = &scene->points[pointIdx];
+		point->col = &scene->nodeCol[pointIdx * COLELEMS];
+
+		float eye[3];
+		to_eye(scene, &scene->nodePos[pointIdx * POSELEMS], eye);
+		point->visible = (-eye[2] >= SNAPSHOT_NEAR && -eye[2] <= scene->farClip && point->col[AOFF] > 0);
+		if (!point->visible) continue;
+
+		to_screen(scene, eye, &point->x, &point->y);
+		if (point->x < -halfPoint || point->x > scene->width + halfPoint ||
+			point->y < -halfPoint || point->y > scene->height + halfPoint)
+			point->visible = false;
+	}
+}
+
+//cuts the part of a line outside min <= p + dp*t <= max from [t0, t1]
+static bool clip_range(float p, float dp, float low, float high, float *t0, float *t1)
+{
+	if (dp == 0) return p >= low && p <= high;
+
+	float tLow = (low - p) / dp, tHigh = (high - p) / dp;
+	if (tLow > tHigh) std::swap(tLow, tHigh);
+	*t0 = max(*t0, tLow);
+	*t1 = min(*t1, tHigh);
+	return *t0 <= *t1;
+}
+
+//clipped to the near/far planes in eye space, then to the image
+static void project_lines_slice(void *context, unsigned long first, unsigned long last)
+{
+	SNAPSHOT_SCENE *scene = (SNAPSHOT_SCENE *)context;
+	for (unsigned long lineIdx = first; lineIdx < last; ++lineIdx)
+	{
+		SCREEN_LINE *line = &scene->lines[lineIdx];
+		const GLfloat *col0 = &scene->lineCol[lineIdx * 2 * COLELEMS];
+		const GLfloat *col1 = col0 + COLELEMS;
+		line->visible = false;
+		if (col0[AOFF] <= 0 && col1[AOFF] <= 0) continue;
+
+		float eye0[3], eye1[3];
+		to_eye(scene, &scene->linePos[lineIdx * 2 * POSELEMS], eye0);
+		to_eye(scene, &scene->linePos[(lineIdx * 2 + 1) * POSELEMS], eye1);
+
+		float t0 = 0, t1 = 1;
+		if (!clip_range(-eye0[2], eye0[2] - eye1[2], SNAPSHOT_NEAR, scene->farClip, &t0, &t1)) continue;
+
+		float clipped0[3], clipped1[3];
+		lerp(eye0, eye1, t0, 3, clipped0);
+		lerp(eye0, eye1, t1, 3, clipped1);
+		lerp(col0, col1, t0, COLELEMS, line->col0);
+		lerp(col0, col1, t1, COLELEMS, line->col1);
+
+		float screen0[2], screen1[2];
+		to_screen(scene, clipped0, &screen0[0], &screen0[1]);
+		to_screen(scene, clipped1, &screen1[0], &screen1[1]);
+
+		float dx = screen1[0] - screen0[0], dy = screen1[1] - screen0[1];
+		t0 = 0, t1 = 1;
+		if (!clip_range(screen0[0], dx, 0, float(scene->width), &t0, &t1)) continue;
+		if (!clip_range(screen0[1], dy, 0, float(scene->height), &t0, &t1)) continue;
+
+		GLfloat lineCol0[COLELEMS], lineCol1[COLELEMS];
+		std::copy(line->col0, line->col0 + COLELEMS, lineCol0);
+		std::copy(line->col1, line->col1 + COLELEMS, lineCol1);
+		lerp(lineCol0, lineCol1, t0, COLELEMS, line->col0);
+		lerp(lineCol0, lineCol1, t1, COLELEMS, line->col1);
+		line->x0 = screen0[0] + dx * t0;
+		line->y0 = screen0[1] + dy * t0;
+		line->x1 = screen0[0] + dx * t1;
+		line->y1 = screen0[1] + dy * t1;
+		line->visible = true;
+	}
+}
+
+static unsigned int band_of(SNAPSHOT_SCENE *scene, float y)
+{
+	int band = int(floor(y)) / SNAPSHOT_BAND_ROWS;
+	return min(max(band, 0), int(scene->bandPoints.size()) - 1);
+}
+
+//bands are filled in draw order so each band blends in the same order opengl would
+static void bin_primitives(SNAPSHOT_SCENE *scene)
+{
+	unsigned int bands = (scene->height + SNAPSHOT_BAND_ROWS - 1) / SNAPSHOT_BAND_ROWS;
+	scene->bandPoints.resize(bands);
+	scene->bandLines.resize(bands);
+
+	float halfPoint = DEFAULTPOINTSIZE / 2.0f;
+	for (unsigned long pointIdx = 0; pointIdx < scene->nodeCount; ++pointIdx)
+	{
+		SCREEN_POINT *point = &scene->points[pointIdx];
+		if (!point->visible) continue;
+		unsigned int lastBand = band_of(scene, point->y + halfPoint);
+		for (unsigned int band = band_of(scene, point->y - halfPoint); band <= lastBand; ++band)
+			scene->bandPoints[band].push_back(pointIdx);
+	}
+
+	for (unsigned long lineIdx = 0; lineIdx < scene->lineCount; ++lineIdx)
+	{
+		SCREEN_LINE *line = &scene->lines[lineIdx];
+		if (!line->visible) continue;
+		unsigned int lastBand = band_of(scene, max(line->y0, line->y1));
+		for (unsigned int band = band_of(scene, min(line->y0, line->y1)); band <= lastBand; ++band)
+			scene->bandLines[band].push_back(lineIdx);
+	}
+}
+
+//GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+static void blend(float *pixel, const GLfloat *col)
+{
+	float alpha = col[AOFF];
+	for (int elem = 0; elem < COLELEMS; ++elem)
+	{
+		float src = (elem == AOFF) ? alpha : col[elem];
+		pixel[elem] = src * alpha + pixel[elem] * (1 - alpha);
+	}
+}
+
+//square points like aliased opengl points
+static void draw_point(float *rows, unsigned int firstRow, unsigned int rowCount, unsigned int width, SCREEN_POINT *point)
+{
+	int left = int(floor(point->x - DEFAULTPOINTSIZE / 2.0f + 0.5f));
+	int top = int(floor(point->y - DEFAULTPOINTSIZE / 2.0f + 0.5f));
+	int rowStart = max(top, int(firstRow)), rowEnd = min(top + DEFAULTPOINTSIZE, int(firstRow + rowCount));
+	int colStart = max(left, 0), colEnd = min(left + DEFAULTPOINTSIZE, int(width));
+	for (int row = rowStart; row < rowEnd; ++row)
+		for (int col = colStart; col < colEnd; ++col)
+			blend(&rows[((row - firstRow) * width + col) * COLELEMS], point->col);
+}
+
+//one pixel per step along the longer axis, colour interpolated along the line
+//only the steps that land in the band are walked
+static void draw_line(float *rows, unsigned int firstRow, unsigned int rowCount, unsigned int width, SCREEN_LINE *line)
+{
+	float dx = line->x1 - line->x0, dy = line->y1 - line->y0;
+	long steps = max(1L, long(ceil(max(fabs(dx), fabs(dy)))));
+
+	long firstStep = 0, lastStep = steps;
+	if (dy != 0)
+	{
+		float tTop = (firstRow - line->y0) / dy, tBottom = (firstRow + rowCount - line->y0) / dy;
+		firstStep = max(0L, long(floor(min(tTop, tBottom) * steps)) - 1);
+		lastStep = min(steps, long(ceil(max(tTop, tBottom) * steps)) + 1);
+	}
+
+	GLfloat col[COLELEMS];
+	for (long step = firstStep; step <= lastStep; ++step)
+	{
+		float t = float(step) / steps;
+		int row = int(floor(line->y0 + dy * t));
+		int column = int(floor(line->x0 + dx * t));
+		if (row < int(firstRow) || row >= int(firstRow + rowCount) || column < 0 || column >= int(width))
+			continue;
+		lerp(line->col0, line->col1, t, COLELEMS, col);
+		blend(&rows[((row - firstRow) * width + column) * COLELEMS], col);
+	}
+}
+
+static void draw_bands_slice(void *context, unsigned long first, unsigned long last)
+{
+	SNAPSHOT_SCENE *scene = (SNAPSHOT_SCENE *)context;
+	unsigned int width = scene->width;
+	vector<float> rows(width * SNAPSHOT_BAND_ROWS * COLELEMS);
+
+	for (unsigned long band = first; band < last; ++band)
+	{
+		unsigned int firstRow = band * SNAPSHOT_BAND_ROWS;
+		unsigned int rowCount = min((unsigned int)SNAPSHOT_BAND_ROWS, scene->height - firstRow);
+
+		//cleared to opaque black like the main display
+		for (unsigned long pixel = 0; pixel < width * rowCount; ++pixel)
+		{
+			float *rgba = &rows[pixel * COLELEMS];
+			rgba[0] = rgba[1] = rgba[2] = 0;
+			rgba[AOFF] = 1;
+		}
+
+		vector<unsigned long>::iterator primIt = scene->bandPoints[band].begin();
+		for (; primIt != scene->bandPoints[band].end(); ++primIt)
+			draw_point(&rows.at(0), firstRow, rowCount, width, &scene->points[*primIt]);
+		for (primIt = scene->bandLines[band].begin(); primIt != scene->bandLines[band].end(); ++primIt)
+			draw_line(&rows.at(0), firstRow, rowCount, width, &scene->lines[*primIt]);
+
+		unsigned char *out = &scene->image->pixels[firstRow * width * COLELEMS];
+		for (unsigned long elem = 0; elem < width * rowCount * COLELEMS; ++elem)
+			out[elem] = (unsigned char)(min(max(rows[elem], 0.0f), 1.0f) * 255 + 0.5f);
+	}
+}
+
+void render_snapshot(thread_graph_data *graph, SNAPSHOT_VIEW *view, int mode, SNAPSHOT_IMAGE *image)
+{
+	image->width = view->width;
+	image->height = view->height;
+	image->pixels.assign(view->width * view->height * COLELEMS, 0);
+
+	SNAPSHOT_SCENE scene;
+	scene.image = image;
+	setup_camera(&scene, view, graph->m_scalefactors->radius);
+
+	//positions always come from the main geometry, colours from the layer of the mode
+	GRAPH_DISPLAY_DATA *nodes = graph->get_mainnodes();
+	GRAPH_DISPLAY_DATA *lines = graph->get_mainlines();
+	nodes->copy_pos(&scene.nodePos);
+	lines->copy_pos(&scene.linePos);
+	unsigned long nodeVerts = nodes->get_numVerts();
+	unsigned long lineVerts = lines->get_numVerts();
+	switch (mode)
+	{
+		case SNAPSHOT_HEATMAP:
+			nodes->copy_col(&scene.nodeCol);
+			graph->heatmaplines->copy_col(&scene.lineCol);
+			lineVerts = min(lineVerts, (unsigned long)graph->heatmaplines->get_numVerts());
+			break;
+		case SNAPSHOT_CONDITIONAL:
+			graph->conditionalnodes->copy_col(&scene.nodeCol);
+			graph->conditionallines->copy_col(&scene.lineCol);
+			nodeVerts = min(nodeVerts, (unsigned long)graph->conditionalnodes->get_numVerts());
+			lineVerts = min(lineVerts, (unsigned long)graph->conditionallines->get_numVerts());
+			break;
+		default:
+			nodes->copy_col(&scene.nodeCol);
+			lines->copy_col(&scene.lineCol);
+	}
+
+	//vertices written since numVerts was read are left out
+	nodeVerts = min(nodeVerts, min(scene.nodePos.size() / POSELEMS, scene.nodeCol.size() / COLELEMS));
+	lineVerts = min(lineVerts, min(scene.linePos.size() / POSELEMS, scene.lineCol.size() / COLELEMS));
+	scene.nodeCount = nodeVerts;
+	scene.lineCount = lineVerts / 2;
+	scene.points.resize(scene.nodeCount);
+	scene.lines.resize(scene.lineCount);
+
+	run_geometry_slices(scene.nodeCount, project_points_slice, &scene);
+	run_geometry_slices(scene.lineCount, project_lines_slice, &scene);
+	bin_primitives(&scene);
+	run_geometry_slices(scene.bandPoints.size(), draw_bands_slice, &scene, 1);
+}
+
+//binary PPM, alpha is dropped
+bool write_ppm(SNAPSHOT_IMAGE *image, string path)
+{
+	ofstream imagefile(path, std::ofstream::binary);
+	if (!imagefile.is_open())
+	{
+		cerr << "[rgat]ERROR: Failed to open " << path << " for writing" << endl;
+		return false;
+	}
+
+	imagefile << "P6\n" << image->width << " " << image->height << "\n255\n";
+	vector<unsigned char> row(image->width * 3);
+	for (unsigned int rowIdx = 0; rowIdx < image->height; ++rowIdx)
+	{
+		const unsigned char *rgba = &image->pixels[rowIdx * image->width * COLELEMS];
+		for (unsigned int column = 0; column < image->width; ++column)
+		{
+			row[column * 3] = rgba[column * COLELEMS];
+			row[column * 3 + 1] = rgba[column * COLELEMS + 1];
+			row[column * 3 + 2] = rgba[column * COLELEMS + 2];
+		}
+		imagefile.write((char *)&row.at(0), row.size());
+	}
+
+	if (!imagefile.good())
+	{
+		cerr << "[rgat]ERROR: Failed writing " << path << endl;
+		return false;
+	}
+	return true;
+}
+
+bool write_png(SNAPSHOT_IMAGE *image, string path)
+{
+	if (!al_init_image_addon())
+	{
+		cerr << "[rgat]ERROR: Failed to initialise the allegro image addon" << endl;
+		return false;
+	}
+
+	al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+	al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+	ALLEGRO_BITMAP *bitmap = al_create_bitmap(image->width, image->height);
+	if (!bitmap)
+	{
+		cerr << "[rgat]ERROR: Failed to create a " << image->width << "x" << image->height << " bitmap" << endl;
+		return false;
+	}
+
+	ALLEGRO_LOCKED_REGION *region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+	unsigned int rowBytes = image->width * COLELEMS;
+	for (unsigned int rowIdx = 0; rowIdx < image->height; ++rowIdx)
+		memcpy((char *)region->data + rowIdx * region->pitch, &image->pixels[rowIdx * rowBytes], rowBytes);
+	al_unlock_bitmap(bitmap);
+
+	bool saved = al_save_bitmap(path.c_str(), bitmap);
+	al_destroy_bitmap(bitmap);
+	if (!saved)
+		cerr << "[rgat]ERROR: Failed writing " << path << endl;
+	return saved;
+}
+
+static string snapshot_mode_name(int mode)
+{
+	switch (mode)
+	{
+		case SNAPSHOT_HEATMAP: return "heat";
+		case SNAPSHOT_CONDITIONAL: return "cond";
+		default: return "static";
+	}
+}
+
+string snapshot_path(string savefile, PID_TID TID, int mode, bool png)
+{
+	string base = savefile;
+	if (base.size() > 5 && base.substr(base.size() - 5) == ".rgat")
+		base.resize(base.size() - 5);
+
+	stringstream imagepath;
+	imagepath << base << "-" << TID << "-" << snapshot_mode_name(mode) << (png ? ".png" : ".ppm");
+	return imagepath.str();
+}
+
+//geometry is built the same way the render threads build it for the display
+bool snapshot_save(VISSTATE *clientState, string savefile, SNAPSHOT_VIEW *view)
+{
+	ifstream loadfile;
+	loadfile.open(savefile, std::ifstream::binary);
+	if (!loadfile.is_open())
+	{
+		cerr << "[rgat]ERROR: Failed to open " << savefile << endl;
+		return false;
+	}
+
+	string s1, PID_s;
+	int PID;
+	loadfile >> s1;
+	if (s1 != "PID") {
+		cerr << "[rgat]ERROR: Corrupt save, start = " << s1 << endl;
+		return false;
+	}
+	loadfile >> PID_s;
+	if (!caught_stoi(PID_s, &PID, 10)) return false;
+	loadfile.seekg(1, ios::cur);
+
+	PROCESS_DATA piddata;
+	piddata.PID = PID;
+	if (!loadProcessData(clientState, &loadfile, &piddata, dirname(savefile)))
+	{
+		cerr << "[rgat]ERROR: Process data load failed" << endl;
+		return false;
+	}
+	if (!loadProcessGraphs(clientState, &loadfile, &piddata))
+	{
+		cerr << "[rgat]ERROR: Process graph load failed" << endl;
+		return false;
+	}
+	loadfile.close();
+
+	heatmap_renderer heatRenderer(PID, 0);
+	heatRenderer.clientState = clientState;
+	heatRenderer.piddata = &piddata;
+	conditional_renderer condRenderer(PID, 0);
+	condRenderer.clientState = clientState;
+	condRenderer.piddata = &piddata;
+
+	int firstMode = view->mode, lastMode = view->mode;
+	if (view->mode == SNAPSHOT_ALL)
+	{
+		firstMode = SNAPSHOT_STATIC;
+		lastMode = SNAPSHOT_CONDITIONAL;
+	}
+
+	unsigned int imagesWritten = 0;
+	map<PID_TID, void *>::iterator graphIt = piddata.graphs.begin();
+	for (; graphIt != piddata.graphs.end(); ++graphIt)
+	{
+		thread_graph_data *graph = (thread_graph_data *)graphIt->second;
+		render_static_graph(graph, clientState);
+		if (!graph->get_mainnodes()->get_numVerts())
+		{
+			cerr << "[rgat]WARNING: Thread " << graph->tid << " has no nodes, no image written" << endl;
+			continue;
+		}
+
+		for (int mode = firstMode; mode <= lastMode; ++mode)
+		{
+			if (mode == SNAPSHOT_HEATMAP && !heatRenderer.render_once(graph))
+			{
+				cerr << "[rgat]WARNING: Thread " << graph->tid << " heatmap failed, no image written" << endl;
+				continue;
+			}
+			if (mode == SNAPSHOT_CONDITIONAL)
+				condRenderer.render_once(graph);
+
+			SNAPSHOT_IMAGE image;
+			render_snapshot(graph, view, mode, &image);
+			string imagepath = snapshot_path(savefile, graph->tid, mode, view->png);
+			if (!(view->png ? write_png(&image, imagepath) : write_ppm(&image, imagepath))) return false;
+			cout << "[rgat]Wrote " << imagepath << endl;
+			++imagesWritten;
+		}
+	}
+
+	cout << "[rgat]Wrote " << imagesWritten << " graph images from " << savefile << endl;
+	return imagesWritten > 0;
+}
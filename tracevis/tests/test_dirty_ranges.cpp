@@ -0,0 +1,257 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Partial buffer uploads, checked against a stand in for an opengl buffer
+*/
+#include "tests.h"
+#include "dirty_ranges.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+//what glBufferData and glBufferSubData do to a buffer's contents
+struct MOCK_GL_BUFFER {
+	vector<unsigned char> contents;
+	unsigned long resizes = 0;
+	unsigned long bytesSent = 0;
+	bool outOfBounds = false;
+
+	//the old contents are lost, junk is left in their place
+	void bufferData(unsigned long bytes)
+	{
+		contents.assign(bytes, 0xCD);
+		++resizes;
+	}
+
+	void bufferSubData(unsigned long offset, unsigned long bytes, const unsigned char *data)
+	{
+		if (offset + bytes > contents.size())
+		{
+			outOfBounds = true;
+			return;
+		}
+		memcpy(&contents.at(offset), data, bytes);
+		bytesSent += bytes;
+	}
+};
+
+//same steps as load_VBO_chunks
+static void upload(upload_tracker *tracker, unsigned int bufferID, MOCK_GL_BUFFER *buffer, vector<unsigned char> *data)
+{
+	vector<BYTE_RANGE> ranges;
+	unsigned long bufferBytes;
+	if (tracker->take(bufferID, data->size(), &ranges, &bufferBytes))
+		buffer->bufferData(bufferBytes);
+
+	vector<BYTE_RANGE>::iterator rangeIt = ranges.begin();
+	for (; rangeIt != ranges.end(); ++rangeIt)
+		buffer->bufferSubData(rangeIt->first, rangeIt->second - rangeIt->first, &data->at(rangeIt->first));
+}
+
+static bool buffer_matches(MOCK_GL_BUFFER *buffer, vector<unsigned char> *data)
+{
+	if (buffer->outOfBounds || buffer->contents.size() < data->size()) return false;
+	return std::equal(data->begin(), data->end(), buffer->contents.begin());
+}
+
+static void write_bytes(vector<unsigned char> *data, upload_tracker *tracker, unsigned long start, unsigned long end)
+{
+	for (unsigned long i = start; i < end; ++i)
+		data->at(i) = (unsigned char)rand();
+	tracker->mark(start, end);
+}
+
+static void append_bytes(vector<unsigned char> *data, upload_tracker *tracker, unsigned long count)
+{
+	unsigned long start = data->size();
+	data->resize(start + count);
+	write_bytes(data, tracker, start, start + count);
+}
+
+//ranges that overlap or touch become one
+static void range_merging()
+{
+	dirty_ranges dirty;
+	dirty.mark(0, 10);
+	dirty.mark(20, 30);
+	CHECK(dirty.range_count() == 2);
+	dirty.mark(10, 20);
+	CHECK(dirty.range_count() == 1);
+	dirty.mark(5, 8);
+	dirty.mark(25, 40);
+	dirty.mark(50, 60);
+	dirty.mark(45, 46);
+	CHECK(dirty.range_count() == 3);
+	dirty.mark(35, 55);
+	dirty.mark(70, 70);
+	CHECK(dirty.range_count() == 1);
+
+	vector<BYTE_RANGE> ranges;
+	dirty.take(ULONG_MAX, &ranges);
+	CHECK(ranges.size() == 1);
+	CHECK(ranges.size() == 1 && ranges[0] == make_pair(0UL, 60UL));
+	CHECK(dirty.empty());
+}
+
+//bytes past the buffer's end are kept for the upload after it grows
+static void take_limit()
+{
+	dirty_ranges dirty;
+	dirty.mark(0, 10);
+	dirty.mark(30, 100);
+
+	vector<BYTE_RANGE> ranges;
+	dirty.take(50, &ranges);
+	CHECK(ranges.size() == 2);
+	CHECK(ranges.size() == 2 && ranges[1] == make_pair(30UL, 50UL));
+	CHECK(dirty.range_count() == 1);
+
+	dirty.take(ULONG_MAX, &ranges);
+	CHECK(ranges.size() == 1 && ranges[0] == make_pair(50UL, 100UL));
+}
+
+//one range past the limit merges the two with the smallest gap between them
+static void range_collapse()
+{
+	dirty_ranges dirty;
+	for (unsigned long rangeIdx = 0; rangeIdx < DIRTY_MAX_RANGES; ++rangeIdx)
+		dirty.mark(rangeIdx * 100, rangeIdx * 100 + 10);
+	CHECK(dirty.range_count() == DIRTY_MAX_RANGES);
+
+	//3 bytes after the range at 1000, everything else is 90 apart
+	dirty.mark(1013, 1020);
+	CHECK(dirty.range_count() == DIRTY_MAX_RANGES);
+
+	vector<BYTE_RANGE> ranges;
+	dirty.take(ULONG_MAX, &ranges);
+	CHECK(ranges.size() == DIRTY_MAX_RANGES);
+	bool foundMerged = false;
+	for (unsigned long rangeIdx = 0; rangeIdx < ranges.size(); ++rangeIdx)
+		if (ranges[rangeIdx] == make_pair(1000UL, 1020UL))
+			foundMerged = true;
+	CHECK(foundMerged);
+
+	//lots of scattered writes never go past the limit and still cover every byte
+	upload_tracker tracker;
+	MOCK_GL_BUFFER buffer;
+	vector<unsigned char> data;
+	append_bytes(&data, &tracker, 100000);
+	upload(&tracker, 1, &buffer, &data);
+	for (unsigned int i = 0; i < 1000; ++i)
+	{
+		unsigned long start = rand() % (data.size() - 8);
+		write_bytes(&data, &tracker, start, start + 1 + rand() % 8);
+	}
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 1);
+	CHECK(buffer_matches(&buffer, &data));
+}
+
+//a buffer too small for the data is given a new size then sent everything
+static void growth()
+{
+	upload_tracker tracker;
+	MOCK_GL_BUFFER buffer;
+	vector<unsigned char> data;
+
+	//new buffers are sized on their first upload
+	append_bytes(&data, &tracker, 1000);
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 1);
+	CHECK(buffer.contents.size() == 1000);
+	CHECK(buffer_matches(&buffer, &data));
+
+	//a small change only sends itself
+	buffer.bytesSent = 0;
+	write_bytes(&data, &tracker, 500, 510);
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 1);
+	CHECK(buffer.bytesSent == 10);
+	CHECK(buffer_matches(&buffer, &data));
+
+	//appending past the end doubles the buffer and sends all of it again
+	buffer.bytesSent = 0;
+	append_bytes(&data, &tracker, 10);
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 2);
+	CHECK(buffer.contents.size() == 2000);
+	CHECK(buffer.bytesSent == 1010);
+	CHECK(buffer_matches(&buffer, &data));
+
+	//appends that fit only send the new bytes
+	buffer.bytesSent = 0;
+	append_bytes(&data, &tracker, 90);
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 2);
+	CHECK(buffer.bytesSent == 90);
+	CHECK(buffer_matches(&buffer, &data));
+
+	//appending past double the size grows to fit
+	append_bytes(&data, &tracker, 5000);
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 3);
+	CHECK(buffer.contents.size() == data.size());
+	CHECK(buffer_matches(&buffer, &data));
+
+	//rewritten data is sent in full
+	tracker.mark_all();
+	buffer.bytesSent = 0;
+	upload(&tracker, 1, &buffer, &data);
+	CHECK(buffer.resizes == 4);
+	CHECK(buffer.bytesSent == data.size());
+	CHECK(buffer_matches(&buffer, &data));
+}
+
+//two buffers filled from the same data, uploaded at different times
+static void separate_buffers()
+{
+	upload_tracker tracker;
+	MOCK_GL_BUFFER first, second;
+	vector<unsigned char> data;
+
+	append_bytes(&data, &tracker, 4000);
+	upload(&tracker, 1, &first, &data);
+	for (unsigned int round = 0; round < 50; ++round)
+	{
+		unsigned long start = rand() % data.size();
+		write_bytes(&data, &tracker, start, min((unsigned long)data.size(), start + rand() % 200));
+		if (round % 7 == 0)
+			append_bytes(&data, &tracker, rand() % 3000);
+
+		upload(&tracker, 1, &first, &data);
+		CHECK(buffer_matches(&first, &data));
+		if (round % 5 == 0)
+		{
+			upload(&tracker, 2, &second, &data);
+			CHECK(buffer_matches(&second, &data));
+		}
+	}
+	upload(&tracker, 2, &second, &data);
+	CHECK(buffer_matches(&second, &data));
+}
+
+unsigned int dirty_ranges_tests()
+{
+	unsigned int failuresBefore = checkFailures;
+	srand(1);
+	range_merging();
+	take_limit();
+	range_collapse();
+	growth();
+	separate_buffers();
+	return checkFailures - failuresBefore;
+}
@@ -0,0 +1,169 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Heatmap edge solver on small graphs with known edge executions
+Threads start at node 0
+*/
+#include "tests.h"
+#include "heat_solver.h"
+#include <climits>
+
+static unsigned long edge_weight(heat_solver *solver, unsigned int source, unsigned int target)
+{
+	vector<HEAT_EDGE>::iterator edgeIt = solver->edges.begin();
+	for (; edgeIt != solver->edges.end(); ++edgeIt)
+		if (edgeIt->source == source && edgeIt->target == target)
+			return edgeIt->weight;
+	return ULONG_MAX;
+}
+
+static bool all_solved(heat_solver *solver)
+{
+	return solver->solvedEdges == solver->edges.size();
+}
+
+//0 -> 1 -> 2 -> 3 with no branches
+static void chain()
+{
+	unsigned long heat[] = { 1, 1, 1, 1 };
+	vector<unsigned long> nodeHeat(heat, heat + 4);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.add_edge(1, 2);
+	solver.add_edge(2, 3);
+	solver.solve(0, 3);
+
+	CHECK(all_solved(&solver));
+	CHECK(solver.residuals.empty());
+	CHECK(edge_weight(&solver, 0, 1) == 1);
+	CHECK(edge_weight(&solver, 2, 3) == 1);
+}
+
+//0 branches to 1 or 2, both rejoin at 3. 2 was never taken
+static void diamond()
+{
+	unsigned long heat[] = { 1, 1, 0, 1 };
+	vector<unsigned long> nodeHeat(heat, heat + 4);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.add_edge(0, 2);
+	solver.add_edge(1, 3);
+	solver.add_edge(2, 3);
+	solver.solve(0, 3);
+
+	CHECK(all_solved(&solver));
+	CHECK(solver.residuals.empty());
+	CHECK(edge_weight(&solver, 0, 1) == 1);
+	CHECK(edge_weight(&solver, 0, 2) == 0);
+	CHECK(edge_weight(&solver, 1, 3) == 1);
+	CHECK(edge_weight(&solver, 2, 3) == 0);
+}
+
+//the thread starts in a loop: 0 -> 1 -> 0 three times round then 1 -> 2
+//node 0 ran 3 times but was only entered by the back edge twice
+static void loop_at_entry()
+{
+	unsigned long heat[] = { 3, 3, 1 };
+	vector<unsigned long> nodeHeat(heat, heat + 3);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.add_edge(1, 0);
+	solver.add_edge(1, 2);
+	solver.solve(0, 2);
+
+	CHECK(all_solved(&solver));
+	CHECK(solver.residuals.empty());
+	CHECK(edge_weight(&solver, 0, 1) == 3);
+	CHECK(edge_weight(&solver, 1, 0) == 2);
+	CHECK(edge_weight(&solver, 1, 2) == 1);
+}
+
+//a diamond inside a loop: 0 -> 1, 1 -> 2|3 -> 4, 4 -> 1 back, 4 -> 5 out
+//three times round, taking 2 twice and 3 once
+static void looped_diamond()
+{
+	unsigned long heat[] = { 1, 3, 2, 1, 3, 1 };
+	vector<unsigned long> nodeHeat(heat, heat + 6);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.add_edge(1, 2);
+	solver.add_edge(1, 3);
+	solver.add_edge(2, 4);
+	solver.add_edge(3, 4);
+	solver.add_edge(4, 1);
+	solver.add_edge(4, 5);
+	solver.solve(0, 5);
+
+	CHECK(all_solved(&solver));
+	CHECK(solver.residuals.empty());
+	CHECK(edge_weight(&solver, 0, 1) == 1);
+	CHECK(edge_weight(&solver, 1, 2) == 2);
+	CHECK(edge_weight(&solver, 1, 3) == 1);
+	CHECK(edge_weight(&solver, 2, 4) == 2);
+	CHECK(edge_weight(&solver, 3, 4) == 1);
+	CHECK(edge_weight(&solver, 4, 1) == 2);
+	CHECK(edge_weight(&solver, 4, 5) == 1);
+}
+
+//two loops sharing a head, only solvable with the back edge counts the trace handler kept
+static void counted_back_edges()
+{
+	unsigned long heat[] = { 6, 3, 2, 1 };
+	vector<unsigned long> nodeHeat(heat, heat + 4);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.add_edge(0, 2);
+	solver.add_counted_edge(1, 0, 3);
+	solver.add_counted_edge(2, 0, 2);
+	solver.add_edge(0, 3);
+	solver.solve(0, 3);
+
+	CHECK(solver.residuals.empty());
+	CHECK(edge_weight(&solver, 0, 1) == 3);
+	CHECK(edge_weight(&solver, 0, 2) == 2);
+	CHECK(edge_weight(&solver, 0, 3) == 1);
+}
+
+//counts that can't be right are reported rather than hidden
+//which end of the edge gets the blame depends on which was solved first
+static void bad_counts()
+{
+	unsigned long heat[] = { 1, 2 };
+	vector<unsigned long> nodeHeat(heat, heat + 2);
+	heat_solver solver(&nodeHeat);
+	solver.add_edge(0, 1);
+	solver.solve(0, 1);
+
+	CHECK(solver.residuals.size() == 1);
+	if (solver.residuals.size() == 1)
+	{
+		HEAT_RESIDUAL *residual = &solver.residuals[0];
+		CHECK(llabs(residual->inResidual) + llabs(residual->outResidual) == 1);
+	}
+}
+
+unsigned int heat_solver_tests()
+{
+	unsigned int failuresBefore = checkFailures;
+	chain();
+	diamond();
+	loop_at_entry();
+	looped_diamond();
+	counted_back_edges();
+	bad_counts();
+	return checkFailures - failuresBefore;
+}
@@ -0,0 +1,100 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Block nodes keeping track of the instruction they are drawn for
+*/
+#include "tests.h"
+#include "node_data.h"
+
+//mov, mov (faults), cmp, jz
+static void make_block(INS_DATA *instructions, INSLIST *block)
+{
+	for (unsigned int insIdx = 0; insIdx < 4; ++insIdx)
+	{
+		instructions[insIdx].address = 0x1000 + insIdx * 4;
+		instructions[insIdx].numbytes = 4;
+		instructions[insIdx].itype = OPUNDEF;
+		instructions[insIdx].conditional = false;
+		block->push_back(&instructions[insIdx]);
+	}
+	instructions[3].itype = OPJMP;
+	instructions[3].conditional = true;
+	instructions[3].condTakenAddress = 0x2000;
+	instructions[3].condDropAddress = 0x1010;
+}
+
+//first run faults at the second instruction, a later run gets to the end
+static void faulted_then_full()
+{
+	INS_DATA instructions[4];
+	INSLIST block;
+	make_block(instructions, &block);
+
+	//as handle_new_instruction creates it
+	node_data n;
+	n.ins = block.at(1);
+	n.address = n.ins->address;
+	n.conditional = n.ins->conditional;
+	n.blockAddress = 0x1000;
+
+	CHECK(n.extend_block(&block, 2));
+	CHECK(n.blockInsCount == 2);
+	CHECK(n.ins == &instructions[1]);
+	CHECK(!n.conditional);
+
+	CHECK(n.extend_block(&block, 4));
+	CHECK(n.blockInsCount == 4);
+	CHECK(n.ins == &instructions[3]);
+	CHECK(n.address == 0x100c);
+	CHECK(n.conditional);
+	CHECK(n.ins->itype == OPJMP);
+	CHECK(n.blockAddress == 0x1000);
+
+	//later runs cut short don't move it back
+	n.conditional |= CONDTAKEN;
+	CHECK(!n.extend_block(&block, 2));
+	CHECK(!n.extend_block(&block, 4));
+	CHECK(n.ins == &instructions[3]);
+	CHECK(n.blockInsCount == 4);
+	CHECK(n.conditional == (ISCONDITIONAL | CONDTAKEN));
+}
+
+//the usual case, the first run is the whole block
+static void full_first()
+{
+	INS_DATA instructions[4];
+	INSLIST block;
+	make_block(instructions, &block);
+
+	node_data n;
+	n.ins = block.at(3);
+	n.address = n.ins->address;
+	n.conditional = n.ins->conditional;
+
+	CHECK(n.extend_block(&block, 4));
+	CHECK(n.ins == &instructions[3]);
+	CHECK(n.conditional);
+	CHECK(!n.extend_block(&block, 4));
+}
+
+unsigned int node_data_tests()
+{
+	unsigned int failuresBefore = checkFailures;
+	faulted_then_full();
+	full_first();
+	return checkFailures - failuresBefore;
+}
@@ -0,0 +1,141 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Seeking a replay has to leave it where stepping forward would
+*/
+#include "tests.h"
+#include "replay_index.h"
+
+//each block ends at a node of its own, blocks repeat so nodes build up counts
+class test_nodes : public replay_nodes
+{
+public:
+	unsigned int get_last_node(unsigned long sequenceId) { return nodes.at(sequenceId); }
+	vector<unsigned int> nodes;
+};
+
+static void add_block(execution_sequence *sequence, block_table *blocks, test_nodes *nodes, unsigned int blockNum, bool looped)
+{
+	BLOCK_HANDLE handle = blocks->get_handle(0x1000 + blockNum * 0x10, blockNum, blockNum % 5 + 1);
+	if (looped)
+		sequence->add_loop_block(handle);
+	else
+		sequence->add_block(handle);
+	nodes->nodes.push_back(blockNum);
+}
+
+//plain blocks with loops of a few blocks between them, one at the very start
+//long enough to cover several checkpoints and a keyframe
+static void build_sequence(execution_sequence *sequence, block_table *blocks, test_nodes *nodes, replay_index *index)
+{
+	unsigned long loopNum = 0;
+	while (sequence->size() < REPLAY_CHECKPOINT_INTERVAL * (REPLAY_KEYFRAME_INTERVAL + 3))
+	{
+		unsigned int loopBlocks = loopNum % 4 + 1;
+		sequence->start_loop(loopNum % 3 + 2);
+		for (unsigned int blockIdx = 0; blockIdx < loopBlocks; ++blockIdx)
+			add_block(sequence, blocks, nodes, 7 + blockIdx, true);
+		++loopNum;
+
+		for (unsigned int blockIdx = 0; blockIdx < loopNum % 7; ++blockIdx)
+			add_block(sequence, blocks, nodes, blockIdx, false);
+	}
+	add_block(sequence, blocks, nodes, 0, false);
+
+	//as thread_graph_data::index_replay does
+	for (unsigned long seqIdx = 0; seqIdx < sequence->size(); ++seqIdx)
+	{
+		pair<unsigned int, unsigned long> loopState = sequence->loop_state(seqIdx);
+		index->add_entry(sequence->block(seqIdx).insCount, loopState.first,
+			loopState.first ? loopState.second : 1, nodes->get_last_node(seqIdx));
+	}
+}
+
+static void seek_matches_stepping()
+{
+	block_table blocks;
+	execution_sequence sequence(&blocks);
+	test_nodes nodes;
+	replay_index index;
+	build_sequence(&sequence, &blocks, &nodes, &index);
+
+	//brighten_externs counts each block the cursor reports
+	replay_cursor stepped;
+	map<unsigned int, unsigned long> steppedCounts;
+	unsigned long executed;
+	unsigned long comparisons = 0;
+	unsigned int failuresBefore = checkFailures;
+	while (stepped.advance(&sequence, &executed))
+	{
+		++steppedCounts[nodes.get_last_node(executed)];
+		//seeks land outside loops or at the start of one
+		if (stepped.looping) continue;
+
+		replay_cursor seeked;
+		CHECK(seeked.seek(&sequence, &index, &nodes, stepped.sequenceIndex));
+		CHECK(seeked.sequenceIndex == stepped.sequenceIndex);
+		CHECK(seeked.animInstructionIndex == stepped.animInstructionIndex);
+		CHECK(seeked.loopsPlayed == stepped.loopsPlayed);
+		CHECK(seeked.callCounter == steppedCounts);
+		++comparisons;
+		if (checkFailures != failuresBefore) return;
+	}
+
+	CHECK(stepped.sequenceIndex == sequence.size() - 1);
+	CHECK(sequence.size() > REPLAY_CHECKPOINT_INTERVAL * REPLAY_KEYFRAME_INTERVAL);
+	CHECK(comparisons > sequence.size() / 4);
+
+	//inside a loop goes back to its start. entries 2 and 3 are the second loop
+	replay_cursor seeked;
+	CHECK(seeked.seek(&sequence, &index, &nodes, 3));
+	CHECK(seeked.sequenceIndex == 2);
+	CHECK(seeked.loopsPlayed == 1);
+	CHECK(seeked.callCounter[7] == 2);
+	CHECK(seeked.callCounter[0] == 1);
+	CHECK(!seeked.seek(&sequence, &index, &nodes, sequence.size()));
+}
+
+//a thread starting in a loop still plays every iteration
+static void loop_at_start()
+{
+	block_table blocks;
+	execution_sequence sequence(&blocks);
+	test_nodes nodes;
+	sequence.start_loop(3);
+	add_block(&sequence, &blocks, &nodes, 1, true);
+	add_block(&sequence, &blocks, &nodes, 2, true);
+	add_block(&sequence, &blocks, &nodes, 3, false);
+
+	replay_cursor stepped;
+	unsigned long executed;
+	unsigned int steps = 0;
+	while (stepped.advance(&sequence, &executed))
+		++steps;
+	CHECK(steps == 6);
+	CHECK(stepped.sequenceIndex == 2);
+	CHECK(stepped.loopsPlayed == 1);
+	CHECK(stepped.animInstructionIndex == 3 * (2 + 3));
+	CHECK(!stepped.looping);
+}
+
+unsigned int replay_index_tests()
+{
+	unsigned int failuresBefore = checkFailures;
+	seek_matches_stepping();
+	loop_at_start();
+	return checkFailures - failuresBefore;
+}
@@ -0,0 +1,33 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Checks for the parts of rgat that don't need a target or a display
+Each group returns how many of its checks failed
+*/
+#pragma once
+#include "stdafx.h"
+
+extern unsigned int checkFailures;
+
+#define CHECK(cond) if (!(cond)) { \
+	cerr << "[rgat]TEST FAILED: " << __FILE__ << ":" << __LINE__ << " " << #cond << endl; \
+	++checkFailures; }
+
+unsigned int heat_solver_tests();
+unsigned int dirty_ranges_tests();
+unsigned int node_data_tests();
+unsigned int replay_index_tests();
@@ -0,0 +1,42 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Runs each group of checks, exits non-zero if any failed
+*/
+#include "tests.h"
+
+unsigned int checkFailures = 0;
+
+static unsigned int run_group(const char *name, unsigned int(*group)())
+{
+	unsigned int failures = group();
+	cout << "[rgat]" << name << ": " << (failures ? "FAILED" : "passed") << endl;
+	return failures;
+}
+
+int main()
+{
+	unsigned int failures = 0;
+	failures += run_group("heat_solver", heat_solver_tests);
+	failures += run_group("dirty_ranges", dirty_ranges_tests);
+	failures += run_group("node_data", node_data_tests);
+	failures += run_group("replay_index", replay_index_tests);
+
+	if (failures)
+		cerr << "[rgat]" << failures << " checks failed" << endl;
+	return failures ? 1 : 0;
+}
@@ -23,6 +23,7 @@ Monsterous class that handles the bulk of graph management
 #include "thread_trace_reader.h"
 #include "rendering.h"
 #include "serialise.h"
+#include <climits>
 
 
 bool thread_graph_data::isGraphBusy() 
@@ -49,6 +50,8 @@ void thread_graph_data::insert_edge_between_BBs(INSLIST *source, INSLIST *target
 	node_data *targNode = get_node(targNodeIdx);
 
 	edge_data newEdge;
+	//the trace doesn't say how often this was followed
+	newEdge.countUncertain = true;
 	
 	if (targNode->external)
 		newEdge.edgeClass = ILIB;
@@ -169,18 +172,10 @@ void thread_graph_data::display_active(bool showNodes, bool showEdges)
 	if (needVBOReload_active && !isGraphBusy())
 	{
 		setGraphBusy(true);
-		load_VBO(VBO_NODE_POS, activeVBOs, mainnodesdata->pos_size(), mainnodesdata->readonly_pos());
-		load_VBO(VBO_NODE_COL, activeVBOs, animnodesdata->col_size(), animnodesdata->readonly_col());
-
-		GLfloat *buf = mainlinedata->readonly_pos();
-		if (!buf) { setGraphBusy(false); return; }
-		int posbufsize = mainlinedata->get_numVerts() * POSELEMS * sizeof(GLfloat);
-		load_VBO(VBO_LINE_POS, activeVBOs, posbufsize, buf);
-
-		buf = animlinedata->readonly_col();
-		if (!buf) { setGraphBusy(false); return; }
-		int linebufsize = animlinedata->get_numVerts() * COLELEMS * sizeof(GLfloat);
-		load_VBO(VBO_LINE_COL, activeVBOs, linebufsize, buf);
+		load_VBO_pos(VBO_NODE_POS, activeVBOs, mainnodesdata, mainnodesdata->get_numVerts());
+		load_VBO_col(VBO_NODE_COL, activeVBOs, animnodesdata, animnodesdata->get_numVerts());
+		load_VBO_pos(VBO_LINE_POS, activeVBOs, mainlinedata, mainlinedata->get_numVerts());
+		load_VBO_col(VBO_LINE_COL, activeVBOs, animlinedata, animlinedata->get_numVerts());
 
 		needVBOReload_active = false;
 		setGraphBusy(false);
@@ -211,87 +206,117 @@ void thread_graph_data::display_static(bool showNodes, bool showEdges)
 		array_render_lines(VBO_LINE_POS, VBO_LINE_COL, graphVBOs, mainlinedata->get_numVerts());
 }
 
+void thread_graph_data::display_lod(bool showNodes, bool showEdges)
+{
+	GRAPH_DISPLAY_DATA *nodesdata = lod->get_nodes();
+	GRAPH_DISPLAY_DATA *linedata = lod->get_lines();
+	if (needVBOReload_lod && !isGraphBusy())
+	{
+		setGraphBusy(true);
+		loadVBOs(lodVBOs, nodesdata, linedata);
+		needVBOReload_lod = false;
+		setGraphBusy(false);
+	}
+
+	if (showNodes)
+		array_render_points(VBO_NODE_POS, VBO_NODE_COL, lodVBOs, nodesdata->get_numVerts());
+
+	if (showEdges)
+		array_render_lines(VBO_LINE_POS, VBO_LINE_COL, lodVBOs, linedata->get_numVerts());
+}
+
+void thread_graph_data::update_lod()
+{
+	getEdgeReadLock();
+	unsigned long drawnEdges = min((unsigned long)mainlinedata->get_renderedEdges(), (unsigned long)edgeList.size());
+	for (unsigned long edgeIdx = lod->edge_count(); edgeIdx < drawnEdges; ++edgeIdx)
+	{
+		NODEPAIR ePair = edgeList.at(edgeIdx);
+		lod->add_edge(&edgeDict.at(ePair), get_node(ePair.first), get_node(ePair.second));
+	}
+	dropEdgeReadLock();
+}
+
 //create faded edge version of graph for use in animations
 void thread_graph_data::extend_faded_edges()
 {
 
-	vector<GLfloat> *animecol = animlinedata->acquire_col();
-	vector<GLfloat> *mainecol = mainlinedata->acquire_col();
+	animlinedata->acquire_col();
 	unsigned int drawnVerts = mainlinedata->get_numVerts();
-	unsigned int animatedVerts = animlinedata->get_numVerts();
+	unsigned int animatedVerts = animlinedata->col_count();
 
 	assert(drawnVerts >= animatedVerts);
-	int pendingVerts = drawnVerts - animatedVerts;
-	if (!pendingVerts) return;
+	if (drawnVerts == animatedVerts) 
+	{
+		animlinedata->release_col();
+		return;
+	}
 
-	//copy the colours over
-	unsigned int fadedIndex = animlinedata->get_numVerts() *COLELEMS;
-	vector<float>::iterator mainEIt= mainecol->begin();
-	advance(mainEIt, fadedIndex);
-	animecol->insert(animecol->end(), mainEIt, mainecol->end());
-	mainlinedata->release_col();
+	//copy the colours over a chunk at a time, main colours below drawnVerts don't move
+	unsigned long vertIdx = animatedVerts, runVerts;
+	while (vertIdx < drawnVerts)
+	{
+		GLfloat *mainRun = mainlinedata->col_run(vertIdx, &runVerts);
+		runVerts = min(runVerts, drawnVerts - vertIdx);
+		animlinedata->append_col(mainRun, runVerts);
+		vertIdx += runVerts;
+	}
 
 	//fade new colours alpha
-	unsigned int index2 = (animlinedata->get_numVerts() *COLELEMS);
-	unsigned int end = drawnVerts*COLELEMS;
-	for (; index2 < end; index2 += COLELEMS)
-		animecol->at(index2 + AOFF) = 0.01; //TODO: config file entry for anim inactive
+	for (vertIdx = animatedVerts; vertIdx < drawnVerts; ++vertIdx)
+		animlinedata->col_at(vertIdx)[AOFF] = ANIM_INACTIVE_EDGE_ALPHA; //TODO: config file entry for anim inactive
 
 	animlinedata->set_numVerts(drawnVerts);
 	animlinedata->release_col();
 }
 
 //create edges in opengl buffers
+//edge lock is only held while the new edges are copied, they are drawn as one batch
 void thread_graph_data::render_new_edges(bool doResize, map<int, ALLEGRO_COLOR> *lineColoursArr)
 {
-	GRAPH_DISPLAY_DATA *lines = get_mainlines();
-	EDGELIST::iterator edgeIt;
-
-	getEdgeReadLock();
 	if (doResize)
 	{
+		getEdgeReadLock();
 		reset_mainlines();
-		lines = get_mainlines();
-		edgeIt = edgeList.begin();
-	}
-	else
-	{
-		edgeIt = edgeList.begin();
-		std::advance(edgeIt, lines->get_renderedEdges());
+		dropEdgeReadLock();
 	}
 
-	if (edgeIt != edgeList.end())
-		needVBOReload_main = true;
+	GRAPH_DISPLAY_DATA *lines = get_mainlines();
+	vector<pair<NODEPAIR, edge_data *>> newEdges;
+	if (!copy_edge_range(lines->get_renderedEdges(), ULONG_MAX, &newEdges))
+		return;
 
-	for (; edgeIt != edgeList.end(); ++edgeIt)
-	{
-		render_edge(*edgeIt, lines, lineColoursArr);
-		extend_faded_edges();
-		lines->inc_edgesRendered();
-	}
-	dropEdgeReadLock();
+	needVBOReload_main = true;
+	draw_edge_batch(this, &newEdges, lines, lineColoursArr, false);
+	extend_faded_edges();
 }
 
 //given a sequence id, get the last instruction in the block it refers to
 INS_DATA* thread_graph_data::get_last_instruction(unsigned long sequenceId)
 {
-	obtainMutex(animationListsMutex, 1016);
-	pair<MEM_ADDRESS, int> targBlock_Size = bbsequence.at(sequenceId);
-	BLOCK_IDENTIFIER blockID = mutationSequence.at(sequenceId);
-	dropMutex(animationListsMutex);
+	const SEQUENCE_BLOCK &block = blockSequence->block(sequenceId);
+	return getDisassemblyBlock(block.address, block.blockID, piddata, &terminationFlag)->at(block.insCount - 1);
+}
 
-	MEM_ADDRESS insAddr = targBlock_Size.first;
-	int instructionIndex = targBlock_Size.second-1;
-	
-	return getDisassemblyBlock(insAddr, blockID, piddata, &terminationFlag)->at(instructionIndex);
+//given a sequence id, get the node its block ends on
+//block nodes are looked up by block, instructions shared with overlapping blocks may map elsewhere
+unsigned int thread_graph_data::get_last_node(unsigned long sequenceId)
+{
+	if (blockNodes)
+	{
+		const SEQUENCE_BLOCK &block = blockSequence->block(sequenceId);
+		unsigned int nodeIdx = 0;
+		find_block_node(block.address, block.blockID, &nodeIdx);
+		return nodeIdx;
+	}
+	return get_last_instruction(sequenceId)->threadvertIdx.at(tid);
 }
 
 //externs not included in sequence data, have to check if each block called one
 void thread_graph_data::brighten_externs(unsigned long targetSequence, bool updateArgs)
 {
 	//check if block called an extern
-	INS_DATA* ins = get_last_instruction(targetSequence);
-	int nodeIdx = ins->threadvertIdx.at(tid);
+	int nodeIdx = get_last_node(targetSequence);
 
 	obtainMutex(animationListsMutex, 1017);
 	map <unsigned int, EDGELIST>::iterator externit = externCallSequence.find(nodeIdx);
@@ -303,9 +328,9 @@ void thread_graph_data::brighten_externs(unsigned long targetSequence, bool upda
 
 	EDGELIST callList = externit->second;
 
-	unsigned int callsSoFar = callCounter[nodeIdx];
+	unsigned int callsSoFar = replay.callCounter[nodeIdx];
 	if(updateArgs) 
-		callCounter[nodeIdx] = callsSoFar + 1;
+		replay.callCounter[nodeIdx] = callsSoFar + 1;
 	int targetExternIdx;
 	
 	if (callsSoFar < callList.size()) 
@@ -330,12 +355,10 @@ void thread_graph_data::brighten_externs(unsigned long targetSequence, bool upda
 	ex.drawFloating = updateArgs;
 
 	set_node_alpha(ex.nodeIdx, animnodesdata, 1);
-	if (!activeNodeMap.count(ex.nodeIdx))
-		activeNodeMap[ex.nodeIdx] = true;
+	activate_anim_node(ex.nodeIdx);
 
 	set_edge_alpha(ex.edgeIdx,animlinedata, 1);
-	if (!activeEdgeMap.count(ex.edgeIdx))
-		activeEdgeMap[ex.edgeIdx] = e;
+	activate_anim_edge(ex.edgeIdx, e);
 	
 	obtainMutex(funcQueueMutex, 1018);
 	string funcArgString;
@@ -380,85 +403,123 @@ void thread_graph_data::emptyArgQueue()
 	dropMutex(funcQueueMutex);
 }
 
-bool thread_graph_data::decrease_sequence()
+bool thread_graph_data::seek_sequence(unsigned long targetSeq)
 {
-	return true; //unimplemented, better things to do at the moment
+	//walked outside the lock, it takes node locks
+	replay_cursor target;
+	if (!target.seek(blockSequence, &replayIndex, this, targetSeq)) return false;
+
+	obtainMutex(animationListsMutex, 1055);
+	replay = target;
+	blockInstruction = 0;
+	firstAnimatedBB = lastAnimatedBB = replay.sequenceIndex;
+	dropMutex(animationListsMutex);
+
+	set_active_node(derive_anim_node());
+	return true;
 }
 
-bool thread_graph_data::advance_sequence(bool skipLoop = false)
+void thread_graph_data::set_heat_window(unsigned long start, unsigned long end)
 {
-	if (sequenceIndex + 1 >= bbsequence.size()) return false;
+	obtainMutex(animationListsMutex, 1060);
+	heatWindow = make_pair(start, end);
+	heatWindowChanged = true;
+	dropMutex(animationListsMutex);
+}
 
-	animInstructionIndex += bbsequence.at(sequenceIndex).second;
-	//if not looping
-	if (!loopStateList.at(sequenceIndex).first)
-	{
-		brighten_externs(++sequenceIndex, true);
-		return true;
-	}
+pair<unsigned long, unsigned long> thread_graph_data::get_heat_window()
+{
+	obtainMutex(animationListsMutex, 1061);
+	pair<unsigned long, unsigned long> window = heatWindow;
+	dropMutex(animationListsMutex);
+	return window;
+}
 
-	//first we update loop progress
+void thread_graph_data::mark_heat_dirty(vector<NODEPAIR> *edges)
+{
+	obtainMutex(dirtyMutex, 1062);
+	heatDirtyEdges.insert(heatDirtyEdges.end(), edges->begin(), edges->end());
+	++countUpdates;
+	dropMutex(dirtyMutex);
+}
 
-	//just started loop
-	if (!animLoopStartIdx)
-	{
-		targetIterations = loopStateList.at(sequenceIndex).second;
-		animLoopIndex = 0;
-		animLoopStartIdx = sequenceIndex;
-		loopIteration = 1;
-		animLoopProgress.push_back(loopIteration);
-	}
-	//block of first iteration of loop
-	else if (animLoopIndex > animLoopProgress.size() - 1)
-	{
-		loopIteration = 1;
-		animLoopProgress.push_back(loopIteration);
-	}
-	else
-	{
-		loopIteration = animLoopProgress.at(animLoopIndex) + 1;
-		animLoopProgress.at(animLoopIndex) = loopIteration;
-	}
+unsigned long thread_graph_data::get_count_updates()
+{
+	obtainMutex(dirtyMutex, 1067);
+	unsigned long updates = countUpdates;
+	dropMutex(dirtyMutex);
+	return updates;
+}
 
-	brighten_externs(sequenceIndex, true);
+//swaps the dirty list out, caller gets the changes since its last call
+void thread_graph_data::take_heat_dirty(vector<NODEPAIR> *edges)
+{
+	edges->clear();
+	obtainMutex(dirtyMutex, 1063);
+	edges->swap(heatDirtyEdges);
+	dropMutex(dirtyMutex);
+}
 
-	//now set where to go next
-	//last iteration of loop
-	if (skipLoop || (loopStateList.at(sequenceIndex).second == animLoopProgress.at(animLoopIndex)))
-	{
-		//last block of loop
-		if ((animLoopIndex >= animLoopProgress.size() - 1) || skipLoop)
-		{
-			++loopsPlayed;
-			animLoopProgress.clear();
-			animLoopStartIdx = 0;
-			animLoopIndex = 0;
-		}
-		else
-			++animLoopIndex;
-		
-		if (sequenceIndex + 1 >= bbsequence.size()) return false;
-		++sequenceIndex;
+void thread_graph_data::take_conditional_dirty(vector<unsigned int> *nodes)
+{
+	nodes->clear();
+	obtainMutex(dirtyMutex, 1064);
+	nodes->swap(conditionalDirtyNodes);
+	dropMutex(dirtyMutex);
+}
 
-		if (skipLoop)
-			while (loopStateList.at(sequenceIndex).first)
-				++sequenceIndex;
-	}
+bool thread_graph_data::seek_instruction(unsigned long targetIns)
+{
+	if (replayIndex.empty()) return false;
+	const REPLAY_CHECKPOINT &checkpoint = replayIndex.checkpoint(replayIndex.checkpoint_before_instruction(targetIns));
 
-	//last block of loop but not last iteration
-	else if (loopStateList.at(sequenceIndex).first != loopStateList.at(sequenceIndex + 1).first)
+	unsigned long insIdx = checkpoint.instructionIndex;
+	unsigned long seqIdx = checkpoint.sequenceIndex;
+	unsigned long sequenceSize = blockSequence->size();
+	for (; seqIdx + 1 < sequenceSize; ++seqIdx)
 	{
+		pair<unsigned int, unsigned long> loopState = blockSequence->loop_state(seqIdx);
+		unsigned long iterations = loopState.first ? loopState.second : 1;
+		insIdx += blockSequence->block(seqIdx).insCount * iterations;
+		if (insIdx > targetIns) break;
+	}
 
-		sequenceIndex = animLoopStartIdx;
-		animLoopIndex = 0;
-		
+	return seek_sequence(seqIdx);
+}
+
+//steps back a block, loops are stepped over as a whole
+bool thread_graph_data::decrease_sequence()
+{
+	unsigned long targetSeq;
+	if (replay.looping && (replay.sequenceIndex != replay.animLoopStartIdx || replay.loopIteration > 1))
+		targetSeq = replay.animLoopStartIdx;
+	else
+	{
+		if (replay.sequenceIndex >= blockSequence->size()) return false;
+		targetSeq = replay_cursor::loop_start(blockSequence, replay.sequenceIndex);
+		if (!targetSeq) return false;
+		--targetSeq;
 	}
-	else //inside loop
+	return seek_sequence(targetSeq);
+}
+
+bool thread_graph_data::advance_sequence(bool skipLoop = false)
+{
+	unsigned long sequenceSize = blockSequence->size();
+	if (skipLoop && replay.sequenceIndex + 1 < sequenceSize && blockSequence->loop_state(replay.sequenceIndex).first)
 	{
-		if (sequenceIndex + 1 >= bbsequence.size()) return false;
-		++sequenceIndex;
-		++animLoopIndex;
+		brighten_externs(replay.sequenceIndex, false);
+		//seeking past the loop counts the iterations skipped
+		unsigned long loopEnd = replay.sequenceIndex;
+		while (loopEnd + 1 < sequenceSize && blockSequence->loop_state(loopEnd).first)
+			++loopEnd;
+		if (blockSequence->loop_state(loopEnd).first) return false;
+		return seek_sequence(loopEnd);
 	}
+
+	unsigned long executed;
+	if (!replay.advance(blockSequence, &executed)) return false;
+	brighten_externs(executed, true);
 	return true;
 }
 
@@ -475,7 +536,7 @@ void thread_graph_data::performStep(int stepSize, bool skipLoop = false)
 	{
 		stepSize *= -1;
 		for (int i = 0; i < stepSize; ++i)
-			decrease_sequence();
+			if (!decrease_sequence()) break;
 	}
 
 	set_active_node(derive_anim_node());
@@ -490,7 +551,7 @@ unsigned int thread_graph_data::updateAnimation(unsigned int updateSize, bool an
 
 	bool animation_end = false;
 
-	if (sequenceIndex >= (bbsequence.size() - 1))
+	if (replay.sequenceIndex + 1 >= blockSequence->size())
 		return ANIMATION_ENDED;
 
 	return 0;
@@ -511,76 +572,149 @@ float getPulseAlpha()
 	return pulseAlpha;
 }
 
-void thread_graph_data::darken_animation(float alphaDelta)
+void thread_graph_data::activate_anim_edge(NODEPAIR edgePair, edge_data *e)
 {
+	if (animlinedata->get_generation() != activeEdgeGeneration)
+		relocate_anim_edges();
+	if (!e->vertSize) return;
 
-	if (!animlinedata->get_numVerts()) return;
-	GLfloat *ecol = &animlinedata->acquire_col()->at(0);
+	unsigned long firstVert = e->arraypos / COLELEMS;
+	if (firstVert >= activeEdgeFlags.size())
+		activeEdgeFlags.resize(firstVert + 1, false);
+	else if (activeEdgeFlags[firstVert]) return;
 
-	map<NODEPAIR, edge_data *>::iterator activeEdgeIt = activeEdgeMap.begin();
-	bool update = false;
+	activeEdgeFlags[firstVert] = true;
+	ANIM_EDGE active;
+	active.edge = edgePair;
+	active.firstVert = firstVert;
+	active.verts = e->vertSize;
+	activeEdges.push_back(active);
+}
+
+//the anim lines were rebuilt, so lit edges may have moved or not be drawn yet
+void thread_graph_data::relocate_anim_edges()
+{
+	activeEdgeGeneration = animlinedata->get_generation();
+	activeEdgeFlags.clear();
 
-	if (activeEdgeIt != activeEdgeMap.end()) 
-		update = true;
-	while (activeEdgeIt != activeEdgeMap.end())
+	size_t activeIdx = 0;
+	while (activeIdx < activeEdges.size())
 	{
-		edge_data *e = activeEdgeIt->second;
-		if (!e->vertSize) { 
-			++activeEdgeIt;
-			continue; 
+		ANIM_EDGE *active = &activeEdges[activeIdx];
+		edge_data *e = get_edge(active->edge);
+		if (e && e->vertSize)
+		{
+			active->firstVert = e->arraypos / COLELEMS;
+			active->verts = e->vertSize;
+			if (active->firstVert >= activeEdgeFlags.size())
+				activeEdgeFlags.resize(active->firstVert + 1, false);
+			activeEdgeFlags[active->firstVert] = true;
+			++activeIdx;
+			continue;
 		}
+		//it will be drawn faded when it is back
+		activeEdges[activeIdx] = activeEdges.back();
+		activeEdges.pop_back();
+	}
+}
+
+void thread_graph_data::activate_anim_node(unsigned int nodeIdx)
+{
+	if (nodeIdx >= activeNodeFlags.size())
+		activeNodeFlags.resize(nodeIdx + 1, false);
+	else if (activeNodeFlags[nodeIdx]) return;
 
-		unsigned long edgeStart = e->arraypos;
-		float edgeAlpha;
-		float lowestAlpha = 0;
+	activeNodeFlags[nodeIdx] = true;
+	activeNodes.push_back(nodeIdx);
+}
+
+void thread_graph_data::clear_anim_active()
+{
+	activeEdges.clear();
+	activeEdgeFlags.clear();
+	activeNodes.clear();
+	activeNodeFlags.clear();
+}
 
-		for (unsigned int i = 0; i < e->vertSize; ++i)
+//no branches or lookups so the compiler can vectorise it. returns true if any are still lit
+static bool fade_alphas(GLfloat *cols, unsigned long verts, GLfloat alphaDelta, GLfloat floorAlpha)
+{
+	int lit = 0;
+	for (unsigned long vertIdx = 0; vertIdx < verts; ++vertIdx)
+	{
+		GLfloat faded = cols[vertIdx * COLELEMS + AOFF] - alphaDelta;
+		lit |= (faded > floorAlpha);
+		cols[vertIdx * COLELEMS + AOFF] = (faded > floorAlpha) ? faded : floorAlpha;
+	}
+	return lit != 0;
+}
+
+void thread_graph_data::darken_animation(float alphaDelta)
+{
+
+	if (!animlinedata->get_numVerts()) return;
+	animlinedata->acquire_col();
+	unsigned long ecolCapacity = animlinedata->col_count() * COLELEMS;
+
+	bool update = !activeEdges.empty() || !activeNodes.empty();
+
+	if (animlinedata->get_generation() != activeEdgeGeneration)
+		relocate_anim_edges();
+
+	//clamping to a float copy of the floor makes the faded test exact
+	const GLfloat inactiveEdgeAlpha = ANIM_INACTIVE_EDGE_ALPHA;
+	size_t activeIdx = 0;
+	while (activeIdx < activeEdges.size())
+	{
+		ANIM_EDGE *active = &activeEdges[activeIdx];
+		bool lit = false;
+		if ((active->firstVert + active->verts) * COLELEMS <= ecolCapacity)
 		{
-			const unsigned int colBufIndex = edgeStart + i*COLELEMS + AOFF;
-			if (colBufIndex >= animlinedata->col_buf_capacity_floats())
+			unsigned long vertIdx = active->firstVert, runVerts;
+			const unsigned long vertEnd = vertIdx + active->verts;
+			while (vertIdx < vertEnd)
 			{
-				//sometimes happens if terminated at a bad time. will fix itself
-				cerr << "[rgat]Warning: colbufIndex > capacity" << endl;
-				animlinedata->release_col();
-				return;
+				GLfloat *run = animlinedata->col_run(vertIdx, &runVerts);
+				runVerts = min(runVerts, vertEnd - vertIdx);
+				lit |= fade_alphas(run, runVerts, alphaDelta, inactiveEdgeAlpha);
+				vertIdx += runVerts;
 			}
-			edgeAlpha = ecol[colBufIndex];
-
-			//TODO: problems here!
-			//0.05 stored as 0.05000000002
-			//0.06 stored as 0.59999999999997 [not the real number of 0's]
-			edgeAlpha = fmax(ANIM_INACTIVE_EDGE_ALPHA, edgeAlpha - alphaDelta);
-			ecol[colBufIndex] = edgeAlpha;
-			lowestAlpha = fmax(lowestAlpha, edgeAlpha);
-		}	
-
-		//workaround to problem, fails with 0.05, works with 0.06
-		if (lowestAlpha <= ANIM_INACTIVE_EDGE_ALPHA)
-			activeEdgeIt = activeEdgeMap.erase(activeEdgeIt);
-		else
-			++activeEdgeIt;
+			animlinedata->mark_col(active->firstVert, active->verts);
+		}
+
+		if (lit) { ++activeIdx; continue; }
+		//order doesn't matter, swap the last one in
+		activeEdgeFlags[active->firstVert] = false;
+		*active = activeEdges.back();
+		activeEdges.pop_back();
 	}
 	animlinedata->release_col();
-	GLfloat *ncol = &animnodesdata->acquire_col()->at(0);
-	int colBufSize = animnodesdata->col_buf_capacity_floats();
 
-	map<unsigned int, bool>::iterator activeNodeIt = activeNodeMap.begin();
-	if (activeNodeIt != activeNodeMap.end()) 
-		update = true;
-	while (activeNodeIt != activeNodeMap.end())
+	animnodesdata->acquire_col();
+	unsigned long colBufSize = animnodesdata->col_count() * COLELEMS;
+
+	const GLfloat inactiveNodeAlpha = ANIM_INACTIVE_NODE_ALPHA;
+	activeIdx = 0;
+	while (activeIdx < activeNodes.size())
 	{
-		unsigned int nodeIndex = activeNodeIt->first;
-		node_data *n = get_node(nodeIndex);
-		int colBufIndex = (nodeIndex * COLELEMS) + AOFF;
-		if (colBufIndex >= colBufSize) break;
-		float currentAlpha = ncol[colBufIndex];
-		currentAlpha = fmax(ANIM_INACTIVE_NODE_ALPHA, currentAlpha - alphaDelta);
-		ncol[colBufIndex] = currentAlpha;
-
-		if (currentAlpha == ANIM_INACTIVE_NODE_ALPHA)
-			activeNodeIt = activeNodeMap.erase(activeNodeIt);
-		else
-			++activeNodeIt;
+		unsigned int nodeIndex = activeNodes[activeIdx];
+		unsigned long colBufIndex = (nodeIndex * COLELEMS) + AOFF;
+		if (colBufIndex >= colBufSize) { ++activeIdx; continue; }
+
+		GLfloat *alpha = animnodesdata->col_at(nodeIndex) + AOFF;
+		GLfloat nodeAlpha = *alpha - alphaDelta;
+		animnodesdata->mark_col(nodeIndex, 1);
+		if (nodeAlpha > inactiveNodeAlpha)
+		{
+			*alpha = nodeAlpha;
+			++activeIdx;
+			continue;
+		}
+
+		*alpha = inactiveNodeAlpha;
+		activeNodeFlags[nodeIndex] = false;
+		activeNodes[activeIdx] = activeNodes.back();
+		activeNodes.pop_back();
 	}
 
 	animnodesdata->release_col();
@@ -591,10 +725,9 @@ void thread_graph_data::reset_animation()
 {
 	last_anim_start = 0;
 	last_anim_stop = 0;
-	animInstructionIndex = 0;
 	newanim = true;
 
-	sequenceIndex = 0;
+	replay.reset();
 	blockInstruction = 0;
 	if (!nodeList.empty())
 	{
@@ -603,18 +736,124 @@ void thread_graph_data::reset_animation()
 	}
 	firstAnimatedBB = 0;
 	lastAnimatedBB = 0;
-	activeEdgeMap.clear();
-	activeNodeMap.clear();
-	loopsPlayed = 0;
-	loopIteration = 0;
-	targetIterations = 0;
-	callCounter.clear();
+	clear_anim_active();
+}
+
+bool thread_graph_data::find_block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, unsigned int *nodeIdx)
+{
+	getNodeReadLock();
+	map<pair<MEM_ADDRESS, BLOCK_IDENTIFIER>, unsigned int>::iterator blockIt = blockNodeIndex.find(make_pair(blockaddr, blockID));
+	bool found = (blockIt != blockNodeIndex.end());
+	if (found) *nodeIdx = blockIt->second;
+	dropNodeReadLock();
+	return found;
+}
+
+void thread_graph_data::add_block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, unsigned int nodeIdx)
+{
+	getNodeWriteLock();
+	blockNodeIndex.emplace(make_pair(blockaddr, blockID), nodeIdx);
+	dropNodeWriteLock();
+}
+
+//a block node first seen cut short now runs further, so is redrawn for its real last instruction
+bool thread_graph_data::extend_block_node(unsigned int nodeIdx, INSLIST *block, unsigned int insCount)
+{
+	getNodeWriteLock();
+	node_data *n = &nodeList.at(nodeIdx);
+	int oldConditional = n->conditional;
+	bool grew = n->extend_block(block, insCount);
+	dropNodeWriteLock();
+
+	if (grew && n->conditional != oldConditional)
+	{
+		obtainMutex(dirtyMutex, 1066);
+		conditionalDirtyNodes.push_back(nodeIdx);
+		dropMutex(dirtyMutex);
+	}
+	return grew;
+}
+
+//nodes and edges of the block at seqIdx, from the cache after the first time
+BLOCK_SPAN *thread_graph_data::get_block_span(unsigned long seqIdx)
+{
+	BLOCK_HANDLE handle = blockSequence->handle(seqIdx);
+	if (handle < blockSpans.size() && blockSpans[handle])
+		return blockSpans[handle];
+
+	const SEQUENCE_BLOCK &seqBlock = blockSequence->block(seqIdx);
+	if (blockNodes)
+	{
+		//one node, nothing internal
+		unsigned int blockNode;
+		if (!find_block_node(seqBlock.address, seqBlock.blockID, &blockNode)) return 0;
+		BLOCK_SPAN *span = new BLOCK_SPAN;
+		span->nodes.push_back(blockNode);
+		if (handle >= blockSpans.size())
+			blockSpans.resize(handle + 1, 0);
+		blockSpans[handle] = span;
+		return span;
+	}
+
+	INSLIST *block = getDisassemblyBlock(seqBlock.address, seqBlock.blockID, piddata, &terminationFlag);
+	if (!block) return 0;
+
+	BLOCK_SPAN *span = new BLOCK_SPAN;
+	piddata->getDisassemblyReadLock();
+	for (unsigned int blockIdx = 0; blockIdx < seqBlock.insCount; ++blockIdx)
+	{
+		unordered_map<PID_TID, int>::iterator vertIt = block->at(blockIdx)->threadvertIdx.find(tid);
+		if (vertIt == block->at(blockIdx)->threadvertIdx.end()) break;
+		span->nodes.push_back(vertIt->second);
+	}
+	piddata->dropDisassemblyReadLock();
+
+	if (span->nodes.size() != seqBlock.insCount)
+	{
+		delete span;
+		return 0;
+	}
+
+	for (unsigned int blockIdx = 0; blockIdx + 1 < span->nodes.size(); ++blockIdx)
+	{
+		edge_data *e = get_edge(make_pair(span->nodes[blockIdx], span->nodes[blockIdx + 1]));
+		if (!e) break;
+		span->internalEdges.push_back(e);
+	}
+
+	//an edge may be missing because an exception cut the block short, keep asking until it appears
+	if (span->internalEdges.size() + 1 < span->nodes.size())
+	{
+		faultedSpan = *span;
+		delete span;
+		return &faultedSpan;
+	}
+
+	if (handle >= blockSpans.size())
+		blockSpans.resize(handle + 1, 0);
+	blockSpans[handle] = span;
+	return span;
+}
+
+edge_data *thread_graph_data::get_span_exit(BLOCK_SPAN *span, unsigned int targetNode)
+{
+	vector<pair<unsigned int, edge_data *>>::iterator exitIt = span->exits.begin();
+	for (; exitIt != span->exits.end(); ++exitIt)
+		if (exitIt->first == targetNode) return exitIt->second;
+
+	edge_data *linkingEdge;
+	unsigned int lastNode = span->nodes.at(span->internalEdges.size());
+	if (!edge_exists(make_pair(lastNode, targetNode), &linkingEdge)) return 0;
+	if (span != &faultedSpan)
+		span->exits.push_back(make_pair(targetNode, linkingEdge));
+	return linkingEdge;
 }
 
 int thread_graph_data::brighten_BBs()
 {
-	unsigned int lastNodeIdx = 0;
-	unsigned int animEnd = sequenceIndex;
+	BLOCK_SPAN *lastSpan = 0;
+	BLOCK_SPAN lastFaultedSpan;
+	unsigned int animEnd = replay.sequenceIndex;
 
 	unsigned int animPosition = firstAnimatedBB; 
 	if (animPosition == animEnd) return animEnd;
@@ -623,133 +862,92 @@ int thread_graph_data::brighten_BBs()
 		animPosition = animEnd - MAX_LIVE_ANIMATION_NODES_PER_FRAME;
 
 	bool dropout = false;
-	map <unsigned long, bool> recentHighlights;
 
 	for (; animPosition < animEnd; ++animPosition)
 	{
-		bool isLastInSequence = (animPosition == (animEnd - 1));
 		brighten_externs(animPosition, active);
 
-		//don't re-brighten same edge/node on same animation frame
-		if (recentHighlights.count(animPosition)) continue;
-		recentHighlights[animPosition] = true;
-
-		GLfloat *ncol = &animnodesdata->acquire_col()->at(0);
-		GLfloat *ecol = &animlinedata->acquire_col()->at(0);
-
-		while (!ncol || !ecol) 
-		{
-			animnodesdata->release_col();
-			animlinedata->release_col();
-			cerr << "[rgat]Warning: BB brighten failed" << endl;
-			Sleep(75); 
-			ncol = &animnodesdata->acquire_col()->at(0);
-			ecol = &animlinedata->acquire_col()->at(0);
-		}
-
-
-		obtainMutex(animationListsMutex, 1020);
-		pair<MEM_ADDRESS, int> targBlock_Size = bbsequence.at(animPosition);
-		BLOCK_IDENTIFIER blockID = mutationSequence.at(animPosition);
-		dropMutex(animationListsMutex);
-		
-		MEM_ADDRESS blockAddr = targBlock_Size.first;
-		int numInstructions = targBlock_Size.second;
-		
-		INSLIST *block = getDisassemblyBlock(blockAddr, blockID,piddata, &terminationFlag);
-		INS_DATA *ins = block->at(0);
-
-		unordered_map<PID_TID, int>::iterator vertIt = ins->threadvertIdx.find(tid);
-		if (vertIt == ins->threadvertIdx.end())
+		BLOCK_SPAN *span = get_block_span(animPosition);
+		if (!span)
 		{
 			cerr << "[rgat]WARNING: BrightenBBs going too far? Breaking!" << endl;
-			animnodesdata->release_col();
-			animlinedata->release_col();
 			break;
 		}
-		
-		piddata->getDisassemblyReadLock();
-		unsigned int nodeIdx = vertIt->second;
-		piddata->dropDisassemblyReadLock();
 
-		if (lastNodeIdx)
+		animnodesdata->acquire_col();
+		animlinedata->acquire_col();
+
+		unsigned long ecolCapacity = animlinedata->col_count() * COLELEMS;
+		unsigned long ncolCapacity = animnodesdata->col_count() * COLELEMS;
+
+		if (lastSpan)
 		{
-			NODEPAIR edgePair = make_pair(lastNodeIdx, nodeIdx);
-			edge_data *linkingEdge;
-			if (!edge_exists(edgePair, &linkingEdge)) {
+			edge_data *linkingEdge = get_span_exit(lastSpan, span->nodes.front());
+			if (!linkingEdge) {
 				//TODO: FIXME! this happens when an exception causes a basic block to be half executed
-				//cerr << "[rgat]WARNING: BrightenBBs: lastnode " << lastNodeIdx << "->node "
-				//	<< nodeIdx << " not in edgedict." << endl;
 				++animPosition;
 				animnodesdata->release_col();
 				animlinedata->release_col();
 				break;
 			}
 
-			int numEdgeVerts = linkingEdge->vertSize;
-			for (int i = 0; i < numEdgeVerts; ++i)
+			unsigned long alphaEnd = linkingEdge->arraypos + linkingEdge->vertSize*COLELEMS;
+			if (linkingEdge->vertSize && alphaEnd - COLELEMS + AOFF >= ecolCapacity)
 			{
-				const unsigned int colArrIndex = linkingEdge->arraypos + i*COLELEMS + AOFF;
-				if (colArrIndex >= animlinedata->col_buf_capacity_floats())
-				{
-					//used this in devel, not sure it still happens. dead code?
-					cerr << "[rgat]Error: DROPOUT EDGE" << endl;
-					dropout = true;
-					animnodesdata->release_col();
-					animlinedata->release_col();
-					break;
-				}
-				ecol[colArrIndex] = (float)1.0;
+				//used this in devel, not sure it still happens. dead code?
+				cerr << "[rgat]Error: DROPOUT EDGE" << endl;
+				dropout = true;
+			}
+			else
+			{
+				unsigned long vertEnd = alphaEnd / COLELEMS;
+				for (unsigned long vertIdx = linkingEdge->arraypos / COLELEMS; vertIdx < vertEnd; ++vertIdx)
+					animlinedata->col_at(vertIdx)[AOFF] = (float)1.0;
+				animlinedata->mark_col(linkingEdge->arraypos / COLELEMS, linkingEdge->vertSize);
+				activate_anim_edge(make_pair(lastSpan->nodes.at(lastSpan->internalEdges.size()), span->nodes.front()), linkingEdge);
 			}
-
-			if (!activeEdgeMap.count(edgePair))
-				activeEdgeMap[edgePair] = linkingEdge;
 		}
 
-		
-		for (int blockIdx = 0; blockIdx < numInstructions; ++blockIdx)
+		for (size_t blockIdx = 0; blockIdx < span->nodes.size() && !dropout; ++blockIdx)
 		{
-			const unsigned int colArrIndex = (nodeIdx * COLELEMS) + AOFF;
-			if (colArrIndex >= animnodesdata->col_buf_capacity_floats())
+			unsigned int nodeIdx = span->nodes[blockIdx];
+			const unsigned long colArrIndex = (nodeIdx * COLELEMS) + AOFF;
+			if (colArrIndex >= ncolCapacity)
 			{
 				//trying to brighten nodes we havent rendered yet
 				dropout = true;
-				animnodesdata->release_col();
-				animlinedata->release_col();
 				break;
 			}
 
 			//brighten the node
-			ncol[colArrIndex] = 1;
-			if (!activeNodeMap.count(nodeIdx))
-				activeNodeMap[nodeIdx] = true;
+			animnodesdata->col_at(nodeIdx)[AOFF] = 1;
+			animnodesdata->mark_col(nodeIdx, 1);
+			activate_anim_node(nodeIdx);
 
-			if (blockIdx == numInstructions - 1) break;
+			if (blockIdx == span->internalEdges.size()) break;
 
 			//brighten short edge between internal nodes
-			INS_DATA* nextIns = block->at(blockIdx + 1);
-			unsigned int nextInsIndex = nextIns->threadvertIdx.at(tid);
-			NODEPAIR edgePair = make_pair(nodeIdx, nextInsIndex);
-
-			edge_data *e = get_edge(edgePair);
-			if (!e) break;
-
+			edge_data *e = span->internalEdges[blockIdx];
 			unsigned long edgeColPos = e->arraypos;
-			ecol[edgeColPos + AOFF] = 1.0;
-			ecol[edgeColPos + COLELEMS + AOFF] = 1.0;
-			assert(edgeColPos + COLELEMS + AOFF < animlinedata->col_buf_capacity_floats());
-			if (!activeEdgeMap.count(edgePair))
-					activeEdgeMap[edgePair] = e;
-
-			nodeIdx = nextInsIndex;
-			ins = nextIns;
+			assert(edgeColPos + COLELEMS + AOFF < ecolCapacity);
+			animlinedata->col_at(edgeColPos / COLELEMS)[AOFF] = 1.0;
+			animlinedata->col_at(edgeColPos / COLELEMS + 1)[AOFF] = 1.0;
+			animlinedata->mark_col(edgeColPos / COLELEMS, 2);
+			activate_anim_edge(make_pair(nodeIdx, span->nodes[blockIdx + 1]), e);
 		}
-		
-		lastNodeIdx = nodeIdx;
+
 		animnodesdata->release_col();
 		animlinedata->release_col();
 		
 		if (dropout) break;
+
+		//the next block's lookup can overwrite the shared faulted span
+		if (span == &faultedSpan)
+		{
+			lastFaultedSpan = faultedSpan;
+			span = &lastFaultedSpan;
+		}
+		lastSpan = span;
 	}
 	brighten_externs(animEnd, active);
 
@@ -763,18 +961,18 @@ take the rest from the faded graph
 combine, season to taste
 
 this is where optimisation is most important
-darken_animation is ~25% of cpu activity
-brighten_BBs is ~5%
+darken_animation only visits lit nodes/edges
+brighten_BBs reads cached block spans
 */
 void thread_graph_data::animate_latest(float fadeRate)
 {
-	if (bbsequence.empty()) return;
+	if (blockSequence->empty()) return;
 	darken_animation(fadeRate);
 
-	sequenceIndex = bbsequence.size() - 1;
+	replay.sequenceIndex = blockSequence->size() - 1;
 	
 	firstAnimatedBB = lastAnimatedBB;
-	lastAnimatedBB = sequenceIndex;
+	lastAnimatedBB = replay.sequenceIndex;
 
 	lastAnimatedBB = brighten_BBs();
 
@@ -788,7 +986,7 @@ void thread_graph_data::update_animation_render(float fadeRate)
 {
 	darken_animation(fadeRate);
 
-	firstAnimatedBB = sequenceIndex - ANIMATION_WIDTH;
+	firstAnimatedBB = replay.sequenceIndex - ANIMATION_WIDTH;
 	brighten_BBs();
 }
 
@@ -796,22 +994,10 @@ void thread_graph_data::update_animation_render(float fadeRate)
 unsigned int thread_graph_data::derive_anim_node()
 {
 
-	obtainMutex(animationListsMutex, 1022);
-	pair<MEM_ADDRESS, int> addr_size = bbsequence.at(sequenceIndex);
-	BLOCK_IDENTIFIER blockID = mutationSequence.at(sequenceIndex);
-	dropMutex(animationListsMutex);
-
-	MEM_ADDRESS blockAddr = addr_size.first;
-	int remainingInstructions = blockInstruction;
-	
-	INS_DATA *target_ins = getDisassemblyBlock(blockAddr, blockID, piddata, &terminationFlag)->at(blockInstruction);
-
 	//this check is needed on early termination
-	unordered_map<PID_TID, int>::iterator foundIdx = target_ins->threadvertIdx.find(tid);
-	if (foundIdx != target_ins->threadvertIdx.end())
-		return foundIdx->second;
-	else
-		return 0;
+	BLOCK_SPAN *span = get_block_span(replay.sequenceIndex);
+	if (!span || blockInstruction >= span->nodes.size()) return 0;
+	return span->nodes[blockInstruction];
 }
 
 void thread_graph_data::reset_mainlines() 
@@ -986,13 +1172,17 @@ void thread_graph_data::set_active_node(unsigned int idx)
 int thread_graph_data::render_edge(NODEPAIR ePair, GRAPH_DISPLAY_DATA *edgedata, map<int, ALLEGRO_COLOR> *lineColours,
 	ALLEGRO_COLOR *forceColour, bool preview)
 {
-	node_data *sourceNode = get_node(ePair.first);
-	node_data *targetNode = get_node(ePair.second);
-
-	edge_data *e = &edgeDict.at(ePair);
+	return render_edge(ePair, &edgeDict.at(ePair), edgedata, lineColours, forceColour, preview);
+}
 
+int thread_graph_data::render_edge(NODEPAIR ePair, edge_data *e, GRAPH_DISPLAY_DATA *edgedata,
+	map<int, ALLEGRO_COLOR> *lineColours, ALLEGRO_COLOR *forceColour, bool preview)
+{
 	if (!e) return 0;
 
+	node_data *sourceNode = get_node(ePair.first);
+	node_data *targetNode = get_node(ePair.second);
+
 	MULTIPLIERS *scaling;
 	if (preview)
 		scaling = p_scalefactors;
@@ -1041,6 +1231,8 @@ thread_graph_data::thread_graph_data(PROCESS_DATA *processdata, unsigned int thr
 	pid = piddata->PID;
 	tid = threadID;
 
+	blockSequence = new execution_sequence(&piddata->sequenceBlocks);
+
 	mainnodesdata = new GRAPH_DISPLAY_DATA();
 	mainlinedata = new GRAPH_DISPLAY_DATA();
 
@@ -1050,9 +1242,11 @@ thread_graph_data::thread_graph_data(PROCESS_DATA *processdata, unsigned int thr
 	previewlines = new GRAPH_DISPLAY_DATA(true);
 	previewnodes = new GRAPH_DISPLAY_DATA(true);
 
-	conditionallines = new GRAPH_DISPLAY_DATA();
-	conditionalnodes = new GRAPH_DISPLAY_DATA();
-	heatmaplines = new GRAPH_DISPLAY_DATA();
+	conditionallines = new PALETTE_LAYER();
+	conditionalnodes = new PALETTE_LAYER();
+	heatmaplines = new PALETTE_LAYER();
+	lod = new graph_lod();
+	nodeGrid = new node_grid();
 	needVBOReload_conditional = true;
 	needVBOReload_heatmap = true;
 	needVBOReload_main = true;
@@ -1078,6 +1272,23 @@ void thread_graph_data::stop_edgeL_iteration()
 	dropEdgeReadLock();
 }
 
+//lock is only held for the copy, edge data doesn't move when the dictionary grows
+unsigned long thread_graph_data::copy_edge_range(unsigned long first, unsigned long maxEdges,
+	vector<pair<NODEPAIR, edge_data *>> *edges)
+{
+	edges->clear();
+	getEdgeReadLock();
+	unsigned long available = (unsigned long)edgeList.size();
+	unsigned long last = first + min(maxEdges, available > first ? available - first : 0);
+	for (unsigned long edgeIdx = first; edgeIdx < last; ++edgeIdx)
+	{
+		NODEPAIR ePair = edgeList[edgeIdx];
+		edges->push_back(make_pair(ePair, &edgeDict.at(ePair)));
+	}
+	dropEdgeReadLock();
+	return edges->size();
+}
+
 void thread_graph_data::start_edgeD_iteration(EDGEMAP::iterator *edgeIt,
 	EDGEMAP::iterator *edgeEnd)
 {
@@ -1118,10 +1329,20 @@ void thread_graph_data::add_edge(edge_data e, node_data *source, node_data *targ
 	source->outgoingNeighbours.insert(edgePair.second);
 	if (source->conditional && (source->conditional != CONDCOMPLETE))
 	{
-		if (source->ins->condDropAddress == target->address)
+		int oldState = source->conditional;
+		//execution enters a block node at its first instruction, not the last one it's drawn for
+		MEM_ADDRESS targetEntry = target->blockAddress ? target->blockAddress : target->address;
+		if (source->ins->condDropAddress == targetEntry)
 			source->conditional |= CONDFELLTHROUGH;
-		else if (source->ins->condTakenAddress == target->address)
+		else if (source->ins->condTakenAddress == targetEntry)
 			source->conditional |= CONDTAKEN;
+
+		if (source->conditional != oldState)
+		{
+			obtainMutex(dirtyMutex, 1065);
+			conditionalDirtyNodes.push_back(source->index);
+			dropMutex(dirtyMutex);
+		}
 	}
 
 	target->incomingNeighbours.insert(edgePair.first);
@@ -1137,6 +1358,11 @@ thread_graph_data::~thread_graph_data()
 {
 	delete animlinedata;
 	delete animnodesdata;
+	delete blockSequence;
+	delete lod;
+	delete nodeGrid;
+	for (size_t i = 0; i < blockSpans.size(); ++i)
+		delete blockSpans[i];
 }
 
 void thread_graph_data::set_edge_alpha(NODEPAIR eIdx, GRAPH_DISPLAY_DATA *edgesdata, float alpha)
@@ -1144,24 +1370,28 @@ void thread_graph_data::set_edge_alpha(NODEPAIR eIdx, GRAPH_DISPLAY_DATA *edgesd
 	if (!edgesdata->get_numVerts()) return;
 	edge_data *e = get_edge(eIdx);
 	if (!e) return; 
-	const unsigned int bufsize = edgesdata->col_buf_capacity_floats();
-	GLfloat *colarray = &edgesdata->acquire_col()->at(0);
-	for (unsigned int i = 0; i < e->vertSize; ++i)
+	edgesdata->acquire_col();
+	const unsigned long writtenVerts = edgesdata->col_count();
+	const unsigned long firstVert = e->arraypos / COLELEMS;
+	unsigned int i = 0;
+	for (; i < e->vertSize; ++i)
 	{
-		unsigned int bufIndex = e->arraypos + i*COLELEMS + AOFF;
-		if (bufIndex > bufsize) break;
-		colarray[bufIndex] = alpha;
+		unsigned long vertIdx = firstVert + i;
+		if (vertIdx >= writtenVerts) break;
+		edgesdata->col_at(vertIdx)[AOFF] = alpha;
 	}
+	edgesdata->mark_col(firstVert, i);
 	edgesdata->release_col();
 }
 
 void thread_graph_data::set_node_alpha(unsigned int nIdx, GRAPH_DISPLAY_DATA *nodesdata, float alpha)
 {
-	unsigned int bufIndex = nIdx*COLELEMS + AOFF;
-	if (bufIndex >= nodesdata->col_buf_capacity_floats()) return;
-
-	GLfloat *colarray = &nodesdata->acquire_col()->at(0);
-	colarray[bufIndex] = alpha;
+	nodesdata->acquire_col();
+	if (nIdx < nodesdata->col_count())
+	{
+		nodesdata->col_at(nIdx)[AOFF] = alpha;
+		nodesdata->mark_col(nIdx, 1);
+	}
 	nodesdata->release_col();
 }
 
@@ -1178,7 +1408,7 @@ void thread_graph_data::assign_modpath(PROCESS_DATA *pidinfo)
 		modPath = longmodPath;
 }
 
-bool thread_graph_data::serialise(ofstream *file)
+bool thread_graph_data::serialise(ofstream *file, bool saveBuffers)
 {
 	*file << "TID" << tid << "{";
 
@@ -1220,19 +1450,18 @@ bool thread_graph_data::serialise(ofstream *file)
 		<< "}S,";
 
 	*file << "A{";
-	obtainMutex(animationListsMutex, 1030);
-	for (unsigned long i = 0; i < bbsequence.size(); ++i)
+	unsigned long sequenceSize = blockSequence->size();
+	for (unsigned long i = 0; i < sequenceSize; ++i)
 	{
-		pair<MEM_ADDRESS, int> seq_size = bbsequence.at(i);
-		int mutation = mutationSequence.at(i);
-
-		*file << seq_size.first << "," << seq_size.second << ","
-			<< mutationSequence[i] << ","
-			<< loopStateList[i].first << ",";
-		if (loopStateList[i].first )
-			*file << loopStateList[i].second << ",";
+		const SEQUENCE_BLOCK &block = blockSequence->block(i);
+		pair<unsigned int, unsigned long> loopState = blockSequence->loop_state(i);
+
+		*file << block.address << "," << block.insCount << ","
+			<< block.blockID << ","
+			<< loopState.first << ",";
+		if (loopState.first)
+			*file << loopState.second << ",";
 	}
-	dropMutex(animationListsMutex);
 	*file << "}A,";
 
 	*file << "C{";
@@ -1249,10 +1478,79 @@ bool thread_graph_data::serialise(ofstream *file)
 	}
 	*file << "}C,";
 
+	if (edgeCounts)
+	{
+		//same order as the edge list
+		*file << "W{";
+		for (edgeLIt = edgeList.begin(); edgeLIt != edgeList.end(); ++edgeLIt)
+		{
+			edge_data *e = get_edge(*edgeLIt);
+			*file << e->executionCount << "," << e->countUncertain << ",";
+		}
+		*file << "}W,";
+	}
+
+	if (saveBuffers)
+		saveDisplayBuffers(file);
+
 	*file << "}";
 	return true;
 }
 
+static void saveFloats(ofstream *file, unsigned int verts, unsigned int edges, vector<GLfloat> &pos, vector<GLfloat> &col)
+{
+	*file << verts << "," << edges << "," << pos.size() << "," << col.size() << ",";
+	if (!pos.empty())
+		*file << base64_encode((unsigned char *)&pos.at(0), pos.size() * sizeof(GLfloat));
+	*file << ",";
+	if (!col.empty())
+		*file << base64_encode((unsigned char *)&col.at(0), col.size() * sizeof(GLfloat));
+	*file << ",";
+}
+
+static void saveFloatBuffer(ofstream *file, GRAPH_DISPLAY_DATA *buffer)
+{
+	vector<GLfloat> pos, col;
+	buffer->copy_pos(&pos);
+	buffer->copy_col(&col);
+	saveFloats(file, buffer->get_numVerts(), buffer->get_renderedEdges(), pos, col);
+}
+
+//expanded to floats so the saved format doesn't depend on the palette
+static void saveFloatBuffer(ofstream *file, PALETTE_LAYER *layer)
+{
+	vector<GLfloat> noPos, col;
+	layer->copy_col(&col);
+	saveFloats(file, layer->get_numVerts(), layer->get_renderedEdges(), noPos, col);
+}
+
+//optional G section: rendered main/preview/heatmap geometry + the scaling it was built with
+void thread_graph_data::saveDisplayBuffers(ofstream *file)
+{
+	*file << "G{" << sizeof(MULTIPLIERS) << ","
+		<< base64_encode((unsigned char *)m_scalefactors, sizeof(MULTIPLIERS)) << ","
+		<< base64_encode((unsigned char *)p_scalefactors, sizeof(MULTIPLIERS)) << ","
+		<< heatExtremes.first << "," << heatExtremes.second << ",";
+
+	saveFloatBuffer(file, mainnodesdata);
+	saveFloatBuffer(file, mainlinedata);
+	saveFloatBuffer(file, previewnodes);
+	saveFloatBuffer(file, previewlines);
+	saveFloatBuffer(file, heatmaplines);
+
+	//animation finds edges in the line buffers through these
+	getEdgeReadLock();
+	*file << edgeList.size() << ",";
+	EDGELIST::iterator edgeLIt = edgeList.begin();
+	for (; edgeLIt != edgeList.end(); ++edgeLIt)
+	{
+		edge_data *e = &edgeDict.at(*edgeLIt);
+		*file << e->vertSize << "," << e->arraypos << ",";
+	}
+	dropEdgeReadLock();
+	*file << "}G,";
+}
+
 bool thread_graph_data::loadEdgeDict(ifstream *file)
 {
 	string index_s, source_s, target_s, edgeclass_s;
@@ -1328,7 +1626,141 @@ bool thread_graph_data::unserialise(ifstream *file, map <MEM_ADDRESS, INSLIST> *
 	if (!loadExceptions(file)) { cerr << "[rgat]ERROR:Exceptions load failed" << endl;  return false; }
 	if (!loadStats(file)) { cerr << "[rgat]ERROR:Stats load failed" << endl;  return false; }
 	if (!loadAnimationData(file)) { cerr << "[rgat]ERROR:Animation load failed" << endl;  return false; }
+	index_replay();
 	if (!loadCallSequence(file)) { cerr << "[rgat]ERROR:Call sequence load failed" << endl; return false; }
+	if (file->peek() != 'W')
+		edgeCounts = false;
+	else if (!loadEdgeCounts(file)) { cerr << "[rgat]ERROR:Edge count load failed" << endl; return false; }
+	if (file->peek() == 'G' && !loadDisplayBuffers(file)) { cerr << "[rgat]ERROR:Display buffer load failed" << endl; return false; }
+	return true;
+}
+
+struct LOADED_BUFFER {
+	unsigned int verts;
+	unsigned int edges;
+	vector<GLfloat> pos;
+	vector<GLfloat> col;
+};
+
+static bool loadFloatVector(ifstream *file, unsigned long floats, vector<GLfloat> *result)
+{
+	string b64_s;
+	getline(*file, b64_s, ',');
+	string raw = base64_decode(b64_s);
+	if (raw.size() != floats * sizeof(GLfloat)) return false;
+	result->resize(floats);
+	if (floats)
+		memcpy(&result->at(0), raw.data(), raw.size());
+	return true;
+}
+
+static bool loadFloatBuffer(ifstream *file, LOADED_BUFFER *buffer)
+{
+	string value_s;
+	unsigned long posFloats, colFloats;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &buffer->verts, 10)) return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &buffer->edges, 10)) return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoul(value_s, &posFloats, 10)) return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoul(value_s, &colFloats, 10)) return false;
+
+	if (!loadFloatVector(file, posFloats, &buffer->pos)) return false;
+	return loadFloatVector(file, colFloats, &buffer->col);
+}
+
+//use saved geometry instead of regenerating it
+//if the renderer later rescales (eg: different autoscale limits) it regenerates as normal
+bool thread_graph_data::loadDisplayBuffers(ifstream *file)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s != "G") return false;
+
+	bool usable = true;
+	unsigned int multsSize;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &multsSize, 10)) return false;
+	if (multsSize != sizeof(MULTIPLIERS))
+	{
+		cerr << "[rgat]Warning: Saved display buffers built by different version, regenerating" << endl;
+		usable = false;
+	}
+
+	MULTIPLIERS savedMults[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		getline(*file, value_s, ',');
+		string raw = base64_decode(value_s);
+		if (raw.size() == sizeof(MULTIPLIERS))
+			memcpy(&savedMults[i], raw.data(), sizeof(MULTIPLIERS));
+		else
+			usable = false;
+	}
+
+	pair<unsigned long, unsigned long> savedExtremes;
+	getline(*file, value_s, ',');
+	if (!caught_stoul(value_s, &savedExtremes.first, 10)) return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoul(value_s, &savedExtremes.second, 10)) return false;
+
+	LOADED_BUFFER buffers[5];
+	for (int i = 0; i < 5; ++i)
+		if (!loadFloatBuffer(file, &buffers[i])) return false;
+
+	unsigned int numEdges;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &numEdges, 10)) return false;
+	vector<pair<unsigned int, unsigned int>> edgeVerts;
+	for (unsigned int i = 0; i < numEdges; ++i)
+	{
+		pair<unsigned int, unsigned int> sizePos;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &sizePos.first, 10)) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &sizePos.second, 10)) return false;
+		edgeVerts.push_back(sizePos);
+	}
+
+	getline(*file, value_s, ',');
+	if (value_s != "}G") return false;
+
+	if (numEdges != edgeList.size() || buffers[0].verts > nodeList.size())
+		usable = false;
+	if (!usable) return true;
+
+	*m_scalefactors = savedMults[0];
+	*p_scalefactors = savedMults[1];
+	heatExtremes = savedExtremes;
+
+	EDGELIST::iterator edgeLIt = edgeList.begin();
+	for (unsigned int i = 0; edgeLIt != edgeList.end(); ++edgeLIt, ++i)
+	{
+		edge_data *e = &edgeDict.at(*edgeLIt);
+		e->vertSize = edgeVerts[i].first;
+		e->arraypos = edgeVerts[i].second;
+	}
+
+	//animation buffers are the main colours with everything faded out
+	vector<GLfloat> animNodeCol = buffers[0].col;
+	for (unsigned int i = 0; i < animNodeCol.size(); i += COLELEMS)
+		animNodeCol[i + AOFF] = ANIM_INACTIVE_NODE_ALPHA;
+	vector<GLfloat> animLineCol = buffers[1].col;
+	for (unsigned int i = 0; i < animLineCol.size(); i += COLELEMS)
+		animLineCol[i + AOFF] = ANIM_INACTIVE_EDGE_ALPHA;
+	vector<GLfloat> noPos;
+	animnodesdata->load_buffers(&noPos, &animNodeCol, buffers[0].verts, 0);
+	animlinedata->load_buffers(&noPos, &animLineCol, buffers[1].verts, 0);
+
+	mainnodesdata->load_buffers(&buffers[0].pos, &buffers[0].col, buffers[0].verts, buffers[0].edges);
+	mainlinedata->load_buffers(&buffers[1].pos, &buffers[1].col, buffers[1].verts, buffers[1].edges);
+	previewnodes->load_buffers(&buffers[2].pos, &buffers[2].col, buffers[2].verts, buffers[2].edges);
+	previewlines->load_buffers(&buffers[3].pos, &buffers[3].col, buffers[3].verts, buffers[3].edges);
+	//heatmap gets rendered again if its colours won't fit a palette
+	if (!heatmaplines->load_colours(&buffers[4].col, buffers[4].verts, buffers[4].edges))
+		cerr << "[rgat]WARNING: Saved heatmap of thread " << dec << tid << " has too many colours, discarding" << endl;
 	return true;
 }
 
@@ -1363,6 +1795,28 @@ bool thread_graph_data::loadCallSequence(ifstream *file)
 	return false;
 }
 
+bool thread_graph_data::loadEdgeCounts(ifstream *file)
+{
+	string endtag;
+	getline(*file, endtag, '{');
+	if (endtag.c_str()[0] != 'W') return false;
+
+	string value_s;
+	EDGELIST::iterator edgeLIt = edgeList.begin();
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}W") return edgeLIt == edgeList.end();
+		if (edgeLIt == edgeList.end()) break;
+
+		edge_data *e = get_edge(*edgeLIt++);
+		if (!caught_stoul(value_s, &e->executionCount, 10)) break;
+		getline(*file, value_s, ',');
+		e->countUncertain = (value_s == "1");
+	}
+	return false;
+}
+
 bool thread_graph_data::loadNodes(ifstream *file, map <MEM_ADDRESS, INSLIST> *disassembly)
 {
 
@@ -1377,6 +1831,11 @@ bool thread_graph_data::loadNodes(ifstream *file, map <MEM_ADDRESS, INSLIST> *di
 		int result = n->unserialise(file, disassembly);
 		if (result > 0)
 		{
+			if (n->blockInsCount)
+			{
+				blockNodes = true;
+				add_block_node(n->blockAddress, n->mutation, n->index);
+			}
 			insert_node(n->index, *n);
 			continue;
 		}
@@ -1420,8 +1879,10 @@ bool thread_graph_data::loadAnimationData(ifstream *file)
 	if (endtag.c_str()[0] != 'A') return false;
 
 	string sequence_s, size_s, mutation_s, loopstateIdx_s, loopstateIts_s;
-	pair<MEM_ADDRESS, int> seq_size;
+	MEM_ADDRESS blockAddr;
+	unsigned int insCount;
 	pair<unsigned int, unsigned long> loopstateIdx_Its;
+	unsigned int lastLoopIdx = 0;
 	BLOCK_IDENTIFIER blockID;
 
 	while (true)
@@ -1430,20 +1891,17 @@ bool thread_graph_data::loadAnimationData(ifstream *file)
 		if (sequence_s == "}A") 
 		{ 
 			//no trace data, assume graph was created in basic mode
-			if (bbsequence.empty())
+			if (blockSequence->empty())
 				basic = true;
 			return true; 
 		}
-		if (!caught_stoul(sequence_s, &seq_size.first, 10)) break;
+		if (!caught_stoul(sequence_s, &blockAddr, 10)) break;
 		getline(*file, size_s, ',');
-		if (!caught_stoi(size_s, &seq_size.second, 10)) break;
-		bbsequence.push_back(seq_size);
+		if (!caught_stoi(size_s, &insCount, 10)) break;
 
 		getline(*file, mutation_s, ',');
 		if (!caught_stoul(mutation_s, &blockID, 10)) break;
 
-		mutationSequence.push_back(blockID);
-
 		getline(*file, loopstateIdx_s, ',');
 		if (!caught_stoi(loopstateIdx_s, (int *)&loopstateIdx_Its.first, 10)) break;
 		if (loopstateIdx_Its.first)
@@ -1451,10 +1909,29 @@ bool thread_graph_data::loadAnimationData(ifstream *file)
 			getline(*file, loopstateIts_s, ',');
 			if (!caught_stoul(loopstateIts_s, &loopstateIdx_Its.second, 10)) break;
 		}
-		else
-			loopstateIdx_Its.second = 0xbad;
 
-		loopStateList.push_back(loopstateIdx_Its);
+		BLOCK_HANDLE handle = piddata->sequenceBlocks.get_handle(blockAddr, blockID, insCount);
+		if (loopstateIdx_Its.first)
+		{
+			if (loopstateIdx_Its.first != lastLoopIdx)
+				blockSequence->start_loop(loopstateIdx_Its.second);
+			blockSequence->add_loop_block(handle);
+		}
+		else
+			blockSequence->add_block(handle);
+		lastLoopIdx = loopstateIdx_Its.first;
 	}
 	return false;
+}
+
+//live graphs are indexed by the trace handler as blocks arrive
+void thread_graph_data::index_replay()
+{
+	unsigned long sequenceSize = blockSequence->size();
+	for (unsigned long seqIdx = replayIndex.size(); seqIdx < sequenceSize; ++seqIdx)
+	{
+		pair<unsigned int, unsigned long> loopState = blockSequence->loop_state(seqIdx);
+		replayIndex.add_entry(blockSequence->block(seqIdx).insCount, loopState.first,
+			loopState.first ? loopState.second : 1, get_last_node(seqIdx));
+	}
 }
\ No newline at end of file
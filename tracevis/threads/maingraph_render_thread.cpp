@@ -40,10 +40,11 @@ void maingraph_render_thread::performMainGraphRendering(thread_graph_data *graph
 	if (
 		(graph->get_mainnodes()->get_numVerts() < graph->get_num_nodes()) ||
 		(graph->get_mainlines()->get_renderedEdges() < graph->get_num_edges()) ||
-		clientState->rescale || clientState->activeGraph->vertResizeIndex)
+		clientState->rescale)
 	{
 		updateMainRender(graph);
 	}
+	render_lod_graph(graph, clientState);
 	
 	if (graph->basic)
 	{
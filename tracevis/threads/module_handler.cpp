@@ -112,6 +112,7 @@ void module_handler::main_loop()
 				
 				thread_graph_data *graph = new thread_graph_data(piddata, TID);
 				graph->basic = clientState->launchopts.basic;
+				graph->blockNodes = clientState->launchopts.blockNodes;
 
 				thread_trace_reader *TID_reader = new thread_trace_reader(graph, PID, TID);
 				TID_reader->traceBufMax = clientState->config->traceBufMax;
@@ -127,6 +128,7 @@ void module_handler::main_loop()
 				TID_processor->reader = TID_reader;
 				TID_processor->timelinebuilder = clientState->timelineBuilder;
 				TID_processor->basicMode = clientState->launchopts.basic;
+				TID_processor->blockMode = clientState->launchopts.blockNodes;
 				TID_processor->set_max_arg_storage(clientState->config->maxArgStorage);
 				TID_processor->saveFlag = &clientState->saving;
 
@@ -20,74 +20,93 @@ Header for the thread that renders graph conditional data
 #include "stdafx.h"
 #include "render_conditional_thread.h"
 #include "traceMisc.h"
+#include <algorithm>
 
+unsigned char conditional_renderer::condition_index(int condStatus)
+{
+	//jump only seen to succeed
+	if (condStatus & CONDTAKEN) return COND_PALETTE_SUCCEED;
+	//jump only seen to fail
+	if (condStatus & CONDFELLTHROUGH) return COND_PALETTE_FAIL;
+	//jump seen to both fail and succeed. added for completeness sake.
+	if (condStatus == CONDCOMPLETE) return COND_PALETTE_BOTH;
+	//ignore CONDPENDING, not worth dealing with
+	return COND_PALETTE_INVISIBLE;
+}
+
+static void countCondition(pair<unsigned long, unsigned long> *condCounts, int condStatus, bool add)
+{
+	unsigned long *count;
+	if (condStatus & CONDTAKEN)
+		count = &condCounts->first;
+	else if (condStatus & CONDFELLTHROUGH)
+		count = &condCounts->second;
+	else
+		return;
+
+	if (add) ++*count; else --*count;
+}
+
+//colours nodes drawn since the last pass and any the graph says have changed state
 bool conditional_renderer::render_graph_conditional(thread_graph_data *graph)
 {
 	GRAPH_DISPLAY_DATA *linedata = graph->get_mainlines();
 	if (!linedata || !linedata->get_numVerts()) return false;
 
-	GRAPH_DISPLAY_DATA *vertsdata = graph->get_mainnodes();
-	GRAPH_DISPLAY_DATA *conditionalNodes = graph->conditionalnodes;
+	PALETTE_LAYER *conditionalNodes = graph->conditionalnodes;
+	vector<int> *shownStates = &drawnStates[graph];
 	bool newDrawn = false;
-	int nodeIdx = 0;
-	int nodeEnd = graph->get_mainnodes()->get_numVerts();
-	conditionalNodes->reset();
-	if (nodeEnd)
+	unsigned int nodeEnd = graph->get_mainnodes()->get_numVerts();
+	graph->take_conditional_dirty(&dirtyNodes);
+
+	conditionalNodes->acquire_col();
+	conditionalNodes->set_colour(COND_PALETTE_INVISIBLE, invisibleCol);
+	conditionalNodes->set_colour(COND_PALETTE_FAIL, failOnlyCol);
+	conditionalNodes->set_colour(COND_PALETTE_SUCCEED, succeedOnlyCol);
+	conditionalNodes->set_colour(COND_PALETTE_BOTH, bothPathsCol);
+	vector<unsigned int>::iterator dirtyIt = dirtyNodes.begin();
+	for (; dirtyIt != dirtyNodes.end(); ++dirtyIt)
 	{
-		vector<float> *nodeCol = conditionalNodes->acquire_col();
-		if (nodeIdx < nodeEnd) newDrawn = true;
-		graph->condCounts = make_pair(0,0);
-		while (nodeIdx < nodeEnd)
-		{
-			conditionalNodes->set_numVerts(conditionalNodes->get_numVerts() + 1);
-
-			int condStatus = graph->get_node(nodeIdx++)->conditional;
-			if (!condStatus)
-			{
-				nodeCol->insert(nodeCol->end(), invisibleCol, end(invisibleCol));
-				continue;
-			}
-
-			//jump only seen to succeed
-			if (condStatus & CONDTAKEN)
-			{
-				nodeCol->insert(nodeCol->end(), succeedOnlyCol, end(succeedOnlyCol));
-				++graph->condCounts.first;
-			}
-
-			//jump only seen to fail
-			else if (condStatus & CONDFELLTHROUGH)
-			{
-				nodeCol->insert(nodeCol->end(), failOnlyCol, end(failOnlyCol));
-				++graph->condCounts.second;
-			}
-
-			//jump seen to both fail and succeed. added for completeness sake.
-			else if (condStatus == CONDCOMPLETE)
-				nodeCol->insert(nodeCol->end(), bothPathsCol, end(bothPathsCol));
+		//not drawn yet, will get its current state when it is
+		if (*dirtyIt >= shownStates->size()) continue;
+
+		int condStatus = graph->get_node(*dirtyIt)->conditional;
+		int *shownStatus = &shownStates->at(*dirtyIt);
+		if (condStatus == *shownStatus) continue;
+
+		conditionalNodes->fill(*dirtyIt, 1, condition_index(condStatus));
+		countCondition(&graph->condCounts, *shownStatus, false);
+		countCondition(&graph->condCounts, condStatus, true);
+		*shownStatus = condStatus;
+		newDrawn = true;
+	}
 
-			//ignore CONDPENDING for this iteration, not worth dealing with
-			continue;
-			
-		}
+	while (shownStates->size() < nodeEnd)
+	{
+		int condStatus = graph->get_node(shownStates->size())->conditional;
+		conditionalNodes->append(condition_index(condStatus), 1);
+		countCondition(&graph->condCounts, condStatus, true);
+		shownStates->push_back(condStatus);
+		newDrawn = true;
 	}
+	if (newDrawn)
+		conditionalNodes->set_numVerts(shownStates->size());
 	conditionalNodes->release_col();
 
 	int condLineverts = graph->conditionallines->get_numVerts();
 	int mainLineverts = graph->get_mainlines()->get_numVerts();
 	if (mainLineverts > condLineverts)
 	{
-		//tempted to make rgba all the same and just call resize
+		//every edge is the same colour
 		const ALLEGRO_COLOR *edgeColour = &clientState->config->conditional.edgeColor;
 		float edgeColArr[4] = { edgeColour->r, edgeColour->g, edgeColour->b, edgeColour->a };
 
-		vector<float> *edgecol = graph->conditionallines->acquire_col();
-		
-		while (condLineverts++ < mainLineverts)
-			edgecol->insert(edgecol->end(), edgeColArr, end(edgeColArr));
-
-		graph->conditionallines->set_numVerts(condLineverts);
+		graph->conditionallines->acquire_col();
+		graph->conditionallines->set_colour(0, edgeColArr);
+		graph->conditionallines->append(0, mainLineverts - condLineverts);
+		graph->conditionallines->set_numVerts(mainLineverts);
 		graph->conditionallines->release_col();
+		newDrawn = true;
 
 	}
 	if (newDrawn) graph->needVBOReload_conditional = true;
@@ -98,11 +117,8 @@ bool conditional_renderer::render_graph_conditional(thread_graph_data *graph)
 		return false;
 }
 
-//thread handler to build graph for each thread
-//allows display in thumbnail style format
-void conditional_renderer::main_loop()
+void conditional_renderer::load_colours()
 {
-	alive = true;
 	invisibleCol[0] = 0;
 	invisibleCol[1] = 0;
 	invisibleCol[2] = 0;
@@ -125,6 +141,21 @@ void conditional_renderer::main_loop()
 	bothPathsCol[1] = bothPaths->g;
 	bothPathsCol[2] = bothPaths->b;
 	bothPathsCol[3] = bothPaths->a;
+}
+
+//headless rendering of a finished graph
+bool conditional_renderer::render_once(thread_graph_data *graph)
+{
+	load_colours();
+	return render_graph_conditional(graph);
+}
+
+//thread handler to build graph for each thread
+//allows display in thumbnail style format
+void conditional_renderer::main_loop()
+{
+	alive = true;
+	load_colours();
 
 	while ((!piddata || piddata->graphs.empty()) && !die)
 	{
@@ -21,6 +21,64 @@ The thread that performs low (ie:periodic) performance rendering of all graphs f
 #include "render_heatmap_thread.h"
 #include "traceMisc.h"
 #include "rendering.h"
+#include "heat_solver.h"
+#include <algorithm>
+
+//node executions in the graph's heat window, from the running block totals
+//returns false if the graph has no window
+bool heatmap_renderer::build_window_heat(thread_graph_data *graph)
+{
+	pair<unsigned long, unsigned long> window = graph->get_heat_window();
+	graph->heatWindowChanged = false;
+	windowExecs.clear();
+	if (!window.second) return false;
+
+	graph->heatWindowCounts.index(graph->blockSequence);
+	map<BLOCK_HANDLE, unsigned long> blockCounts;
+	graph->heatWindowCounts.window_counts(graph->blockSequence, window.first, window.second, &blockCounts);
+
+	PROCESS_DATA *graphPiddata = graph->get_piddata();
+	windowExecs.resize(graph->get_num_nodes(), 0);
+	map<BLOCK_HANDLE, unsigned long>::iterator countIt = blockCounts.begin();
+	for (; countIt != blockCounts.end(); ++countIt)
+	{
+		const SEQUENCE_BLOCK &block = graphPiddata->sequenceBlocks.resolve(countIt->first);
+		if (graph->blockNodes)
+		{
+			//one node per block, found by the block rather than its instructions
+			unsigned int blockNode;
+			if (graph->find_block_node(block.address, block.blockID, &blockNode) && blockNode < windowExecs.size())
+				windowExecs[blockNode] += countIt->second;
+			continue;
+		}
+
+		INSLIST *inslist = getDisassemblyBlock(block.address, block.blockID, graphPiddata, &die);
+		if (!inslist) continue;
+
+		graphPiddata->getDisassemblyReadLock();
+		for (unsigned int blockIdx = 0; blockIdx < block.insCount && blockIdx < inslist->size(); ++blockIdx)
+		{
+			unordered_map<PID_TID, int>::iterator vertIt = inslist->at(blockIdx)->threadvertIdx.find(graph->tid);
+			if (vertIt != inslist->at(blockIdx)->threadvertIdx.end() && vertIt->second < windowExecs.size())
+				windowExecs[vertIt->second] += countIt->second;
+		}
+		graphPiddata->dropDisassemblyReadLock();
+	}
+
+	//externs aren't in the sequence, credit them with the runs of the nodes calling them
+	graph->acquireNodeReadLock();
+	for (unsigned int nodeIdx = 0; nodeIdx < windowExecs.size(); ++nodeIdx)
+	{
+		node_data *n = graph->locked_get_node(nodeIdx);
+		if (!n->external) continue;
+		set<unsigned int>::iterator callerIt = n->incomingNeighbours.begin();
+		for (; callerIt != n->incomingNeighbours.end(); ++callerIt)
+			if (*callerIt < windowExecs.size())
+				windowExecs[nodeIdx] += windowExecs[*callerIt];
+	}
+	graph->releaseNodeReadLock();
+	return true;
+}
 
 bool heatmap_renderer::render_graph_heatmap(thread_graph_data *graph, bool verbose)
 {
@@ -41,334 +99,216 @@ bool heatmap_renderer::render_graph_heatmap(thread_graph_data *graph, bool verbo
 	} 
 	else return false; 
 
-	DWORD this_run_marker = GetTickCount();
+	//executions of each node, from the whole trace or the heat window
+	unsigned int numNodes = graph->get_num_nodes();
+	vector<unsigned long> nodeHeat;
+	bool windowed = build_window_heat(graph);
+	if (windowed)
+	{
+		nodeHeat.swap(windowExecs);
+		nodeHeat.resize(numNodes, 0);
+	}
+	else
+	{
+		nodeHeat.resize(numNodes);
+		graph->acquireNodeReadLock();
+		for (unsigned int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+			nodeHeat[nodeIdx] = graph->locked_get_node(nodeIdx)->executionCount;
+		graph->releaseNodeReadLock();
+	}
 
-	//build set of all heat values
-	std::set<unsigned long> heatValues;
+	//snapshot the edges so the solver runs without holding graph locks
+	//edges the trace handler counted are exact for the whole trace, the solver only fills in the rest
+	bool useCounts = !windowed && graph->edgeCounts;
+	unsigned long unknownEdges = 0;
+	heat_solver solver(&nodeHeat);
+	vector<edge_data *> solverEdges;
 	EDGEMAP::iterator edgeDit, edgeDEnd;
-
-	vector<pair<NODEPAIR,edge_data *>> unfinishedEdgeList;
-	vector<edge_data *> finishedEdgeList;
-
-	unsigned int solverErrors = 0;
 	graph->start_edgeD_iteration(&edgeDit, &edgeDEnd);
 	for (; edgeDit != edgeDEnd; ++edgeDit)
 	{
-		node_data *snode = graph->get_node(edgeDit->first.first);
-		node_data *tnode = graph->get_node(edgeDit->first.second);
-		edge_data *edge = &edgeDit->second;
-
-		//initialise temporary counters
-		if (snode->heat_run_marker != this_run_marker)
-		{
-			snode->chain_remaining_in = snode->executionCount;
-			snode->chain_remaining_out = snode->executionCount;
-			snode->heat_run_marker = this_run_marker;
-		}
-		if (tnode->heat_run_marker != this_run_marker)
-		{
-			tnode->chain_remaining_in = tnode->executionCount;
-			tnode->chain_remaining_out = tnode->executionCount;
-			tnode->heat_run_marker = this_run_marker;
-		}
-
-		//the easiest edges to work out are the most numerous
-		//this node is only followed by 1 node therefore edge weight is this nodes executions
-		if (snode->outgoingNeighbours.size() == 1)
-		{
-			edge->chainedWeight = snode->executionCount;
-			snode->chain_remaining_out = 0;
-			//does instruction execute more times than the only instruction that follows it?
-			if (snode->executionCount > tnode->chain_remaining_in)
-			{
-				//ignore if the instruction was the last in the thread and the difference is 1
-				if ((snode->index != graph->finalNodeID) && (snode->executionCount != (tnode->chain_remaining_in + 1)))
-				{
-					++solverErrors;
-					if (verbose)
-						cerr << "[rgat]Heat solver warning 1: (TID" << dec << graph->tid << "): Sourcenode:" << snode->index << 
-						" (only 1 target) has " << snode->executionCount <<	" output but targnode " << tnode->index <<
-						" only needs " << tnode->chain_remaining_in << endl;
-				}
-			}
-			tnode->chain_remaining_in -= snode->executionCount;
-			finishedEdgeList.push_back(edge);
-		}
-		else if (tnode->incomingNeighbours.size() == 1)
-		{
-			//this node only follows one other node therefore edge weight is its executions
-			edge->chainedWeight = tnode->executionCount;
-			tnode->chain_remaining_in = 0;
-			//this instruction executed more than the only instruction that leads to it?
-			if (tnode->executionCount > snode->chain_remaining_out)
-			{
-				++solverErrors;
-				if (verbose)
-					cerr << "[rgat]Heat solver warning 2: (TID" << dec << graph->tid << "): Targnode:" << tnode->index << " (only only 1 caller) needs " << tnode->executionCount <<
-					" in but sourcenode: " << snode->index << " only provides " << snode->chain_remaining_out << " out\n" << endl;
-			}
-			snode->chain_remaining_out -= tnode->executionCount;
-			finishedEdgeList.push_back(edge);
-		}
+		edgeDit->second.chainedWeight = 0;
+		//added after the node counts were taken
+		if (edgeDit->first.first >= numNodes || edgeDit->first.second >= numNodes) continue;
+		if (useCounts && !edgeDit->second.countUncertain)
+			solver.add_counted_edge(edgeDit->first.first, edgeDit->first.second, edgeDit->second.executionCount);
 		else
 		{
-			edge->chainedWeight = 0;
-			unfinishedEdgeList.push_back(make_pair(edgeDit->first, &edgeDit->second));
+			solver.add_edge(edgeDit->first.first, edgeDit->first.second);
+			++unknownEdges;
 		}
+		solverEdges.push_back(&edgeDit->second);
 	}
 	graph->stop_edgeD_iteration();
 
-	//this won't work until nodes have correct values
-	//it's a great way of detecting errors in a compelete graph but in a running graph there are always going
-	//to be discrepancies. still want to have a vaguely accurate heatmap in realtime though
-	int attemptLimit = 5;
-	vector<pair<NODEPAIR, edge_data *>>::iterator unfinishedIt;
-	while (!unfinishedEdgeList.empty() && attemptLimit--)
-	{
-		unfinishedIt = unfinishedEdgeList.begin();
-		for (; unfinishedIt != unfinishedEdgeList.end(); ++unfinishedIt)
-		{
-			unsigned int srcNodeIdx = unfinishedIt->first.first;
-			unsigned int targNodeIdx = unfinishedIt->first.second;
-			
-
-			//see if targets other inputs have remaining output
-			unsigned long targOtherNeighboursOut = 0;
-
-			graph->acquireNodeReadLock();
-			node_data *tnode = graph->locked_get_node(targNodeIdx);
-			node_data *snode = graph->locked_get_node(srcNodeIdx);
-
-			set<unsigned int>::iterator targincomingIt = tnode->incomingNeighbours.begin();
-			for (; targincomingIt != tnode->incomingNeighbours.end(); targincomingIt++)
-			{
-				unsigned int idx = *targincomingIt;
-				if (idx == srcNodeIdx) continue; 
-				node_data *neib = graph->locked_get_node(idx);
-				targOtherNeighboursOut += neib->chain_remaining_out;
-			}
-			
-			//no? only source node giving input. complete edge and subtract from source output 
-			if (targOtherNeighboursOut == 0)
-			{
-				//only node with executions remaining has less executions than this node?
-				if (tnode->chain_remaining_in > snode->chain_remaining_out)
-				{
-					++solverErrors;
-					if (verbose)
-						cerr << "[rgat]Heat solver warning 3: (TID" << dec << graph->tid << "): Targnode  " << tnode->index <<
-						" has only one adjacent providing output, but needs more " << tnode->chain_remaining_in << "than snode(" << snode->index <<
-						") provides(" << snode->chain_remaining_out << ")" << endl;
-				}
-				else
-				{
-					edge_data *edge = unfinishedIt->second;
-					edge->chainedWeight = tnode->chain_remaining_in;
-					tnode->chain_remaining_in = 0;
-					snode->chain_remaining_out -= edge->chainedWeight;
-
-					finishedEdgeList.push_back(edge);
-					unfinishedIt = unfinishedEdgeList.erase(unfinishedIt);
-					attemptLimit++;
-					graph->releaseNodeReadLock();
-					break;
-				}
-			}
-			graph->releaseNodeReadLock();
-
-			//see if other source outputs need input
-			unsigned long sourceOtherNeighboursIn = 0;
-
-			graph->acquireNodeReadLock();
-			set<unsigned int>::iterator sourceoutgoingIt = snode->outgoingNeighbours.begin();
-			for (; sourceoutgoingIt != snode->outgoingNeighbours.end(); sourceoutgoingIt++)
-			{
-				unsigned int idx = *sourceoutgoingIt;
-				if (idx == tnode->index) continue;
-				node_data *neib = graph->locked_get_node(idx);
-				sourceOtherNeighboursIn += neib->chain_remaining_in;
-			}
-			graph->releaseNodeReadLock();
+	//with nothing to work out the solver is just a consistency check of the counts
+	//threads start at node 0
+	if (unknownEdges || verbose)
+		solver.solve(0, graph->finalNodeID);
 
-			//no? only targ edge taking input. complete edge and subtract from targ input 
-			if (sourceOtherNeighboursIn == 0)
-			{
-				//only remaining node accepting executions has less than this node remaining
-				if (snode->chain_remaining_out > tnode->chain_remaining_in)
-				{
-					++solverErrors;
-					if (verbose)
-						cerr << "[rgat]Heat solver warning 4: (TID" << dec << graph->tid << ") : Sourcenode " << snode->index << " has one adjacent taking input, but has more (" <<
-						snode->chain_remaining_out << ") than the targnode(" << tnode->index << ") needs(" << tnode->chain_remaining_in << endl;
-				}
-				else
-				{
-					edge_data *edge = unfinishedIt->second;
-					edge->chainedWeight = snode->chain_remaining_out;
-					snode->chain_remaining_out = 0;
-					tnode->chain_remaining_in -= edge->chainedWeight;
-
-					finishedEdgeList.push_back(edge);
-					unfinishedIt = unfinishedEdgeList.erase(unfinishedIt);
-					++attemptLimit;
-					break;
-				}
-			}	
-		}
+	//distinct solved weights in ascending order, an edge's colour comes from the rank of its weight
+	heatValues.clear();
+	for (unsigned long edgeIdx = 0; edgeIdx < solver.edges.size(); ++edgeIdx)
+	{
+		if (!solver.edges[edgeIdx].solved) continue;
+		solverEdges[edgeIdx]->chainedWeight = solver.edges[edgeIdx].weight;
+		heatValues.push_back(solver.edges[edgeIdx].weight);
 	}
-
+	if (heatValues.empty()) heatValues.push_back(0);
+	std::sort(heatValues.begin(), heatValues.end());
+	heatValues.erase(std::unique(heatValues.begin(), heatValues.end()), heatValues.end());
 
 	if (verbose)
 	{
-		/*
-		if (attemptLimit <= 0)
-		{
-			cout << "[rgat]Heatmap Failure: ending solver with " << unfinishedEdgeList.size() << " edges unsolved (green)\n";
-
-			unfinishedIt = unfinishedEdgeList.begin();
-			for (; unfinishedIt != unfinishedEdgeList.end(); ++unfinishedIt)
-			{
-				graph->acquireNodeReadLock();
-				node_data *snode = graph->get_node(unfinishedIt->first.first);
-				node_data *tnode = graph->get_node(unfinishedIt->first.second);
-
-				printf("edge %d->%d\n", snode->index, tnode->index);
-
-				printf("\t%d -> [remout:%d (%d neighbours needing in:", snode->index, snode->chain_remaining_out, snode->outgoingNeighbours.size());
-				
-				set<unsigned int>::iterator neibIt = snode->outgoingNeighbours.begin();;
-				for (; neibIt != snode->outgoingNeighbours.end(); ++neibIt)
-				{
-					node_data *neib = graph->locked_get_node(*neibIt);
-					if (neib->chain_remaining_in)
-						printf("%d:%d,", *neibIt, neib->chain_remaining_in);
-				}
-				printf(")]\n");
-
-				printf("\t%d -> [remin:%d (%d neibs remout:", tnode->index, tnode->chain_remaining_in, tnode->incomingNeighbours.size());
-
-				neibIt = tnode->incomingNeighbours.begin();
-				for (; neibIt != tnode->incomingNeighbours.end(); ++neibIt)
-				{
-					node_data *neib = graph->locked_get_node(*neibIt);
-					if (neib->chain_remaining_out)
-						printf("%d:%d,", *neibIt, neib->chain_remaining_out);
-				}
-				graph->releaseNodeReadLock();
-				printf(")]\n");
-			}
-		}
-		*/
-		if (!unfinishedEdgeList.empty() || solverErrors)
+		vector<HEAT_RESIDUAL>::iterator residualIt = solver.residuals.begin();
+		for (; residualIt != solver.residuals.end(); ++residualIt)
+			cerr << "[rgat]Heat solver warning: (TID" << dec << graph->tid << "): Node " << residualIt->node <<
+			" has " << residualIt->inResidual << " executions in and " << residualIt->outResidual <<
+			" out not accounted for by its edges" << endl;
+
+		unsigned long unsolvedEdges = solver.edges.size() - solver.solvedEdges;
+		if (unsolvedEdges || !solver.residuals.empty())
 			cout << "[rgat]Heatmap Failure for thread " << dec << graph->tid << ": Ending solver with "<<
-			unfinishedEdgeList.size() << " unsolved / " << dec << solverErrors <<" errors. Trace may have inaccuracies (eg: due to unexpected termination)." << endl;
+			unsolvedEdges << " unsolved / " << dec << solver.residuals.size() <<" errors. Trace may have inaccuracies (eg: due to unexpected termination)." << endl;
 		else
-			cout << "[rgat]Heatmap Success for thread " << dec << graph->tid << ": Ending solver with "<< finishedEdgeList.size() <<" solved edges. Trace likely accurate."<<endl;
+			cout << "[rgat]Heatmap Success for thread " << dec << graph->tid << ": Ending solver with "<< solver.solvedEdges <<" solved edges. Trace likely accurate."<<endl;
 	}
 
-	//build set of all heat values
-	vector<edge_data *>::iterator finishedEdgeIt;
-	for (finishedEdgeIt = finishedEdgeList.begin(); finishedEdgeIt != finishedEdgeList.end(); ++finishedEdgeIt)
-		heatValues.insert(((edge_data *)*finishedEdgeIt)->chainedWeight);
-
-	int heatrange = heatValues.size();
-
-	//create map of distances of each value in set
-	map<unsigned long, int> heatDistances;
-	set<unsigned long>::iterator setit;
-	int distance = 0;
-	for (setit = heatValues.begin(); setit != heatValues.end(); ++setit)
-		heatDistances[*setit] = distance++;
-	graph->heatExtremes = make_pair(*heatValues.begin(),*heatValues.rbegin());
+	graph->heatExtremes = make_pair(heatValues.front(), heatValues.back());
 
-	int maxDist = heatDistances.size();
-	map<unsigned long, int>::iterator distit = heatDistances.begin();
-	map<unsigned long, COLSTRUCT> heatColours;
-	
-	//create blue->red value for each numerical 'heat'
-	int numColours = colourRange.size();
-	heatColours[heatDistances.begin()->first] = *colourRange.begin();
-	if (maxDist > 1)
+	//weights and vertex offsets of the rendered edges, in the order of the line buffer
+	unsigned int edgeEnd = graph->get_mainlines()->get_renderedEdges();
+	edgeHeats.clear();
+	edgeVertStarts.clear();
+	unsigned int totalVerts = 0;
+	for (unsigned int edgeindex = 0; edgeindex < edgeEnd; ++edgeindex)
 	{
-		for (std::advance(distit, 1); distit != heatDistances.end(); distit++)
-		{
-			float distratio = (float)distit->second / (float)maxDist;
-			int colourIndex = min(numColours-1, floor(numColours*distratio));
-			heatColours[distit->first] = colourRange.at(colourIndex);
+		edge_data *edge = graph->get_edge(edgeindex);
+		if (!edge) {
+			cerr << "[rgat]WARNING: Heatmap2 edge skip"<<endl;
+			continue;
 		}
+		assert(edge->vertSize);
+		edgeHeats.push_back(edge->chainedWeight);
+		edgeVertStarts.push_back(totalVerts);
+		totalVerts += edge->vertSize;
 	}
+	edgeVertStarts.push_back(totalVerts);
 
-	unsigned long lastColour = heatDistances.rbegin()->first;
-	if (heatColours.size() > 1)
-		heatColours[lastColour] = *colourRange.rbegin();
-	
-	graph->heatmaplines->reset();
-
-	//finally build a colours buffer using the heat/colour map entry for each edge weight
-	vector <float> *lineVector = graph->heatmaplines->acquire_col();
-	unsigned int edgeindex = 0;
-	unsigned int edgeEnd = graph->get_mainlines()->get_renderedEdges();
-	EDGELIST* edgelist = graph->edgeLptr();
-
+	//blue->red by rank: lowest weight takes the first colour, highest the last
 	COLSTRUCT debuggingUnfin;
 	debuggingUnfin.a = 1;
 	debuggingUnfin.b = 0;
 	debuggingUnfin.g = 1;
 	debuggingUnfin.r = 0;
 
-	for (; edgeindex < edgeEnd; ++edgeindex)
+	unsigned int numColours = colourRange.size();
+	unsigned long maxDist = heatValues.size();
+
+	//first weight of each band, for edges that change before the range does
+	HEAT_BINNING *binning = &binnings[graph];
+	binning->exact = useCounts && !unknownEdges;
+	binning->binnedEdges = edgeHeats.size();
+	binning->recolouredEdges = 0;
+	binning->cuts.clear();
+	for (unsigned int colourIndex = 1; colourIndex < numColours; ++colourIndex)
 	{
-		edge_data *edge = graph->get_edge(edgeindex);
-		if (!edge) {
-			cerr << "[rgat]WARNING: Heatmap2 edge skip"<<endl;
-			continue;
+		unsigned long firstRank = (colourIndex * maxDist + numColours - 1) / numColours;
+		binning->cuts.push_back(firstRank < maxDist ? heatValues.at(firstRank) : numeric_limits<unsigned long>::max());
+	}
+
+	//indices are built here and swapped into the layer at the end, it is never seen half written
+	heatIndices.resize(totalVerts);
+	for (unsigned long edgeIdx = 0; edgeIdx < edgeHeats.size(); ++edgeIdx)
+	{
+		unsigned int colourIndex;
+		vector<unsigned long>::iterator heatIt = std::lower_bound(heatValues.begin(), heatValues.end(), edgeHeats[edgeIdx]);
+		//this edge has a new value since we recalculated the heats
+		if (heatIt == heatValues.end() || *heatIt != edgeHeats[edgeIdx])
+			colourIndex = numColours;
+		else
+		{
+			unsigned long rank = heatIt - heatValues.begin();
+			colourIndex = min(numColours - 1, (unsigned int)((numColours * rank) / maxDist));
+			if (rank && rank == maxDist - 1)
+				colourIndex = numColours - 1;
 		}
+		std::fill(heatIndices.begin() + edgeVertStarts[edgeIdx], heatIndices.begin() + edgeVertStarts[edgeIdx + 1], colourIndex);
+	}
 
-		COLSTRUCT *edgeColour = 0;
-		//map<unsigned long, COLSTRUCT>::iterator foundHeatColour = heatColours.find(edge->weight);
-		map<unsigned long, COLSTRUCT>::iterator foundHeatColour = heatColours.find(edge->chainedWeight);
+	//palette is the range with the debugging colour on the end
+	PALETTE_LAYER *heatLayer = graph->heatmaplines;
+	heatLayer->acquire_col();
+	for (unsigned int colourIndex = 0; colourIndex < numColours; ++colourIndex)
+	{
+		const COLSTRUCT *rangeColour = &colourRange.at(colourIndex);
+		float rangeColArr[COLELEMS] = { rangeColour->r, rangeColour->g, rangeColour->b, rangeColour->a };
+		heatLayer->set_colour(colourIndex, rangeColArr);
+	}
+	float debuggingColArr[COLELEMS] = { debuggingUnfin.r, debuggingUnfin.g, debuggingUnfin.b, debuggingUnfin.a };
+	heatLayer->set_colour(numColours, debuggingColArr);
+	heatLayer->replace(&heatIndices, edgeHeats.size());
+	heatLayer->release_col();
+	graph->needVBOReload_heatmap = true;
+	
+	return true;
+}
 
-		//this edge has a new value since we recalculated the heats, this finds the nearest
-		if (foundHeatColour == heatColours.end())
-		{
+static unsigned int binned_colour(HEAT_BINNING *binning, pair<unsigned long, unsigned long> *extremes,
+	unsigned int numColours, unsigned long weight)
+{
+	unsigned int colourIndex = std::upper_bound(binning->cuts.begin(), binning->cuts.end(), weight) - binning->cuts.begin();
+	if (weight == extremes->second && extremes->first != extremes->second)
+		colourIndex = numColours - 1;
+	return colourIndex;
+}
 
-			edgeColour = &debuggingUnfin;
-			/*
-			unsigned long searchWeight = edge->weight;
-			map<unsigned long, COLSTRUCT>::iterator previousHeatColour = foundHeatColour;
-			for (foundHeatColour = heatColours.begin(); foundHeatColour != heatColours.end(); ++foundHeatColour)
-			{
-				if (foundHeatColour->first > searchWeight && previousHeatColour->first < searchWeight)
-				{
-					edgeColour = &foundHeatColour->second;
-					break;
-				}
-				previousHeatColour = foundHeatColour;
-			}
-			if (foundHeatColour == heatColours.end())
-				edgeColour = &heatColours.rbegin()->second;
-			//record it so any others with this weight are found
-			heatColours[searchWeight] = *edgeColour;
-			*/
-		}
-		else
-			edgeColour = &foundHeatColour->second;
+//recolours edges whose counts changed without touching the rest
+//the bands are the last full render's, so these colours are only close to what a full render would give.
+//fails if the graph needs a full render: a solve is needed, the range of weights moved, an edge
+//changed band (which moves the other bands) or too many edges have changed since the bands were made
+bool heatmap_renderer::update_graph_heatmap(thread_graph_data *graph)
+{
+	HEAT_BINNING *binning = &binnings[graph];
+	if (!binning->exact) return false;
 
-		float edgeColArr[4] = { edgeColour->r, edgeColour->g, edgeColour->b, edgeColour->a};
+	unsigned int numColours = colourRange.size();
+	vector<pair<edge_data *, unsigned int>> recoloured;
+	vector<NODEPAIR>::iterator dirtyIt = dirtyEdges.begin();
+	for (; dirtyIt != dirtyEdges.end(); ++dirtyIt)
+	{
+		edge_data *edge = graph->get_edge(*dirtyIt);
+		if (!edge || !edge->vertSize) continue;
+		if (edge->countUncertain) return false;
 
-		//finally draw the heatmap
-		unsigned int vertIdx = 0;
-		assert(edge->vertSize);
-		for (; vertIdx < edge->vertSize; ++vertIdx)
-			lineVector->insert(lineVector->end(), edgeColArr, end(edgeColArr));
+		unsigned long weight = edge->executionCount;
+		if (weight < graph->heatExtremes.first || weight > graph->heatExtremes.second) return false;
 
-		graph->heatmaplines->inc_edgesRendered();
-		graph->heatmaplines->set_numVerts(graph->heatmaplines->get_numVerts() + vertIdx);
+		unsigned int colourIndex = binned_colour(binning, &graph->heatExtremes, numColours, weight);
+		if (colourIndex != binned_colour(binning, &graph->heatExtremes, numColours, edge->chainedWeight))
+			return false;
+		recoloured.push_back(make_pair(edge, colourIndex));
 	}
 
+	binning->recolouredEdges += recoloured.size();
+	if (binning->recolouredEdges > binning->binnedEdges * HEAT_REBIN_FRACTION) return false;
+
+	graph->heatmaplines->acquire_col();
+	const unsigned long writtenVerts = graph->heatmaplines->count();
+	vector<pair<edge_data *, unsigned int>>::iterator recolIt = recoloured.begin();
+	for (; recolIt != recoloured.end(); ++recolIt)
+	{
+		edge_data *edge = recolIt->first;
+		unsigned long firstVert = edge->arraypos / COLELEMS;
+		if (firstVert + edge->vertSize > writtenVerts) continue;
+
+		graph->heatmaplines->fill(firstVert, edge->vertSize, recolIt->second);
+		edge->chainedWeight = edge->executionCount;
+	}
 	graph->heatmaplines->release_col();
-	graph->needVBOReload_heatmap = true;
-	
+
+	if (!recoloured.empty())
+		graph->needVBOReload_heatmap = true;
 	return true;
 }
 
@@ -389,14 +329,27 @@ COLSTRUCT *col_to_colstruct(ALLEGRO_COLOR *c)
 	return cs;
 }
 
+//add our heatmap colours to a vector for lookup in render thread
+void heatmap_renderer::load_colours()
+{
+	if (!colourRange.empty()) return;
+	for (int i = 0; i < 10; i++)
+		colourRange.insert(colourRange.begin(), *col_to_colstruct(&clientState->config->heatmap.edgeFrequencyCol[i]));
+}
+
+//headless rendering of a finished graph
+bool heatmap_renderer::render_once(thread_graph_data *graph)
+{
+	load_colours();
+	return render_graph_heatmap(graph, false);
+}
+
 //thread handler to build graph for each thread
 //allows display in thumbnail style format
 void heatmap_renderer::main_loop()
 {
 	alive = true;
-	//add our heatmap colours to a vector for lookup in render thread
-	for (int i = 0; i < 10; i++)
-		colourRange.insert(colourRange.begin(), *col_to_colstruct(&clientState->config->heatmap.edgeFrequencyCol[i]));
+	load_colours();
 
 	while ((!piddata || piddata->graphs.empty()) && !die)
 		Sleep(100);
@@ -421,18 +374,25 @@ void heatmap_renderer::main_loop()
 		while (graphlistIt != graphlist.end() && !die)
 		{
 			thread_graph_data *graph = *graphlistIt++;
-			//always rerender an active graph (edge executions may have increased without adding new edges)
-			//render saved graphs if there are new edges
-			if (graph->active || graph->get_num_edges() > graph->heatmaplines->get_renderedEdges())
+			//rerender if there are new edges or the heat window moved
+			//otherwise only look at edges the trace handler says have been executed since last time
+			graph->take_heat_dirty(&dirtyEdges);
+			if (graph->heatWindowChanged || 
+				graph->get_num_edges() > graph->heatmaplines->get_renderedEdges())
 			{
 				render_graph_heatmap(graph, false);
 			}
-			else //last mop-up rendering of a recently finished graph
-				if (!finishedGraphs[graph])
-				{
-					finishedGraphs[graph] = true;
-					render_graph_heatmap(graph, true);
-				}
+			else if (!dirtyEdges.empty())
+			{
+				if (!update_graph_heatmap(graph))
+					render_graph_heatmap(graph, false);
+			}
+			else if (!graph->active && !finishedGraphs[graph])
+			{
+				//last mop-up rendering of a recently finished graph
+				finishedGraphs[graph] = true;
+				render_graph_heatmap(graph, true);
+			}
 
 			Sleep(20); //pause between graphs so other things don't struggle for mutex time
 		}
@@ -24,6 +24,36 @@ The thread that performs low (ie:periodic) performance rendering of all graphs f
 #include "traceMisc.h"
 #include "rendering.h"
 
+//graphs get at least edgesPerRender so small graphs finish, until the budget runs out
+//the graph served first moves round each update so the minimum shares aren't always taken by the same graphs
+void preview_renderer::render_share(vector<pair<thread_graph_data *, unsigned long>> *backlogs, unsigned long *budget)
+{
+	if (backlogs->empty()) return;
+
+	double totalBacklog = 0;
+	vector<pair<thread_graph_data *, unsigned long>>::iterator backlogIt = backlogs->begin();
+	for (; backlogIt != backlogs->end(); ++backlogIt)
+		totalBacklog += backlogIt->second;
+
+	const unsigned long minShare = clientState->config->preview.edgesPerRender;
+	const unsigned long tickBudget = *budget;
+	const size_t firstGraph = shareRotation++ % backlogs->size();
+	for (size_t graphNum = 0; graphNum < backlogs->size(); ++graphNum)
+	{
+		if (die) return;
+		pair<thread_graph_data *, unsigned long> *backlog = &backlogs->at((firstGraph + graphNum) % backlogs->size());
+
+		unsigned long share = 0;
+		if (totalBacklog)
+			share = (unsigned long)(tickBudget * (backlog->second / totalBacklog));
+		share = min(min(backlog->second, max(share, minShare)), *budget);
+
+		//with the budget gone this only draws new nodes, which aren't counted against it
+		render_preview_graph(backlog->first, clientState, share);
+		*budget -= share;
+	}
+}
+
 //thread handler to build graph for each thread
 //allows display in thumbnail style format
 void preview_renderer::main_loop()
@@ -34,9 +64,10 @@ void preview_renderer::main_loop()
 		Sleep(200);
 
 	const int outerDelay = clientState->config->preview.processDelay;
-	const int innerDelay = clientState->config->preview.threadDelay;
 	vector<thread_graph_data *> graphlist;
 	map <PID_TID, void *>::iterator graphIt;
+	//graphs with nodes or edges waiting to be rendered, and how many edges
+	vector<pair<thread_graph_data *, unsigned long>> visibleBacklogs, hiddenBacklogs;
 
 	int dietimer = -1;
 	
@@ -57,19 +88,29 @@ void preview_renderer::main_loop()
 		dropMutex(piddata->graphsListMutex);
 
 		vector<thread_graph_data *>::iterator graphlistIt = graphlist.begin();
-		while (graphlistIt != graphlist.end())
+		for (; graphlistIt != graphlist.end(); ++graphlistIt)
 		{
 			thread_graph_data *graph = *graphlistIt;
-			if ((graph->previewnodes->get_numVerts() < graph->get_num_nodes()) ||
-				(graph->previewlines->get_renderedEdges() < graph->get_num_edges()))
-				render_preview_graph(graph, clientState);
+			unsigned long renderedEdges = graph->previewlines->get_renderedEdges();
+			unsigned long edgeBacklog = graph->get_num_edges() - min(renderedEdges, (unsigned long)graph->get_num_edges());
+			if (!edgeBacklog && graph->previewnodes->get_numVerts() >= graph->get_num_nodes() &&
+				!graph->previewNeedsResize)
+				continue;
 
-			if (die) break;
-			Sleep(innerDelay);
-			++graphlistIt;
+			if (graph->previewVisible)
+				visibleBacklogs.push_back(make_pair(graph, edgeBacklog));
+			else
+				hiddenBacklogs.push_back(make_pair(graph, edgeBacklog));
 		}
 		graphlist.clear();
 
+		//graphs in view in the preview pane get first claim on the budget
+		unsigned long budget = PREVIEW_EDGES_PER_TICK;
+		render_share(&visibleBacklogs, &budget);
+		render_share(&hiddenBacklogs, &budget);
+		visibleBacklogs.clear();
+		hiddenBacklogs.clear();
+
 		int waitForNextIt = 0;
 		while (waitForNextIt < outerDelay && !die)
 		{
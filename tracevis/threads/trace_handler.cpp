@@ -74,7 +74,8 @@ bool thread_trace_handler::set_target_instruction(INS_DATA *instruction)
 }
 
 //creates a node for a newly excecuted instruction
-void thread_trace_handler::handle_new_instruction(INS_DATA *instruction, BLOCK_IDENTIFIER blockID, unsigned long repeats)
+//entryAddress is where execution arrived, the instruction itself unless it stands for a whole block
+void thread_trace_handler::handle_new_instruction(INS_DATA *instruction, BLOCK_IDENTIFIER blockID, unsigned long repeats, MEM_ADDRESS entryAddress)
 {
 
 	node_data thisnode;
@@ -104,7 +105,7 @@ void thread_trace_handler::handle_new_instruction(INS_DATA *instruction, BLOCK_I
 			afterReturn = false;
 		}
 		//place vert on sphere based on how we got here
-		positionVert(&a, &b, &bMod, thisnode.ins->address);
+		positionVert(&a, &b, &bMod, entryAddress);
 
 	}
 
@@ -126,13 +127,117 @@ void thread_trace_handler::handle_new_instruction(INS_DATA *instruction, BLOCK_I
 		assert(0);
 	thisgraph->insert_node(targVertID, thisnode);
 
+	//block nodes map their instructions in run_block_node, without taking any from overlapping blocks
+	if (blockMode) return;
 	piddata->getDisassemblyWriteLock();
 	instruction->threadvertIdx[TID] = targVertID;
 	piddata->dropDisassemblyWriteLock();
 }
 
+//class of an edge into the start of a block, from how the previous block ended
+char thread_trace_handler::block_entry_class(bool alreadyExecuted)
+{
+	if (lastRIPType == RETURN)
+		return IRET;
+	if (lastRIPType == EXCEPTION_GENERATOR)
+		return IEXCEPT;
+	if (alreadyExecuted)
+		return IOLD;
+	if (lastRIPType == CALL)
+		return ICALL;
+	return INEW;
+}
+
+//block mode: one node for the whole block, found by the block's address and ID
+void thread_trace_handler::run_block_node(TAG *tag, unsigned int numInstructions, unsigned long repeats, bool faulted)
+{
+	INSLIST *block = getDisassemblyBlock(tag->blockaddr, tag->blockID, piddata, &die);
+	if (!block || !numInstructions) return;
+	INS_DATA *lastIns = block->at(numInstructions - 1);
+
+	bool alreadyExecuted = thisgraph->find_block_node(tag->blockaddr, tag->blockID, &targVertID);
+	if (!alreadyExecuted)
+	{
+		//the last instruction decides where the block goes, so it represents the block
+		handle_new_instruction(lastIns, tag->blockID, repeats, tag->blockaddr);
+		thisgraph->get_node(targVertID)->blockAddress = tag->blockaddr;
+		thisgraph->add_block_node(tag->blockaddr, tag->blockID, targVertID);
+	}
+	else
+		thisgraph->get_node(targVertID)->executionCount += repeats;
+
+	//grows if the block was first seen cut short by an exception
+	unsigned int mappedIns = thisgraph->get_node(targVertID)->blockInsCount;
+	if (thisgraph->extend_block_node(targVertID, block, numInstructions))
+	{
+		//address lookups of its instructions find this node, unless an earlier block has them
+		piddata->getDisassemblyWriteLock();
+		for (unsigned int blockIdx = mappedIns; blockIdx < numInstructions; ++blockIdx)
+			block->at(blockIdx)->threadvertIdx.emplace(TID, targVertID);
+		piddata->dropDisassemblyWriteLock();
+	}
+
+	if (loopState == BUILDING_LOOP)
+	{
+		firstLoopVert = targVertID;
+		loopState = LOOP_PROGRESS;
+	}
+
+	NODEPAIR edgeIDPair = make_pair(lastVertID, targVertID);
+	edge_data *oldEdge;
+	if (thisgraph->edge_exists(edgeIDPair, &oldEdge))
+	{
+		oldEdge->executionCount += repeats;
+		edge_count_changed(edgeIDPair, oldEdge);
+	}
+	else if (lastRIPType != FIRST_IN_THREAD)
+	{
+		edge_data newEdge;
+		newEdge.chainedWeight = 0;
+		newEdge.executionCount = repeats;
+		newEdge.edgeClass = block_entry_class(alreadyExecuted);
+		thisgraph->add_edge(newEdge, thisgraph->get_node(lastVertID), thisgraph->get_node(targVertID));
+	}
+
+	if (faulted)
+	{
+		lastRIPType = EXCEPTION_GENERATOR;
+		obtainMutex(thisgraph->highlightsMutex, 4532);
+		thisgraph->exceptionSet.insert(thisgraph->exceptionSet.end(), targVertID);
+		dropMutex(thisgraph->highlightsMutex);
+	}
+	else
+		switch (lastIns->itype)
+		{
+			case OPCALL:
+				lastRIPType = CALL;
+				callStack.push_back(make_pair(lastIns->address + lastIns->numbytes, targVertID));
+				break;
+
+			case OPJMP:
+				lastRIPType = JUMP;
+				break;
+
+			case OPRET:
+				lastRIPType = RETURN;
+				break;
+
+			default:
+				lastRIPType = NONFLOW;
+				break;
+		}
+
+	lastVertID = targVertID;
+}
+
 void thread_trace_handler::runBB(TAG *tag, int startIndex, int repeats = 1)
 {
+	if (blockMode)
+	{
+		run_block_node(tag, tag->insCount, repeats, false);
+		return;
+	}
+
 	int numInstructions = tag->insCount;
 	INSLIST *block = getDisassemblyBlock(tag->blockaddr, tag->blockID, piddata, &die);
 
@@ -151,7 +256,7 @@ void thread_trace_handler::runBB(TAG *tag, int startIndex, int repeats = 1)
 		//target vert already on this threads graph?
 		bool alreadyExecuted = set_target_instruction(instruction);
 		if (!alreadyExecuted)
-			handle_new_instruction(instruction, tag->blockID, repeats);
+			handle_new_instruction(instruction, tag->blockID, repeats, instruction->address);
 		else
 			thisgraph->get_node(targVertID)->executionCount += repeats;
 
@@ -165,32 +270,23 @@ void thread_trace_handler::runBB(TAG *tag, int startIndex, int repeats = 1)
 		edge_data *oldEdge;
 
 		//only need to do this for bb index 0
-		if (!thisgraph->edge_exists(edgeIDPair, &oldEdge))
+		if (thisgraph->edge_exists(edgeIDPair, &oldEdge))
+		{
+			oldEdge->executionCount += repeats;
+			edge_count_changed(edgeIDPair, oldEdge);
+		}
+		else
 		{
 			if (lastRIPType != FIRST_IN_THREAD)
 			{
 				edge_data newEdge;
 				newEdge.chainedWeight = 0;
+				newEdge.executionCount = repeats;
 
 				if (instructionIndex > 0)
 					newEdge.edgeClass = alreadyExecuted ? IOLD : INEW;
 				else
-				{
-					if (lastRIPType == RETURN)
-						newEdge.edgeClass = IRET;
-					else
-						if (lastRIPType == EXCEPTION_GENERATOR)
-							newEdge.edgeClass = IEXCEPT;
-						else
-							if (alreadyExecuted)
-								newEdge.edgeClass = IOLD;
-							else
-								if (lastRIPType == CALL)
-									newEdge.edgeClass = ICALL;
-								else
-									newEdge.edgeClass = INEW;
-
-				}
+					newEdge.edgeClass = block_entry_class(alreadyExecuted);
 				thisgraph->add_edge(newEdge, thisgraph->get_node(lastVertID), thisgraph->get_node(targVertID));
 			}
 		}
@@ -225,6 +321,13 @@ void thread_trace_handler::runBB(TAG *tag, int startIndex, int repeats = 1)
 
 void thread_trace_handler::run_faulting_BB(TAG *tag)
 {
+	//the faulting instruction is included
+	if (blockMode)
+	{
+		run_block_node(tag, tag->insCount + 1, 1, true);
+		return;
+	}
+
 	INSLIST *block = getDisassemblyBlock(tag->blockaddr, tag->blockID, piddata, &die);
 	if (!block) return; //terminate during wait
 	for (unsigned int instructionIndex = 0; instructionIndex <= tag->insCount; ++instructionIndex)
@@ -242,38 +345,30 @@ void thread_trace_handler::run_faulting_BB(TAG *tag)
 		//target vert already on this threads graph?
 		bool alreadyExecuted = set_target_instruction(instruction);
 		if (!alreadyExecuted)
-			handle_new_instruction(instruction, tag->blockID, 1);
+			handle_new_instruction(instruction, tag->blockID, 1, instruction->address);
 		else
 			++thisgraph->get_node(targVertID)->executionCount;
 
 		MEM_ADDRESS nextAddress = instruction->address + instruction->numbytes;
 		NODEPAIR edgeIDPair = make_pair(lastVertID, targVertID);
 
-		if (!thisgraph->edge_exists(edgeIDPair, 0))
+		edge_data *oldEdge;
+		if (thisgraph->edge_exists(edgeIDPair, &oldEdge))
+		{
+			++oldEdge->executionCount;
+			edge_count_changed(edgeIDPair, oldEdge);
+		}
+		else
 			if (lastRIPType != FIRST_IN_THREAD)
 			{
 				edge_data newEdge;
 				newEdge.chainedWeight = 0;
+				newEdge.executionCount = 1;
 
 				if (instructionIndex > 0)
 					newEdge.edgeClass = alreadyExecuted ? IOLD : INEW;
 				else
-				{
-					if (lastRIPType == RETURN)
-						newEdge.edgeClass = IRET;
-					else
-						if (lastRIPType == EXCEPTION_GENERATOR)
-							newEdge.edgeClass = IEXCEPT;
-						else
-							if (alreadyExecuted)
-								newEdge.edgeClass = IOLD;
-							else
-								if (lastRIPType == CALL)
-									newEdge.edgeClass = ICALL;
-								else
-									newEdge.edgeClass = INEW;
-
-				}
+					newEdge.edgeClass = block_entry_class(alreadyExecuted);
 				thisgraph->add_edge(newEdge, thisgraph->get_node(lastVertID), thisgraph->get_node(targVertID));
 			}
 
@@ -328,6 +423,7 @@ void thread_trace_handler::positionVert(int *pa, int *pb, int *pbMod, MEM_ADDRES
 		{
 			//conditional jumps are assume non-flow control until their target is seen
 			//if it's taken then fall through to jump
+			//address is where the new node is entered, the start of its block in block mode
 			node_data *lastNode = thisgraph->get_node(lastVertID);
 			if (!lastNode->conditional || address != lastNode->ins->condTakenAddress)
 			{
@@ -469,11 +565,11 @@ void thread_trace_handler::handle_arg(char * entry, size_t entrySize) {
 	if (entry < entry + entrySize)
 	{
 		contents = string(entry).substr(0, entrySize - (size_t)entry);
-		if (b64Marker == ARG_BASE64)
-			contents = base64_decode(contents);
+		//left encoded until something displays it
+		contents.insert(contents.begin(), (b64Marker == ARG_BASE64) ? ARG_BASE64 : ARG_NOTB64);
 	}
 	else
-		contents = string("NULL");
+		contents = string(1, ARG_NOTB64) + "NULL";
 
 	pendingArgs.push_back(make_pair(argpos, contents));
 	if (!callDone) return;
@@ -537,6 +633,13 @@ bool thread_trace_handler::run_external(MEM_ADDRESS targaddr, unsigned long repe
 			node_data *targNode = thisgraph->get_node(targVertID);
 			targNode->executionCount += repeats;
 			targNode->calls += repeats;
+			NODEPAIR callPair = make_pair(lastVertID, targVertID);
+			edge_data *callEdge = thisgraph->get_edge(callPair);
+			if (callEdge)
+			{
+				callEdge->executionCount += repeats;
+				edge_count_changed(callPair, callEdge);
+			}
 			lastVertID = targVertID;
 			return true;
 		}
@@ -573,7 +676,8 @@ bool thread_trace_handler::run_external(MEM_ADDRESS targaddr, unsigned long repe
 	newTargNode.address = targaddr;
 	newTargNode.index = targVertID;
 	newTargNode.parentIdx = lastVertID;
-	newTargNode.executionCount = 1;
+	//a call made from inside a loop runs once per iteration, like the edge to it
+	newTargNode.executionCount = repeats;
 
 	thisgraph->insert_node(targVertID, newTargNode); //this invalidates lastnode
 	lastNode = &newTargNode;
@@ -585,6 +689,7 @@ bool thread_trace_handler::run_external(MEM_ADDRESS targaddr, unsigned long repe
 
 	edge_data newEdge;
 	newEdge.chainedWeight = 0;
+	newEdge.executionCount = repeats;
 	newEdge.edgeClass = ILIB;
 	thisgraph->add_edge(newEdge, thisgraph->get_node(lastVertID), thisgraph->get_node(targVertID));
 	lastRIPType = EXTERNAL;
@@ -694,14 +799,11 @@ void thread_trace_handler::handle_exception_tag(TAG *thistag)
 		if (!basicMode)
 		{
 			//store for animation and replay
-			obtainMutex(thisgraph->animationListsMutex, 1049);
-			thisgraph->bbsequence.push_back(make_pair(thistag->blockaddr, thistag->insCount));
-			thisgraph->mutationSequence.push_back(thistag->blockID);
-			dropMutex(thisgraph->animationListsMutex);
+			thisgraph->blockSequence->add_block(sequence_handle(thistag));
+			thisgraph->replayIndex.add_entry(thistag->insCount, 0, 1, lastVertID);
 		}
 
 		thisgraph->totalInstructions += thistag->insCount;
-		thisgraph->loopStateList.push_back(make_pair(0, 0xbad));
 
 		thisgraph->set_active_node(lastVertID);
 	}
@@ -729,6 +831,17 @@ void thread_trace_handler::handle_exception_tag(TAG *thistag)
 	}
 }
 
+BLOCK_HANDLE thread_trace_handler::sequence_handle(TAG *thistag)
+{
+	SEQUENCE_BLOCK_KEY key = make_pair(make_pair(thistag->blockaddr, thistag->blockID), thistag->insCount);
+	map<SEQUENCE_BLOCK_KEY, BLOCK_HANDLE>::iterator handleIt = sequenceHandles.find(key);
+	if (handleIt != sequenceHandles.end()) return handleIt->second;
+
+	BLOCK_HANDLE handle = piddata->sequenceBlocks.get_handle(thistag->blockaddr, thistag->blockID, thistag->insCount);
+	sequenceHandles.emplace(key, handle);
+	return handle;
+}
+
 //#define VERBOSE
 void thread_trace_handler::handle_tag(TAG *thistag, unsigned long repeats = 1)
 {
@@ -747,22 +860,23 @@ void thread_trace_handler::handle_tag(TAG *thistag, unsigned long repeats = 1)
 		if (!basicMode)
 		{
 			//store for animation and replay
-			obtainMutex(thisgraph->animationListsMutex, 1049);
-			thisgraph->bbsequence.push_back(make_pair(thistag->blockaddr, thistag->insCount));
-			thisgraph->mutationSequence.push_back(thistag->blockID);
-			dropMutex(thisgraph->animationListsMutex);
+			//appends are published to readers without locking
+			if (repeats == 1)
+			{
+				thisgraph->blockSequence->add_block(sequence_handle(thistag));
+				thisgraph->replayIndex.add_entry(thistag->insCount, 0, 1, lastVertID);
+			}
+			else
+			{
+				thisgraph->blockSequence->add_loop_block(sequence_handle(thistag));
+				thisgraph->replayIndex.add_entry(thistag->insCount, thisgraph->loopCounter, loopCount, lastVertID);
+			}
 		}
 
 		if (repeats == 1)
-		{
 			thisgraph->totalInstructions += thistag->insCount;
-			thisgraph->loopStateList.push_back(make_pair(0, 0xbad));
-		}
 		else
-		{
 			thisgraph->totalInstructions += thistag->insCount*loopCount;
-			thisgraph->loopStateList.push_back(make_pair(thisgraph->loopCounter, loopCount));
-		}
 		thisgraph->set_active_node(lastVertID);
 	}
 
@@ -822,17 +936,74 @@ void thread_trace_handler::dump_loop()
 		return;
 	}
 	++thisgraph->loopCounter;
+	if (!basicMode && loopCount > 1)
+		thisgraph->blockSequence->start_loop(loopCount);
+
+	//the edge into the loop was counted loopCount times, but only the first iteration takes it
+	unsigned int entryVert = lastVertID;
+	bool entered = (lastRIPType != FIRST_IN_THREAD);
 
 	vector<TAG>::iterator tagIt;
 	//put the verts/edges on the graph
 	for (tagIt = loopCache.begin(); tagIt != loopCache.end(); ++tagIt)
 		handle_tag(&*tagIt, loopCount);
 
+	if (loopCount > 1)
+		attribute_loop_edges(entered, entryVert);
+
 	loopCache.clear();
 	loopCount = 0;
 	loopState = NO_LOOP;
 }
 
+//move the repeat executions of the loop entry edge to the edge back to the start of the loop
+void thread_trace_handler::attribute_loop_edges(bool entered, unsigned int entryVert)
+{
+	unsigned int loopStartVert;
+	if (!block_node(loopCache.front().blockaddr, loopCache.front().blockID, false, &loopStartVert)) return;
+
+	NODEPAIR entryPair = make_pair(entryVert, loopStartVert);
+	NODEPAIR backPair = make_pair(lastVertID, loopStartVert);
+	edge_data *entryEdge = entered ? thisgraph->get_edge(entryPair) : 0;
+	edge_data *backEdge = thisgraph->get_edge(backPair);
+	if (!backEdge)
+	{
+		if (entryEdge)
+		{
+			entryEdge->countUncertain = true;
+			edge_count_changed(entryPair, entryEdge);
+		}
+		return;
+	}
+
+	if (entryEdge == backEdge) return;
+
+	//a loop the thread starts in has no entry edge, the back edge still takes the repeats
+	if (entryEdge)
+	{
+		entryEdge->executionCount -= min(entryEdge->executionCount, loopCount - 1);
+		edge_count_changed(entryPair, entryEdge);
+	}
+	backEdge->executionCount += loopCount - 1;
+	edge_count_changed(backPair, backEdge);
+}
+
+//node at the start or end of a block in this thread
+bool thread_trace_handler::block_node(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID, bool blockEnd, unsigned int *nodeIdx)
+{
+	if (blockMode)
+		return thisgraph->find_block_node(blockaddr, blockID, nodeIdx);
+
+	INSLIST *block = find_block_disassembly(blockaddr, blockID);
+	if (!block) return false;
+
+	INS_DATA *ins = blockEnd ? block->back() : block->front();
+	unordered_map<PID_TID, int>::iterator vertIt = ins->threadvertIdx.find(TID);
+	if (vertIt == ins->threadvertIdx.end()) return false;
+	*nodeIdx = vertIt->second;
+	return true;
+}
+
 //todo: move this to piddata class
 INSLIST *thread_trace_handler::find_block_disassembly(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID)
 {
@@ -854,6 +1025,39 @@ INSLIST *thread_trace_handler::find_block_disassembly(MEM_ADDRESS blockaddr, BLO
 	return mutationIt->second;
 }
 
+//executions of an unchained block only belong to its exit edge if it had one target
+void thread_trace_handler::count_repeat_edge(NODEPAIR edgePair, edge_data *edge, BLOCKREPEAT *repeat)
+{
+	if (!edge) return;
+	if (repeat->singleTarget)
+		edge->executionCount += repeat->totalExecs;
+	else
+		edge->countUncertain = true;
+	edge_count_changed(edgePair, edge);
+}
+
+//queue the edge for the heatmap, published in batches to keep the lock out of the tag loop
+void thread_trace_handler::edge_count_changed(NODEPAIR edgePair, edge_data *edge)
+{
+	if (edge->heatDirty) return;
+	edge->heatDirty = true;
+	dirtyEdges.push_back(edgePair);
+	dirtyEdgePtrs.push_back(edge);
+}
+
+void thread_trace_handler::publish_dirty_edges()
+{
+	if (dirtyEdges.empty()) return;
+
+	vector<edge_data *>::iterator edgeIt = dirtyEdgePtrs.begin();
+	for (; edgeIt != dirtyEdgePtrs.end(); ++edgeIt)
+		(*edgeIt)->heatDirty = false;
+	thisgraph->mark_heat_dirty(&dirtyEdges);
+
+	dirtyEdges.clear();
+	dirtyEdgePtrs.clear();
+}
+
 //peforms non-sequence critical graph updates
 //update nodes with cached execution counts and new edges from unchained runs
 //also updates graph with delayed edge notifications
@@ -895,28 +1099,48 @@ bool thread_trace_handler::assign_blockrepeats()
 
 		if(!repeatIt->blockInslist)
 		{
-			repeatIt->blockInslist = find_block_disassembly(blockaddr, blockID);
-			if (!repeatIt->blockInslist) continue;
+			INSLIST *inslist = find_block_disassembly(blockaddr, blockID);
+			if (!inslist) continue;
 
 			//first/last vert not on drawn yet? skip until it is
-			if (repeatIt->blockInslist->front()->threadvertIdx.count(TID) == 0 || repeatIt->blockInslist->back()->threadvertIdx.count(TID) == 0) continue;
+			unsigned int firstNode, lastNode;
+			if (!block_node(blockaddr, blockID, false, &firstNode) || !block_node(blockaddr, blockID, true, &lastNode)) continue;
+			repeatIt->blockInslist = inslist;
+
+			if (blockMode)
+			{
+				n = thisgraph->get_node(lastNode);
+				n->executionCount += repeatIt->totalExecs;
+			}
 
-			//increase weight of all of its instructions
+			//increase weight of all of its instructions and the edges between them
 			INSLIST::iterator blockIt = repeatIt->blockInslist->begin();
-			for (; blockIt != repeatIt->blockInslist->end(); ++blockIt)
+			for (; !blockMode && blockIt != repeatIt->blockInslist->end(); ++blockIt)
 			{
 				INS_DATA *ins = *blockIt;
 				
+				node_data *prevNode = n;
 				n = thisgraph->get_node(ins->threadvertIdx.at(TID));
 				n->executionCount += repeatIt->totalExecs;
+				if (prevNode)
+				{
+					NODEPAIR internalPair = make_pair(prevNode->index, n->index);
+					edge_data *internalEdge = thisgraph->get_edge(internalPair);
+					if (internalEdge)
+					{
+						internalEdge->executionCount += repeatIt->totalExecs;
+						edge_count_changed(internalPair, internalEdge);
+					}
+				}
 				if (--repeatIt->insCount == 0)
 					break;
 			}
 		}
 		else
 		{
-			INS_DATA* lastIns = repeatIt->blockInslist->at(repeatIt->blockInslist->size() - 1);
-			n = thisgraph->get_node(lastIns->threadvertIdx.at(TID));
+			unsigned int lastNode;
+			if (!block_node(blockaddr, blockID, true, &lastNode)) continue;
+			n = thisgraph->get_node(lastNode);
 		}
 		
 		//create any new edges between unchained nodes
@@ -940,6 +1164,8 @@ bool thread_trace_handler::assign_blockrepeats()
 
 				if (alreadyPresent)
 				{
+					NODEPAIR calledPair = make_pair(n->index, *calledIt);
+					count_repeat_edge(calledPair, thisgraph->get_edge(calledPair), &*repeatIt);
 					targCallIt = repeatIt->targBlocks.erase(targCallIt);
 					if (targCallIt == repeatIt->targBlocks.end()) break;
 				}
@@ -947,11 +1173,10 @@ bool thread_trace_handler::assign_blockrepeats()
 				continue;
 			}
 
-			INS_DATA *firstIns = targetBlock->front();
-			if (!firstIns->threadvertIdx.count(TID)) continue;
-
-			unsigned int targNodeIdx = firstIns->threadvertIdx.at(TID);
+			unsigned int targNodeIdx;
+			if (!block_node(targCallIt->first, targCallIt->second, false, &targNodeIdx)) continue;
 			edge_data *targEdge = thisgraph->get_edge_create(n, thisgraph->get_node(targNodeIdx));
+			count_repeat_edge(make_pair(n->index, targNodeIdx), targEdge, &*repeatIt);
 
 			targCallIt = repeatIt->targBlocks.erase(targCallIt);
 			if (targCallIt == repeatIt->targBlocks.end()) break;
@@ -990,6 +1215,7 @@ void thread_trace_handler::main_loop()
 		thisgraph->traceBufferSize = reader->get_message(&msgbuf, &bytesRead);
 		if (!bytesRead) {
 			assign_blockrepeats();
+			publish_dirty_edges();
 			Sleep(5);
 			continue;
 		}
@@ -1140,9 +1366,11 @@ void thread_trace_handler::main_loop()
 				id_count = stoll(b_id_s, 0, 16);
 				sourceID = id_count >> 32;
 
-				INSLIST* lastBB = find_block_disassembly(sourceAddr, sourceID);
-				INS_DATA* lastIns = lastBB->back();
-				lastVertID = lastIns->threadvertIdx.at(TID);
+				if (!block_node(sourceAddr, sourceID, true, &lastVertID))
+				{
+					cerr << "[rgat]ERROR: Satisfy tag for unknown block 0x" << hex << sourceAddr << endl;
+					assert(0);
+				}
 
 				TAG thistag;
 				string target_ip_s = string(strtok_s(entry, ",", &entry));
@@ -1206,6 +1434,7 @@ void thread_trace_handler::main_loop()
 					newRepeat.targBlocks.push_back(make_pair(targ, (BLOCK_IDENTIFIER)blockID));
 				}
 
+				newRepeat.singleTarget = (newRepeat.targBlocks.size() == 1);
 				blockRepeatQueue.push_back(newRepeat);
 				continue;
 			}
@@ -1305,6 +1534,7 @@ void thread_trace_handler::main_loop()
 			assert(0);
 			if (next_token >= msgbuf + bytesRead) break;
 		}
+		publish_dirty_edges();
 	}
 
 	int max = 10;
@@ -1327,6 +1557,7 @@ void thread_trace_handler::main_loop()
 		}
 	}
 
+	publish_dirty_edges();
 	thisgraph->terminationFlag = true;
 	thisgraph->active = false;
 	thisgraph->finalNodeID = lastVertID;
@@ -31,7 +31,7 @@ string generate_funcArg_string(string sym, ARGLIST args)
 	int numargs = args.size();
 	for (int i = 0; i < numargs; ++i)
 	{
-		funcArgStr << args[i].first << ": " << args[i].second;
+		funcArgStr << args[i].first << ": " << stored_arg_contents(&args[i].second);
 		if (i < numargs - 1)
 			funcArgStr << ", ";
 	}
@@ -39,6 +39,14 @@ string generate_funcArg_string(string sym, ARGLIST args)
 	return funcArgStr.str();
 }
 
+string stored_arg_contents(const string *storedArg)
+{
+	if (storedArg->empty()) return "";
+	if (storedArg->at(0) == ARG_BASE64)
+		return base64_decode(storedArg->substr(1));
+	return storedArg->substr(1);
+}
+
 INSLIST* getDisassemblyBlock(MEM_ADDRESS blockaddr, BLOCK_IDENTIFIER blockID,
 	PROCESS_DATA *piddata, bool *dieFlag)
 {
@@ -142,4 +150,17 @@ int caught_stoul(string s, unsigned long *result, int base) {
 		return 0;
 	}
 	return 1;
+}
+
+int caught_stof(string s, float *result) {
+	if (s.empty()) return 0;
+
+	try {
+		*result = std::stof(s);
+	}
+	catch (std::exception const & e) {
+
+		return 0;
+	}
+	return 1;
 }
\ No newline at end of file
@@ -0,0 +1,696 @@
+/*
+Copyright 2016 Nia Catlin
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Trace slicing
+Process data is loaded with the normal loader as it is bounded by code size.
+The thread is then read in two passes over the stream: the first keeps the sequence
+window and the call lists of its callers, the walk over the window decides which
+nodes and edges were touched, the second pass picks just those out of the node and
+edge sections. Nothing proportional to the whole trace is held in memory.
+*/
+#include "stdafx.h"
+#include "trace_slicer.h"
+#include "serialise.h"
+#include "thread_graph_data.h"
+#include "traceMisc.h"
+
+typedef pair<MEM_ADDRESS, BLOCK_IDENTIFIER> BLOCK_KEY;
+
+struct SEQUENCE_ENTRY {
+	BLOCK_KEY block;
+	unsigned int insCount;
+	pair<unsigned int, unsigned long> loopState;
+};
+
+struct SLICE_STATE {
+	PID_TID TID;
+	unsigned long start;
+	unsigned long end;
+	//start of the thread's node section, for the second pass
+	streamoff threadStart = 0;
+
+	vector<SEQUENCE_ENTRY> window;
+	unsigned long totalEntries = 0;
+	//times each block was entered before the window
+	map<BLOCK_KEY, unsigned long> priorEntries;
+
+	//nodes ending a window block -> times they are entered in window
+	map<unsigned int, unsigned long> windowCallers;
+	//caller node -> calls made from it during the window
+	map<unsigned int, EDGELIST> windowCalls;
+	//extern node -> calls to it before the window, locates its args
+	map<unsigned int, unsigned long> priorExternCalls;
+
+	//old node index -> new index, and the reverse
+	map<unsigned int, unsigned int> nodeRemap;
+	vector<unsigned int> nodeOrder;
+	//indexed by new node index
+	vector<unsigned long> nodeExecs;
+	vector<unsigned long> nodeCalls;
+
+	//old index pairs in order of first traversal
+	EDGELIST edgeOrder;
+	map<NODEPAIR, char> edgeClasses;
+	map<NODEPAIR, unsigned long> edgeExecs;
+
+	set<BLOCK_KEY> touchedBlocks;
+	unsigned long totalInstructions = 0;
+	unsigned int loopCounter = 0;
+	int maxA = 0;
+	int maxB = 0;
+};
+
+//every section ends with }tag, only node entries contain a } before that
+static bool skipSection(ifstream *file, char tag)
+{
+	while (file->ignore(numeric_limits<streamsize>::max(), '}'))
+	{
+		if (file->peek() != tag) continue;
+		file->seekg(2, ios::cur);
+		return true;
+	}
+	return false;
+}
+
+//skips the rest of a thread from the end of its stats
+static bool skipThreadTail(ifstream *file, bool fromStart)
+{
+	if (fromStart)
+	{
+		const char sections[] = { 'N', 'D', 'E', 'X', 'S' };
+		for (int i = 0; i < 5; ++i)
+			if (!skipSection(file, sections[i])) return false;
+	}
+	if (!skipSection(file, 'A') || !skipSection(file, 'C')) return false;
+	if (file->peek() == 'W' && !skipSection(file, 'W')) return false;
+	if (file->peek() == 'G' && !skipSection(file, 'G')) return false;
+	if (file->peek() != '}') return false;
+	file->seekg(1, ios::cur);
+	return true;
+}
+
+static INSLIST *blockInstructions(PROCESS_DATA *piddata, BLOCK_KEY block)
+{
+	map <MEM_ADDRESS, map<BLOCK_IDENTIFIER, INSLIST *>>::iterator blockIt = piddata->blocklist.find(block.first);
+	if (blockIt == piddata->blocklist.end()) return 0;
+	map<BLOCK_IDENTIFIER, INSLIST *>::iterator blockIDIt = blockIt->second.find(block.second);
+	if (blockIDIt == blockIt->second.end()) return 0;
+	return blockIDIt->second;
+}
+
+static bool insNode(INS_DATA *ins, PID_TID TID, unsigned int *nodeIdx)
+{
+	unordered_map<PID_TID, int>::iterator vertIt = ins->threadvertIdx.find(TID);
+	if (vertIt == ins->threadvertIdx.end()) return false;
+	*nodeIdx = vertIt->second;
+	return true;
+}
+
+//node that calls any externs made by the block
+static bool blockLastNode(PROCESS_DATA *piddata, SLICE_STATE *slice, BLOCK_KEY block, unsigned int insCount, unsigned int *nodeIdx)
+{
+	INSLIST *instructions = blockInstructions(piddata, block);
+	if (!instructions || instructions->empty()) return false;
+	unsigned int lastIns = min(insCount, (unsigned int)instructions->size()) - 1;
+	return insNode(instructions->at(lastIns), slice->TID, nodeIdx);
+}
+
+static bool readSequence(ifstream *file, SLICE_STATE *slice)
+{
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'A') return false;
+
+	SEQUENCE_ENTRY entry;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}A") return true;
+		if (!caught_stoul(value_s, &entry.block.first, 10)) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &entry.insCount, 10) || !entry.insCount) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoul(value_s, &entry.block.second, 10)) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &entry.loopState.first, 10)) return false;
+		if (entry.loopState.first)
+		{
+			getline(*file, value_s, ',');
+			if (!caught_stoul(value_s, &entry.loopState.second, 10)) return false;
+		}
+		else
+			entry.loopState.second = 0xbad;
+
+		unsigned long seqIdx = slice->totalEntries++;
+		if (seqIdx < slice->start)
+			++slice->priorEntries[entry.block];
+		else if (seqIdx < slice->end)
+			slice->window.push_back(entry);
+	}
+}
+
+//extern calls are recorded per caller in order, so a caller entered k times
+//before the window made the first k calls in its list
+static bool readCallSequence(ifstream *file, PROCESS_DATA *piddata, SLICE_STATE *slice)
+{
+	map<unsigned int, unsigned long> priorCalls;
+	unsigned int nodeIdx;
+	map<BLOCK_KEY, unsigned long>::iterator priorIt = slice->priorEntries.begin();
+	for (; priorIt != slice->priorEntries.end(); ++priorIt)
+	{
+		INSLIST *instructions = blockInstructions(piddata, priorIt->first);
+		if (!instructions || instructions->empty()) continue;
+		if (!insNode(instructions->back(), slice->TID, &nodeIdx)) continue;
+		if (slice->windowCallers.count(nodeIdx))
+			priorCalls[nodeIdx] += priorIt->second;
+	}
+
+	string value_s;
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'C') return false;
+
+	unsigned int listSize;
+	NODEPAIR callPair;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}C") return true;
+		if (!caught_stoi(value_s, &nodeIdx, 10)) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &listSize, 10)) return false;
+
+		map<unsigned int, unsigned long>::iterator callerIt = slice->windowCallers.find(nodeIdx);
+		unsigned long firstCall = 0, lastCall = 0;
+		if (callerIt != slice->windowCallers.end())
+		{
+			firstCall = priorCalls[nodeIdx];
+			lastCall = firstCall + callerIt->second;
+		}
+
+		for (unsigned int i = 0; i < listSize; ++i)
+		{
+			getline(*file, value_s, ',');
+			if (!caught_stoi(value_s, &callPair.first, 10)) return false;
+			getline(*file, value_s, ',');
+			if (!caught_stoi(value_s, &callPair.second, 10)) return false;
+
+			if (i < firstCall)
+				++slice->priorExternCalls[callPair.second];
+			else if (i < lastCall)
+				slice->windowCalls[nodeIdx].push_back(callPair);
+		}
+	}
+}
+
+//first pass: process data, then the window and call lists of the target thread
+static bool readWindow(VISSTATE *clientState, ifstream *file, string saveDir, PROCESS_DATA *piddata, SLICE_STATE *slice)
+{
+	string s1, PID_s;
+	*file >> s1;
+	if (s1 != "PID") {
+		cerr << "[rgat]ERROR: Corrupt save, start = " << s1 << endl;
+		return false;
+	}
+	*file >> PID_s;
+	if (!caught_stoul(PID_s, &piddata->PID, 10)) return false;
+	file->seekg(1, ios::cur);
+
+	if (!loadProcessData(clientState, file, piddata, saveDir))
+	{
+		cerr << "[rgat]ERROR: Process data load failed" << endl;
+		return false;
+	}
+
+	char tagbuf[3];
+	string tidstring;
+	PID_TID TID;
+	while (file->peek() == 'T')
+	{
+		file->read(tagbuf, 3);
+		if (strncmp(tagbuf, "TID", 3)) break;
+		getline(*file, tidstring, '{');
+		if (!caught_stoul(tidstring, &TID, 10)) return false;
+
+		if (TID != slice->TID)
+		{
+			if (!skipThreadTail(file, true)) {
+				cerr << "[rgat]ERROR: Thread " << TID << " data corrupt" << endl; return false;
+			}
+			continue;
+		}
+
+		slice->threadStart = file->tellg();
+		const char sections[] = { 'N', 'D', 'E', 'X', 'S' };
+		for (int i = 0; i < 5; ++i)
+			if (!skipSection(file, sections[i])) return false;
+
+		if (!readSequence(file, slice)) {
+			cerr << "[rgat]ERROR: Bad sequence data in thread " << TID << endl; return false;
+		}
+		if (slice->window.empty())
+		{
+			cerr << "[rgat]ERROR: Thread " << TID << " has " << slice->totalEntries
+				<< " sequence entries, none in range [" << slice->start << "," << slice->end << ")" << endl;
+			return false;
+		}
+
+		unsigned int callerIdx;
+		vector<SEQUENCE_ENTRY>::iterator entryIt = slice->window.begin();
+		for (; entryIt != slice->window.end(); ++entryIt)
+		{
+			if (!blockLastNode(piddata, slice, entryIt->block, entryIt->insCount, &callerIdx))
+			{
+				cerr << "[rgat]ERROR: Sequence references unknown block 0x" << hex << entryIt->block.first << dec << endl;
+				return false;
+			}
+			++slice->windowCallers[callerIdx];
+		}
+
+		if (!readCallSequence(file, piddata, slice)) {
+			cerr << "[rgat]ERROR: Bad call sequence in thread " << TID << endl; return false;
+		}
+		return true;
+	}
+
+	cerr << "[rgat]ERROR: Thread " << slice->TID << " not found in save" << endl;
+	return false;
+}
+
+static void touchNode(SLICE_STATE *slice, unsigned int oldIdx, unsigned long execs)
+{
+	map<unsigned int, unsigned int>::iterator remapIt = slice->nodeRemap.find(oldIdx);
+	if (remapIt == slice->nodeRemap.end())
+	{
+		remapIt = slice->nodeRemap.emplace(oldIdx, slice->nodeOrder.size()).first;
+		slice->nodeOrder.push_back(oldIdx);
+		slice->nodeExecs.push_back(0);
+		slice->nodeCalls.push_back(0);
+	}
+	slice->nodeExecs.at(remapIt->second) += execs;
+}
+
+static void touchEdge(SLICE_STATE *slice, unsigned int source, unsigned int target, unsigned long execs)
+{
+	NODEPAIR edge = make_pair(source, target);
+	if (slice->edgeClasses.emplace(edge, 0).second)
+		slice->edgeOrder.push_back(edge);
+	slice->edgeExecs[edge] += execs;
+}
+
+//replays the window to find the nodes and edges it executes
+//edges are candidates until the second pass confirms they exist in the graph
+static bool walkWindow(PROCESS_DATA *piddata, SLICE_STATE *slice)
+{
+	map<unsigned int, unsigned long> callCursor;
+	unsigned int lastNode = 0, loopHead = 0;
+	unsigned int currentLoop = 0;
+	unsigned long loopIterations = 0;
+	bool haveLast = false;
+	set<unsigned int> loopIDs;
+
+	vector<SEQUENCE_ENTRY>::iterator entryIt = slice->window.begin();
+	for (; entryIt != slice->window.end(); ++entryIt)
+	{
+		INSLIST *instructions = blockInstructions(piddata, entryIt->block);
+		unsigned int insCount = min(entryIt->insCount, (unsigned int)instructions->size());
+		unsigned long repeats = entryIt->loopState.first ? entryIt->loopState.second : 1;
+
+		//leaving a loop, last block jumped back to the first each iteration
+		if (currentLoop && entryIt->loopState.first != currentLoop)
+		{
+			touchEdge(slice, lastNode, loopHead, loopIterations - 1);
+			currentLoop = 0;
+		}
+
+		for (unsigned int i = 0; i < insCount; ++i)
+		{
+			unsigned int nodeIdx;
+			if (!insNode(instructions->at(i), slice->TID, &nodeIdx)) return false;
+			//rest of a block node
+			if (i && haveLast && nodeIdx == lastNode) continue;
+			touchNode(slice, nodeIdx, repeats);
+
+			//only the first iteration enters the loop, the rest come round the back edge
+			unsigned long edgeExecs = repeats;
+			if (!i && entryIt->loopState.first && entryIt->loopState.first != currentLoop)
+			{
+				currentLoop = entryIt->loopState.first;
+				loopIterations = repeats;
+				loopHead = nodeIdx;
+				loopIDs.insert(currentLoop);
+				edgeExecs = 1;
+			}
+
+			if (haveLast) touchEdge(slice, lastNode, nodeIdx, edgeExecs);
+			lastNode = nodeIdx;
+			haveLast = true;
+		}
+
+		map<unsigned int, EDGELIST>::iterator callsIt = slice->windowCalls.find(lastNode);
+		if (callsIt != slice->windowCalls.end())
+		{
+			unsigned long *cursor = &callCursor[lastNode];
+			if (*cursor < callsIt->second.size())
+			{
+				unsigned int externIdx = callsIt->second.at((*cursor)++).second;
+				touchNode(slice, externIdx, repeats);
+				slice->nodeCalls.at(slice->nodeRemap.at(externIdx)) += 1;
+				touchEdge(slice, lastNode, externIdx, repeats);
+				lastNode = externIdx;
+			}
+		}
+
+		slice->touchedBlocks.insert(entryIt->block);
+		slice->totalInstructions += insCount * repeats;
+	}
+	if (currentLoop)
+		touchEdge(slice, lastNode, loopHead, loopIterations - 1);
+
+	slice->loopCounter = loopIDs.size();
+	return true;
+}
+
+//second pass: pick the touched nodes, edges and exceptions out of the thread
+static bool readGraph(ifstream *file, PROCESS_DATA *piddata, SLICE_STATE *slice,
+	vector<node_data> *nodes, set<unsigned int> *exceptions)
+{
+	file->clear();
+	file->seekg(slice->threadStart);
+	if (!verifyTag(file, tag_START, 'N')) return false;
+
+	nodes->resize(slice->nodeOrder.size());
+	unsigned long nodesFound = 0;
+	while (true)
+	{
+		node_data n;
+		int result = n.unserialise(file, &piddata->disassembly);
+		if (result < 0) return false;
+		if (result == 0) break;
+
+		map<unsigned int, unsigned int>::iterator remapIt = slice->nodeRemap.find(n.index);
+		if (remapIt != slice->nodeRemap.end())
+		{
+			nodes->at(remapIt->second) = n;
+			++nodesFound;
+		}
+	}
+	if (nodesFound != nodes->size()) return false;
+
+	//node loader consumes the D tag
+	string value_s;
+	NODEPAIR edge;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}D") break;
+		if (!caught_stoi(value_s, &edge.first, 10)) return false;
+		getline(*file, value_s, ',');
+		if (!caught_stoi(value_s, &edge.second, 10)) return false;
+		getline(*file, value_s, '@');
+
+		map<NODEPAIR, char>::iterator edgeIt = slice->edgeClasses.find(edge);
+		if (edgeIt != slice->edgeClasses.end())
+			edgeIt->second = value_s.c_str()[0] + 1;
+	}
+
+	if (!skipSection(file, 'E')) return false;
+
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'X') return false;
+	unsigned int exceptionIdx;
+	while (true)
+	{
+		getline(*file, value_s, ',');
+		if (value_s == "}X") break;
+		if (!caught_stoi(value_s, &exceptionIdx, 10)) return false;
+		map<unsigned int, unsigned int>::iterator remapIt = slice->nodeRemap.find(exceptionIdx);
+		if (remapIt != slice->nodeRemap.end())
+			exceptions->insert(remapIt->second);
+	}
+
+	getline(*file, value_s, '{');
+	if (value_s.c_str()[0] != 'S') return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &slice->maxA, 10)) return false;
+	getline(*file, value_s, ',');
+	if (!caught_stoi(value_s, &slice->maxB, 10)) return false;
+	return skipSection(file, 'S');
+}
+
+//copies every mutation at the addresses of touched blocks so mutation indexes stay valid
+static void sliceProcessData(PROCESS_DATA *piddata, SLICE_STATE *slice, PROCESS_DATA *slicedpid,
+	map<INS_DATA *, INS_DATA *> *insCopies)
+{
+	slicedpid->PID = piddata->PID;
+	slicedpid->modpaths = piddata->modpaths;
+	slicedpid->modBounds = piddata->modBounds;
+	slicedpid->modsymsPlain = piddata->modsymsPlain;
+
+	set<BLOCK_KEY>::iterator blockIt = slice->touchedBlocks.begin();
+	for (; blockIt != slice->touchedBlocks.end(); ++blockIt)
+	{
+		INSLIST *instructions = blockInstructions(piddata, *blockIt);
+		INSLIST *blockCopy = new INSLIST;
+		INSLIST::iterator insIt = instructions->begin();
+		for (; insIt != instructions->end(); ++insIt)
+		{
+			MEM_ADDRESS address = (*insIt)->address;
+			if (!slicedpid->disassembly.count(address))
+			{
+				INSLIST *mutations = &piddata->disassembly.at(address);
+				INSLIST mutationCopies;
+				for (unsigned int midx = 0; midx < mutations->size(); ++midx)
+				{
+					INS_DATA *insCopy = new INS_DATA(*mutations->at(midx));
+					insCopy->threadvertIdx.clear();
+					insCopy->mutationIndex = midx;
+					insCopies->emplace(mutations->at(midx), insCopy);
+					mutationCopies.push_back(insCopy);
+				}
+				slicedpid->disassembly.emplace(address, mutationCopies);
+			}
+			blockCopy->push_back(insCopies->at(*insIt));
+		}
+		slicedpid->blocklist[blockIt->first][blockIt->second] = blockCopy;
+	}
+}
+
+static void buildGraph(SLICE_STATE *slice, vector<node_data> *nodes, set<unsigned int> *exceptions,
+	map<INS_DATA *, INS_DATA *> *insCopies, thread_graph_data *graph)
+{
+	for (unsigned int newIdx = 0; newIdx < nodes->size(); ++newIdx)
+	{
+		node_data n = nodes->at(newIdx);
+		n.index = newIdx;
+		n.executionCount = slice->nodeExecs.at(newIdx);
+		n.incomingNeighbours.clear();
+		n.outgoingNeighbours.clear();
+		n.childexterns = 0;
+
+		if (!n.external)
+		{
+			n.ins = insCopies->at(n.ins);
+			//taken/fallthrough is re-derived from the window's edges
+			n.conditional = n.ins->conditional;
+			if (!n.blockInsCount)
+				n.ins->threadvertIdx[slice->TID] = newIdx;
+			else
+			{
+				//an earlier overlapping block keeps the last instruction, as in the live graph
+				n.ins->threadvertIdx.emplace(slice->TID, newIdx);
+				graph->blockNodes = true;
+				graph->add_block_node(n.blockAddress, n.mutation, newIdx);
+			}
+		}
+		else
+		{
+			unsigned long firstCall = slice->priorExternCalls[slice->nodeOrder.at(newIdx)];
+			unsigned long numCalls = slice->nodeCalls.at(newIdx);
+			n.calls = numCalls;
+			if (firstCall >= n.funcargs.size())
+				n.funcargs.clear();
+			else
+			{
+				vector<ARGLIST>::iterator argsEnd = n.funcargs.begin() + min(firstCall + numCalls, (unsigned long)n.funcargs.size());
+				n.funcargs = vector<ARGLIST>(n.funcargs.begin() + firstCall, argsEnd);
+			}
+			graph->externList.push_back(newIdx);
+		}
+		graph->insert_node(newIdx, n);
+	}
+
+	EDGELIST::iterator edgeIt = slice->edgeOrder.begin();
+	for (; edgeIt != slice->edgeOrder.end(); ++edgeIt)
+	{
+		//walked but never drawn (eg: overlapping blocks), not a real edge
+		char edgeClass = slice->edgeClasses.at(*edgeIt);
+		if (!edgeClass) continue;
+
+		edge_data e;
+		e.edgeClass = edgeClass - 1;
+		e.executionCount = slice->edgeExecs.at(*edgeIt);
+		node_data *source = graph->locked_get_node(slice->nodeRemap.at(edgeIt->first));
+		node_data *target = graph->locked_get_node(slice->nodeRemap.at(edgeIt->second));
+		if (target->external)
+			source->childexterns += 1;
+		graph->add_edge(e, source, target);
+	}
+
+	graph->exceptionSet = *exceptions;
+
+	map<unsigned int, EDGELIST>::iterator callsIt = slice->windowCalls.begin();
+	for (; callsIt != slice->windowCalls.end(); ++callsIt)
+	{
+		EDGELIST *callList = &graph->externCallSequence[slice->nodeRemap.at(callsIt->first)];
+		EDGELIST::iterator callIt = callsIt->second.begin();
+		for (; callIt != callsIt->second.end(); ++callIt)
+			callList->push_back(make_pair(slice->nodeRemap.at(callIt->first), slice->nodeRemap.at(callIt->second)));
+	}
+
+	//each change of loop id starts a new run of a loop
+	unsigned int lastLoopID = 0;
+	vector<SEQUENCE_ENTRY>::iterator entryIt = slice->window.begin();
+	for (; entryIt != slice->window.end(); ++entryIt)
+	{
+		BLOCK_HANDLE handle = graph->get_piddata()->sequenceBlocks.get_handle(entryIt->block.first, entryIt->block.second, entryIt->insCount);
+		unsigned int loopID = entryIt->loopState.first;
+		if (loopID)
+		{
+			if (loopID != lastLoopID)
+				graph->blockSequence->start_loop(entryIt->loopState.second);
+			graph->blockSequence->add_loop_block(handle);
+		}
+		else
+			graph->blockSequence->add_block(handle);
+		lastLoopID = loopID;
+	}
+
+	graph->totalInstructions = slice->totalInstructions;
+	graph->loopCounter = slice->loopCounter;
+	graph->maxA = slice->maxA;
+	graph->maxB = slice->maxB;
+}
+
+static void freeInstructions(PROCESS_DATA *piddata)
+{
+	map <MEM_ADDRESS, map<BLOCK_IDENTIFIER, INSLIST *>>::iterator blockIt = piddata->blocklist.begin();
+	for (; blockIt != piddata->blocklist.end(); ++blockIt)
+	{
+		map<BLOCK_IDENTIFIER, INSLIST *>::iterator blockIDIt = blockIt->second.begin();
+		for (; blockIDIt != blockIt->second.end(); ++blockIDIt)
+			delete blockIDIt->second;
+	}
+	piddata->blocklist.clear();
+
+	map <MEM_ADDRESS, INSLIST>::iterator disasIt = piddata->disassembly.begin();
+	for (; disasIt != piddata->disassembly.end(); ++disasIt)
+	{
+		INSLIST::iterator mutationIt = disasIt->second.begin();
+		for (; mutationIt != disasIt->second.end(); ++mutationIt)
+			delete *mutationIt;
+	}
+	piddata->disassembly.clear();
+}
+
+string slice_path(string savefile, PID_TID TID, unsigned long start, unsigned long end)
+{
+	string base = savefile;
+	if (base.size() > 5 && base.substr(base.size() - 5) == ".rgat")
+		base.resize(base.size() - 5);
+
+	stringstream slicepath;
+	slicepath << base << "-" << TID << "-" << start << "-" << end << ".rgat";
+	return slicepath.str();
+}
+
+bool slice_trace(VISSTATE *clientState, string savefile, PID_TID TID, unsigned long start, unsigned long end, string outfile)
+{
+	if (start >= end)
+	{
+		cerr << "[rgat]ERROR: Empty slice range [" << start << "," << end << ")" << endl;
+		return false;
+	}
+
+	vector<char> readBuffer(SLICE_READ_BUFSIZE);
+	ifstream loadfile;
+	loadfile.rdbuf()->pubsetbuf(&readBuffer.at(0), readBuffer.size());
+	loadfile.open(savefile, std::ifstream::binary);
+	if (!loadfile.is_open())
+	{
+		cerr << "[rgat]ERROR: Failed to open " << savefile << endl;
+		return false;
+	}
+
+	PROCESS_DATA piddata;
+	SLICE_STATE slice;
+	slice.TID = TID;
+	slice.start = start;
+	slice.end = end;
+
+	vector<node_data> nodes;
+	set<unsigned int> exceptions;
+	bool result = readWindow(clientState, &loadfile, dirname(savefile), &piddata, &slice);
+	if (result && !walkWindow(&piddata, &slice))
+	{
+		cerr << "[rgat]ERROR: Window references instructions missing from thread " << TID << endl;
+		result = false;
+	}
+	if (result && !readGraph(&loadfile, &piddata, &slice, &nodes, &exceptions))
+	{
+		cerr << "[rgat]ERROR: Thread " << TID << " graph data corrupt" << endl;
+		result = false;
+	}
+	loadfile.close();
+
+	if (!result)
+	{
+		freeInstructions(&piddata);
+		return false;
+	}
+
+	PROCESS_DATA slicedpid;
+	map<INS_DATA *, INS_DATA *> insCopies;
+	sliceProcessData(&piddata, &slice, &slicedpid, &insCopies);
+
+	thread_graph_data *graph = new thread_graph_data(&slicedpid, TID);
+	buildGraph(&slice, &nodes, &exceptions, &insCopies, graph);
+	graph->assign_modpath(&slicedpid);
+
+	ofstream slicefile;
+	slicefile.open(outfile.c_str(), std::ofstream::binary);
+	if (!slicefile.is_open())
+	{
+		cerr << "[rgat]ERROR: Failed to open " << outfile << " for slice" << endl;
+		result = false;
+	}
+	else
+	{
+		slicefile << std::dec;
+		slicefile << "PID " << slicedpid.PID << " ";
+		saveProcessData(&slicedpid, &slicefile, dirname(outfile));
+		graph->serialise(&slicefile, false);
+		slicefile.close();
+
+		cout << "[rgat]Wrote sequence [" << start << "," << slice.start + slice.window.size() << ") of thread " << TID
+			<< " to " << outfile << ": " << graph->get_num_nodes() << " nodes, " << graph->get_num_edges() << " edges" << endl;
+	}
+
+	delete graph;
+	freeInstructions(&slicedpid);
+	freeInstructions(&piddata);
+	return result;
+}